@@ -0,0 +1,202 @@
+#include "BatchRandomStream.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+//Blocks generated per kernel call when filling whole blocks, the buffer lives on the stack which has to stay under 4 KB per frame
+static const uint32_t ChunkBlockCount = 16;
+
+//Shift is a template argument so 64 bit shifts stay inline in the 32 bit build, variable ones would need a CRT helper
+template<uint32_t Shift>
+static inline uint64_t RotateLeft(uint64_t Value)
+{
+    return (Value << Shift) | (Value >> (64 - Shift));
+}
+
+//Reference implementation, used when CPU has no SSE2
+static void GenerateBlocksScalar(uint64_t* State0, uint64_t* State1, uint64_t* Out, uint32_t BlockCount)
+{
+    for (uint32_t Block = 0; Block < BlockCount; Block++)
+    {
+        for (uint32_t Lane = 0; Lane < BatchRandomStream::LaneCount; Lane++)
+        {
+            uint64_t S0 = State0[Lane];
+            uint64_t S1 = State1[Lane];
+            Out[Block * BatchRandomStream::LaneCount + Lane] = S0 + S1;
+
+            S1 ^= S0;
+            State0[Lane] = RotateLeft<24>(S0) ^ S1 ^ (S1 << 16);
+            State1[Lane] = RotateLeft<37>(S1);
+        }
+    }
+}
+
+//Same as scalar version, 2 lanes per register
+static void GenerateBlocksSSE2(uint64_t* State0, uint64_t* State1, uint64_t* Out, uint32_t BlockCount)
+{
+    __m128i S0[4];
+    __m128i S1[4];
+    for (uint32_t Register = 0; Register < 4; Register++)
+    {
+        S0[Register] = _mm_loadu_si128((const __m128i*)(State0 + Register * 2));
+        S1[Register] = _mm_loadu_si128((const __m128i*)(State1 + Register * 2));
+    }
+
+    for (uint32_t Block = 0; Block < BlockCount; Block++)
+    {
+        for (uint32_t Register = 0; Register < 4; Register++)
+        {
+            __m128i A = S0[Register];
+            __m128i B = S1[Register];
+            _mm_storeu_si128((__m128i*)(Out + Block * BatchRandomStream::LaneCount + Register * 2), _mm_add_epi64(A, B));
+
+            B = _mm_xor_si128(B, A);
+            __m128i RotatedA = _mm_or_si128(_mm_slli_epi64(A, 24), _mm_srli_epi64(A, 40));
+            S0[Register] = _mm_xor_si128(_mm_xor_si128(RotatedA, B), _mm_slli_epi64(B, 16));
+            S1[Register] = _mm_or_si128(_mm_slli_epi64(B, 37), _mm_srli_epi64(B, 27));
+        }
+    }
+
+    for (uint32_t Register = 0; Register < 4; Register++)
+    {
+        _mm_storeu_si128((__m128i*)(State0 + Register * 2), S0[Register]);
+        _mm_storeu_si128((__m128i*)(State1 + Register * 2), S1[Register]);
+    }
+}
+
+//Same as scalar version, 4 lanes per register
+TARGET_AVX2 static void GenerateBlocksAVX2(uint64_t* State0, uint64_t* State1, uint64_t* Out, uint32_t BlockCount)
+{
+    __m256i S0Low = _mm256_loadu_si256((const __m256i*)State0);
+    __m256i S0High = _mm256_loadu_si256((const __m256i*)(State0 + 4));
+    __m256i S1Low = _mm256_loadu_si256((const __m256i*)State1);
+    __m256i S1High = _mm256_loadu_si256((const __m256i*)(State1 + 4));
+
+    for (uint32_t Block = 0; Block < BlockCount; Block++)
+    {
+        uint64_t* BlockOut = Out + Block * BatchRandomStream::LaneCount;
+        _mm256_storeu_si256((__m256i*)BlockOut, _mm256_add_epi64(S0Low, S1Low));
+        _mm256_storeu_si256((__m256i*)(BlockOut + 4), _mm256_add_epi64(S0High, S1High));
+
+        S1Low = _mm256_xor_si256(S1Low, S0Low);
+        S1High = _mm256_xor_si256(S1High, S0High);
+        S0Low = _mm256_xor_si256(_mm256_xor_si256(_mm256_or_si256(_mm256_slli_epi64(S0Low, 24), _mm256_srli_epi64(S0Low, 40)), S1Low), _mm256_slli_epi64(S1Low, 16));
+        S0High = _mm256_xor_si256(_mm256_xor_si256(_mm256_or_si256(_mm256_slli_epi64(S0High, 24), _mm256_srli_epi64(S0High, 40)), S1High), _mm256_slli_epi64(S1High, 16));
+        S1Low = _mm256_or_si256(_mm256_slli_epi64(S1Low, 37), _mm256_srli_epi64(S1Low, 27));
+        S1High = _mm256_or_si256(_mm256_slli_epi64(S1High, 37), _mm256_srli_epi64(S1High, 27));
+    }
+
+    _mm256_storeu_si256((__m256i*)State0, S0Low);
+    _mm256_storeu_si256((__m256i*)(State0 + 4), S0High);
+    _mm256_storeu_si256((__m256i*)State1, S1Low);
+    _mm256_storeu_si256((__m256i*)(State1 + 4), S1High);
+}
+
+void BatchRandomStream::Seed(uint64_t InSeed)
+{
+    RandomStream LaneStream;
+    LaneStream.Seed(InSeed);
+
+    for (uint32_t Lane = 0; Lane < LaneCount; Lane++)
+    {
+        State0[Lane] = LaneStream.State[0];
+        State1[Lane] = LaneStream.State[1];
+        LaneStream.Jump();
+    }
+
+    BlockRemaining = 0;
+}
+
+void BatchRandomStream::LongJump()
+{
+    for (uint32_t Lane = 0; Lane < LaneCount; Lane++)
+    {
+        RandomStream LaneStream;
+        LaneStream.State[0] = State0[Lane];
+        LaneStream.State[1] = State1[Lane];
+        LaneStream.LongJump();
+
+        State0[Lane] = LaneStream.State[0];
+        State1[Lane] = LaneStream.State[1];
+    }
+
+    BlockRemaining = 0;
+}
+
+void BatchRandomStream::GenerateBlocks(uint64_t* Out, uint32_t BlockCount)
+{
+    const CPUFeatures& Features = GetCPUFeatures();
+    if (Features.bHasAVX2)
+    {
+        GenerateBlocksAVX2(State0, State1, Out, BlockCount);
+    }
+    else if (Features.bHasSSE2)
+    {
+        GenerateBlocksSSE2(State0, State1, Out, BlockCount);
+    }
+    else
+    {
+        GenerateBlocksScalar(State0, State1, Out, BlockCount);
+    }
+}
+
+template<typename ConvertFunction>
+void BatchRandomStream::Fill(ConvertFunction Convert, uint32_t Count)
+{
+    uint32_t Index = 0;
+    while (Index < Count && BlockRemaining > 0)
+    {
+        Convert(Index++, Block[LaneCount - BlockRemaining--]);
+    }
+
+    uint64_t Values[ChunkBlockCount * LaneCount];
+    while (Count - Index >= LaneCount)
+    {
+        uint32_t BlockCount = (Count - Index) / LaneCount;
+        BlockCount = (BlockCount < ChunkBlockCount) ? BlockCount : ChunkBlockCount;
+        GenerateBlocks(Values, BlockCount);
+
+        for (uint32_t Value = 0; Value < BlockCount * LaneCount; Value++)
+        {
+            Convert(Index++, Values[Value]);
+        }
+    }
+
+    if (Index < Count)
+    {
+        GenerateBlocks(Block, 1);
+        BlockRemaining = LaneCount;
+
+        while (Index < Count)
+        {
+            Convert(Index++, Block[LaneCount - BlockRemaining--]);
+        }
+    }
+}
+
+void BatchRandomStream::FillFloats(float* Out, uint32_t Count)
+{
+    //Top 23 bits as mantissa of a float in [1, 2), the low bits of xoroshiro128+ are the weakest
+    Fill([Out](uint32_t Index, uint64_t Value)
+    {
+        union U { uint32_t I; float F; };
+        Out[Index] = U{ 0x3F800000u | (uint32_t)(Value >> 41) }.F - 1.0f;
+    }, Count);
+}
+
+void BatchRandomStream::FillBounded(uint32_t* Out, uint32_t Count, uint32_t Bound)
+{
+    //Top 32 bits scaled to Bound by a multiply, no division and a bias below 2^-32 * Bound
+    Fill([Out, Bound](uint32_t Index, uint64_t Value)
+    {
+        Out[Index] = (uint32_t)(((uint64_t)(uint32_t)(Value >> 32) * Bound) >> 32);
+    }, Count);
+}
+
+float BatchRandomStream::NextFloat()
+{
+    float Result;
+    FillFloats(&Result, 1);
+
+    return Result;
+}
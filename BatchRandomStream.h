@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Globals.h"
+
+//LaneCount interleaved xoroshiro128+ generators, each lane is the previous one jumped 2^64 draws ahead so lanes never overlap
+//Values are produced a block of one per lane at a time, whole arrays are filled per call by the SSE2 or AVX2 path
+//Every path produces the same sequence, so a seed gives the same values no matter how they are requested or which CPU runs it
+class BatchRandomStream
+{
+public:
+    static const uint32_t LaneCount = 8;
+
+    //Lane 0 starts where RandomStream seeded with InSeed does
+    void Seed(uint64_t InSeed);
+    //Advances all lanes by 2^96 draws, a copy jumped this way is a stream which never overlaps the original
+    void LongJump();
+
+    //Uniform floats in [0, 1)
+    void FillFloats(float* Out, uint32_t Count);
+    //Uniform integers in [0, Bound), Bound of 0 gives 0
+    void FillBounded(uint32_t* Out, uint32_t Count, uint32_t Bound);
+    float NextFloat();
+
+private:
+    //Hands out values left from the last generated block first, then whole blocks, then a new block for the rest
+    template<typename ConvertFunction>
+    void Fill(ConvertFunction Convert, uint32_t Count);
+
+    void GenerateBlocks(uint64_t* Out, uint32_t BlockCount);
+
+    uint64_t State0[LaneCount] = {};
+    uint64_t State1[LaneCount] = {};
+
+    uint64_t Block[LaneCount] = {};
+    uint32_t BlockRemaining = 0;
+};
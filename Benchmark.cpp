@@ -0,0 +1,236 @@
+#include "Benchmark.h"
+#include "Platform.h"
+
+ReportWriter::ReportWriter()
+{
+    Length = 0;
+    Capacity = 4096;
+    Text = new char[Capacity];
+}
+
+ReportWriter::~ReportWriter()
+{
+    delete[] Text;
+}
+
+void ReportWriter::Reserve(uint32_t Size)
+{
+    if (Size <= Capacity)
+    {
+        return;
+    }
+
+    while (Capacity < Size)
+    {
+        Capacity *= 2;
+    }
+
+    char* NewText = new char[Capacity];
+    memcpy(NewText, Text, Length);
+    delete[] Text;
+    Text = NewText;
+}
+
+void ReportWriter::Append(const char* InText)
+{
+    uint32_t TextLength = 0;
+    while (InText[TextLength])
+    {
+        TextLength++;
+    }
+
+    Reserve(Length + TextLength);
+    memcpy(Text + Length, InText, TextLength);
+    Length += TextLength;
+}
+
+void ReportWriter::Append(const ReportWriter& Other)
+{
+    Reserve(Length + Other.Length);
+    memcpy(Text + Length, Other.Text, Other.Length);
+    Length += Other.Length;
+}
+
+void ReportWriter::AppendUInt(uint32_t Value)
+{
+    char Digits[11];
+    uint32_t DigitCount = 0;
+
+    do
+    {
+        Digits[DigitCount++] = (char)('0' + Value % 10);
+        Value /= 10;
+    } while (Value);
+
+    Reserve(Length + DigitCount);
+    while (DigitCount)
+    {
+        Text[Length++] = Digits[--DigitCount];
+    }
+}
+
+void ReportWriter::AppendHex(uint64_t Value)
+{
+    Reserve(Length + 16);
+    for (uint32_t Digit = 0; Digit < 16; Digit++)
+    {
+        uint32_t Nibble = (uint32_t)(Value >> 60);
+        Text[Length++] = (char)((Nibble < 10) ? '0' + Nibble : 'a' + Nibble - 10);
+        Value <<= 4;
+    }
+}
+
+void ReportWriter::AppendFloat(double Value, uint32_t Decimals)
+{
+    if (Value < 0.0)
+    {
+        Append("-");
+        Value = -Value;
+    }
+
+    //Values that don't fit 32 bits are not expected in reports, clamp instead of printing garbage
+    if (Value > 4000000000.0)
+    {
+        Value = 4000000000.0;
+    }
+
+    uint32_t Scale = 1;
+    for (uint32_t Index = 0; Index < Decimals; Index++)
+    {
+        Scale *= 10;
+    }
+
+    //Conversions go through signed integers and avoid 64 bit division, which the 32 bit build has no helpers for
+    double Rounded = Value + 0.5 / Scale;
+    uint32_t IntegerPart = (uint32_t)(int64_t)Rounded;
+    uint32_t FractionPart = (uint32_t)(int64_t)((Rounded - (double)(int64_t)IntegerPart) * Scale);
+
+    AppendUInt(IntegerPart);
+    if (Decimals)
+    {
+        Append(".");
+        for (uint32_t Divisor = Scale / 10; Divisor > 0; Divisor /= 10)
+        {
+            char Digit[2] = { (char)('0' + (FractionPart / Divisor) % 10), 0 };
+            Append(Digit);
+        }
+    }
+}
+
+bool ReportWriter::WriteToFile(const char* Path) const
+{
+    return PlatformWriteFile(Path, Text, Length);
+}
+
+//memset as it was before the SIMD kernels, stores whole int32_t values so it's only comparable when filling with 0
+static void* LegacyMemset(void* Address, int32_t Value, size_t Size)
+{
+    int32_t* Temp = (int32_t*)Address;
+    while ((uint64_t)(Temp - (int32_t*)Address) < Size / sizeof(int32_t))
+    {
+        *Temp = Value;
+        Temp++;
+    }
+
+    return Address;
+}
+
+//Enough repetitions to move at least this many bytes per measurement
+static const double BenchmarkBytesPerMeasurement = 256.0 * 1024.0 * 1024.0;
+
+static void AppendMeasurement(ReportWriter& Report, const char* Kernel, uint32_t Size, double Seconds, uint32_t Repetitions, bool bIsFirst)
+{
+    double NanosecondsPerCall = Seconds * 1000000000.0 / Repetitions;
+
+    Report.Append(bIsFirst ? "\n    " : ",\n    ");
+    Report.Append("{ \"kernel\": \"");
+    Report.Append(Kernel);
+    Report.Append("\", \"size\": ");
+    Report.AppendUInt(Size);
+    Report.Append(", \"ns_per_call\": ");
+    Report.AppendFloat(NanosecondsPerCall);
+    Report.Append(", \"gb_per_s\": ");
+    Report.AppendFloat((double)Size / NanosecondsPerCall);
+    Report.Append(" }");
+}
+
+void RunMemoryBenchmark(ReportWriter& Report)
+{
+    //From a single cache line up to a 3840x2160 32 bit framebuffer
+    const uint32_t BufferSizes[] = { 256, 4 * 1024, 64 * 1024, 1024 * 1024, 8 * 1024 * 1024, 3840 * 2160 * 4 };
+    const uint32_t LargestSize = BufferSizes[sizeof(BufferSizes) / sizeof(BufferSizes[0]) - 1];
+
+    typedef void* (*MemsetFunction)(void* Address, int32_t Value, size_t Size);
+    typedef void* (*MemcpyFunction)(void* Destination, const void* Source, size_t Size);
+
+    const CPUFeatures& Features = GetCPUFeatures();
+    const char* MemsetNames[] = { "legacy", "scalar", "sse2", "avx2" };
+    MemsetFunction MemsetKernels[] = { LegacyMemset, MemsetScalar, Features.bHasSSE2 ? MemsetSSE2 : nullptr, Features.bHasAVX2 ? MemsetAVX2 : nullptr };
+    const char* MemcpyNames[] = { "scalar", "sse2", "avx2" };
+    MemcpyFunction MemcpyKernels[] = { MemcpyScalar, Features.bHasSSE2 ? MemcpySSE2 : nullptr, Features.bHasAVX2 ? MemcpyAVX2 : nullptr };
+
+    uint8_t* Destination = new uint8_t[LargestSize];
+    uint8_t* Source = new uint8_t[LargestSize];
+    memset(Source, 0x5A, LargestSize);
+
+    Report.Append("{\n  \"memset\": [");
+    bool bIsFirst = true;
+    for (uint32_t KernelIndex = 0; KernelIndex < sizeof(MemsetKernels) / sizeof(MemsetKernels[0]); KernelIndex++)
+    {
+        if (!MemsetKernels[KernelIndex])
+        {
+            continue;
+        }
+
+        for (uint32_t SizeIndex = 0; SizeIndex < sizeof(BufferSizes) / sizeof(BufferSizes[0]); SizeIndex++)
+        {
+            uint32_t Size = BufferSizes[SizeIndex];
+            uint32_t Repetitions = (uint32_t)(BenchmarkBytesPerMeasurement / Size) + 4;
+
+            //Untimed warm up call commits the pages
+            MemsetKernels[KernelIndex](Destination, 0, Size);
+
+            double StartSeconds = PlatformGetSeconds();
+            for (uint32_t Repetition = 0; Repetition < Repetitions; Repetition++)
+            {
+                MemsetKernels[KernelIndex](Destination, 0, Size);
+            }
+            double Seconds = PlatformGetSeconds() - StartSeconds;
+
+            AppendMeasurement(Report, MemsetNames[KernelIndex], Size, Seconds, Repetitions, bIsFirst);
+            bIsFirst = false;
+        }
+    }
+
+    Report.Append("\n  ],\n  \"memcpy\": [");
+    bIsFirst = true;
+    for (uint32_t KernelIndex = 0; KernelIndex < sizeof(MemcpyKernels) / sizeof(MemcpyKernels[0]); KernelIndex++)
+    {
+        if (!MemcpyKernels[KernelIndex])
+        {
+            continue;
+        }
+
+        for (uint32_t SizeIndex = 0; SizeIndex < sizeof(BufferSizes) / sizeof(BufferSizes[0]); SizeIndex++)
+        {
+            uint32_t Size = BufferSizes[SizeIndex];
+            uint32_t Repetitions = (uint32_t)(BenchmarkBytesPerMeasurement / Size) + 4;
+
+            MemcpyKernels[KernelIndex](Destination, Source, Size);
+
+            double StartSeconds = PlatformGetSeconds();
+            for (uint32_t Repetition = 0; Repetition < Repetitions; Repetition++)
+            {
+                MemcpyKernels[KernelIndex](Destination, Source, Size);
+            }
+            double Seconds = PlatformGetSeconds() - StartSeconds;
+
+            AppendMeasurement(Report, MemcpyNames[KernelIndex], Size, Seconds, Repetitions, bIsFirst);
+            bIsFirst = false;
+        }
+    }
+    Report.Append("\n  ]\n}\n");
+
+    delete[] Destination;
+    delete[] Source;
+}
\ No newline at end of file
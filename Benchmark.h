@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Globals.h"
+
+//Growable text buffer for producing reports without CRT formatting functions
+class ReportWriter
+{
+public:
+    ReportWriter();
+    ~ReportWriter();
+
+    void Append(const char* Text);
+    void Append(const ReportWriter& Other);
+    void AppendUInt(uint32_t Value);
+    void AppendFloat(double Value, uint32_t Decimals = 3);
+    //Always 16 lower case digits, so hashes line up
+    void AppendHex(uint64_t Value);
+
+    bool WriteToFile(const char* Path) const;
+
+private:
+    void Reserve(uint32_t Size);
+
+    char* Text;
+    uint32_t Length;
+    uint32_t Capacity;
+};
+
+//Times memset/memcpy kernels and the original word store loop over a range of buffer sizes, writes JSON into Report
+void RunMemoryBenchmark(ReportWriter& Report);
\ No newline at end of file
@@ -1,212 +1,1766 @@
 #include "CPURenderer.h"
+#include "StarAtlas.h"
 
-#define STAR_EXPANSION_FREQUENCY 0.1f
+#include <immintrin.h>
 
-void Star::Initialize(uint32_t WorldWidth, uint32_t WorldHeight, uint32_t InMaxSize, float InMaxLifetime)
+static constexpr StarAtlas Atlas = BuildStarAtlas();
+
+static bool AreRectsNear(const DamageRect& First, const DamageRect& Second, int32_t Distance)
+{
+    return First.Left <= Second.Right + Distance && Second.Left <= First.Right + Distance
+        && First.Top <= Second.Bottom + Distance && Second.Top <= First.Bottom + Distance;
+}
+
+static DamageRect GetRectUnion(const DamageRect& First, const DamageRect& Second)
+{
+    return {
+        (First.Left < Second.Left) ? First.Left : Second.Left,
+        (First.Top < Second.Top) ? First.Top : Second.Top,
+        (First.Right > Second.Right) ? First.Right : Second.Right,
+        (First.Bottom > Second.Bottom) ? First.Bottom : Second.Bottom,
+    };
+}
+
+static uint32_t GetRectArea(const DamageRect& Rect)
+{
+    return (uint32_t)(Rect.Right - Rect.Left) * (uint32_t)(Rect.Bottom - Rect.Top);
+}
+
+DamageList::~DamageList()
+{
+    if (Rects)
+    {
+        delete[] Rects;
+    }
+}
+
+void DamageList::ReserveRects(uint32_t Needed)
 {
-    XPos = (uint32_t)(RandomFloat() * (WorldWidth - 1));
-    YPos = (uint32_t)(RandomFloat() * (WorldHeight - 1));
-    
-    Size = (uint32_t)(RandomFloat() * (InMaxSize));
-    if (Size == 0)
+    if (Needed <= Capacity)
     {
-        Size = 1;
+        return;
     }
-    
-    bShouldProgress = RandomFloat() <= STAR_EXPANSION_FREQUENCY;
-    Shape = StarShape::Square;
 
-    MaxLifetime = RandomFloat() * InMaxLifetime;
-    //Clamp to 0.25 of InMaxLifetime at the minimum
-    if (MaxLifetime < InMaxLifetime * 0.25f)
+    if (Rects)
     {
-        MaxLifetime = InMaxLifetime * 0.25f;
+        delete[] Rects;
     }
+    Capacity = (Capacity > 0) ? Capacity : MaxMergedRects;
+    while (Capacity < Needed)
+    {
+        Capacity *= 2;
+    }
+    Rects = new DamageRect[Capacity];
+}
+
+static uint64_t LoadUnaligned64(const uint8_t* Bytes)
+{
+    uint64_t Value;
+    memcpy(&Value, Bytes, sizeof(Value));
+    return Value;
+}
+
+void DamageList::SetCells(uint8_t* InCells, uint32_t Width, uint32_t Height)
+{
+    ReserveRects(MaxMergedRects);
+    Cells = InCells;
+    CellCountX = (Width + CellSize - 1) / CellSize;
+    CellCountY = (Height + CellSize - 1) / CellSize;
+    PixelWidth = (int32_t)Width;
+    PixelHeight = (int32_t)Height;
+}
+
+uint32_t DamageList::GetCellCount(uint32_t Width, uint32_t Height)
+{
+    return ((Width + CellSize - 1) / CellSize) * ((Height + CellSize - 1) / CellSize);
+}
 
-    RemainingLifetime = MaxLifetime;
+void DamageList::FillCells(const DamageRect& Rect, uint8_t Value)
+{
+    uint32_t FirstX = (uint32_t)Rect.Left / CellSize;
+    uint32_t LastX = (uint32_t)(Rect.Right - 1) / CellSize;
+    for (uint32_t CellY = (uint32_t)Rect.Top / CellSize; CellY <= (uint32_t)(Rect.Bottom - 1) / CellSize; CellY++)
+    {
+        memset(Cells + CellY * CellCountX + FirstX, Value, LastX - FirstX + 1);
+    }
 }
 
-void Star::Tick(float DeltaTime)
+void DamageList::Add(DamageRect Rect)
 {
-    RemainingLifetime -= DeltaTime;
+    if (bCells)
+    {
+        FillCells(Rect, 1);
+        bCellsChanged = true;
+        return;
+    }
+
+    int32_t TargetIndex = -1;
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        if (AreRectsNear(Rects[Index], Rect, MergeDistance))
+        {
+            TargetIndex = (int32_t)Index;
+            break;
+        }
+    }
 
-    if (!bShouldProgress)
+    if (TargetIndex < 0)
     {
+        if (Count < MaxMergedRects)
+        {
+            Rects[Count++] = Rect;
+            return;
+        }
+
+        //List is full, what it holds moves into cells and damage is marked there from now on
+        for (uint32_t Index = 0; Index < Count; Index++)
+        {
+            FillCells(Rects[Index], 1);
+        }
+        FillCells(Rect, 1);
+        bCells = true;
+        bCellsChanged = true;
         return;
     }
 
-    float RemiainingLifetimePercent = RemainingLifetime / MaxLifetime;
-    //There probably is a better way to handle expansion thresholds, but can't think of it right now
-    if ((ExpandStage == 0 && RemiainingLifetimePercent <= 0.4f) 
-        || (ExpandStage == 1 && RemiainingLifetimePercent <= 0.3f) 
-        || (ExpandStage == 2 && RemiainingLifetimePercent <= 0.2f) 
-        || (ExpandStage == 3 && RemiainingLifetimePercent <= 0.1f) 
-        || (ExpandStage == 4 && RemiainingLifetimePercent <= 0.05f)
-    )
+    Rects[TargetIndex] = GetRectUnion(Rects[TargetIndex], Rect);
+
+    //Grown rectangle can now reach others, keep merging until the list is disjoint again
+    for (uint32_t Index = 0; Index < Count; Index++)
     {
-        ExpandStage++;
-        switch (ExpandStage)
+        if (Index != (uint32_t)TargetIndex && AreRectsNear(Rects[Index], Rects[TargetIndex], MergeDistance))
         {
-            case 1:
-            case 2:
+            Rects[TargetIndex] = GetRectUnion(Rects[TargetIndex], Rects[Index]);
+
+            Count--;
+            Rects[Index] = Rects[Count];
+            if ((uint32_t)TargetIndex == Count)
             {
-                //In case Size was 1 we need to increment the size instead of multiplying
-                if (Size == 1)
-                {
-                    Size++;
-                }
-                else
-                {
-                    Size = (uint32_t)(Size * 1.5f);
-                }
+                TargetIndex = (int32_t)Index;
+            }
+
+            Index = (uint32_t)-1;
+        }
+    }
+}
+
+bool DamageList::ResolveCells()
+{
+    //Rectangles of the previous cell row's runs are last in Rects, a run covering the same columns continues one of them
+    Count = 0;
+    uint32_t OpenStart = 0;
+    uint32_t MarkedCells = 0;
+    for (uint32_t CellY = 0; CellY < CellCountY; CellY++)
+    {
+        const uint8_t* Row = Cells + CellY * CellCountX;
+        int32_t Top = (int32_t)(CellY * CellSize);
+        int32_t Bottom = (Top + (int32_t)CellSize < PixelHeight) ? Top + (int32_t)CellSize : PixelHeight;
+        uint32_t OpenEnd = Count;
+        uint32_t Open = OpenStart;
+
+        uint32_t CellX = 0;
+        for (;;)
+        {
+            //Sky is mostly empty, unmarked cells are skipped 8 at a time
+            while (CellX + 8 <= CellCountX && LoadUnaligned64(Row + CellX) == 0)
+            {
+                CellX += 8;
+            }
+            while (CellX < CellCountX && Row[CellX] == 0)
+            {
+                CellX++;
+            }
+            if (CellX == CellCountX)
+            {
+                break;
+            }
 
-                Shape = StarShape::Circle;
-            } break;
+            uint32_t RunStart = CellX;
+            while (CellX < CellCountX && Row[CellX] != 0)
+            {
+                CellX++;
+            }
 
-            case 3:
+            if (Count == Capacity)
             {
-                Size = (uint32_t)(Size * 2.0f);
-                Shape = StarShape::Diamond;
-            } break;
+                return false;
+            }
 
-            case 4:
+            MarkedCells += CellX - RunStart;
+            int32_t Right = (int32_t)(CellX * CellSize);
+            DamageRect Rect = { (int32_t)(RunStart * CellSize), Top, (Right < PixelWidth) ? Right : PixelWidth, Bottom };
+            while (Open < OpenEnd && Rects[Open].Left < Rect.Left)
+            {
+                Open++;
+            }
+            if (Open < OpenEnd && Rects[Open].Left == Rect.Left && Rects[Open].Right == Rect.Right)
             {
-                Shape = StarShape::Square;
-            } break;
+                //Continued rectangle is emptied and dropped below
+                Rect.Top = Rects[Open].Top;
+                Rects[Open].Right = Rects[Open].Left;
+                Open++;
+            }
+            Rects[Count++] = Rect;
+        }
 
-            case 5:
+        //Rectangles of the previous row which didn't continue are done, this row's follow them
+        uint32_t Kept = OpenStart;
+        for (uint32_t Index = OpenStart; Index < OpenEnd; Index++)
+        {
+            if (Rects[Index].Right > Rects[Index].Left)
             {
-                Size = (uint32_t)(Size * 1.2f);
-                Shape = StarShape::Twinkle;
-            } break;
+                Rects[Kept++] = Rects[Index];
+            }
+        }
+        OpenStart = Kept;
+        for (uint32_t Index = OpenEnd; Index < Count; Index++)
+        {
+            Rects[Kept++] = Rects[Index];
+        }
+        Count = Kept;
+
+        //Whole buffer is cleared and presented past half of it anyway
+        if (MarkedCells > CellCountX * CellCountY / 2)
+        {
+            Rects[0] = { 0, 0, PixelWidth, PixelHeight };
+            Count = 1;
+            return true;
+        }
+    }
+
+    return true;
+}
+
+void DamageList::Resolve()
+{
+    if (!bCellsChanged)
+    {
+        return;
+    }
+    bCellsChanged = false;
+
+    //Rectangles are rebuilt from the cells, so growing doesn't copy
+    while (!ResolveCells())
+    {
+        ReserveRects(Capacity * 2);
+    }
+}
+
+void DamageList::Reset()
+{
+    //Resolved rectangles cover every marked cell, so only their cells need clearing
+    if (bCells && !bCellsChanged)
+    {
+        for (uint32_t Index = 0; Index < Count; Index++)
+        {
+            FillCells(Rects[Index], 0);
         }
     }
+    else if (bCells)
+    {
+        memset(Cells, 0, CellCountX * CellCountY);
+    }
+    bCells = false;
+    bCellsChanged = false;
+    Count = 0;
 }
 
-Color Star::GetColor() const
+void DamageList::CopyFrom(const DamageList& Other)
 {
-    float RemiainingLifetimePercent = RemainingLifetime / MaxLifetime;
+    Reset();
+    ReserveRects(Other.Count);
+    for (uint32_t Index = 0; Index < Other.Count; Index++)
+    {
+        Rects[Index] = Other.Rects[Index];
+    }
+    Count = Other.Count;
 
-    if (RemiainingLifetimePercent <= 0.0f)
+    //Rectangles built from cells go on in cells, merging them one by one would be slow and coarse
+    if (Other.bCells)
     {
-        return { 0,0,0 };
+        for (uint32_t Index = 0; Index < Count; Index++)
+        {
+            FillCells(Rects[Index], 1);
+        }
+        bCells = true;
     }
+}
 
-    if (RemiainingLifetimePercent >= 0.9f)
+uint32_t DamageList::GetArea() const
+{
+    uint32_t Result = 0;
+    for (uint32_t Index = 0; Index < Count; Index++)
     {
-        return { 155, 155, 155 };
+        Result += GetRectArea(Rects[Index]);
     }
 
-    return { 255,255,255 };
+    return Result;
+}
+
+bool CPURenderer::ClipRect(DamageRect& Rect) const
+{
+    Rect.Left = (Rect.Left > 0) ? Rect.Left : 0;
+    Rect.Top = (Rect.Top > 0) ? Rect.Top : 0;
+    Rect.Right = (Rect.Right < (int32_t)Width) ? Rect.Right : (int32_t)Width;
+    Rect.Bottom = (Rect.Bottom < (int32_t)Height) ? Rect.Bottom : (int32_t)Height;
+
+    return Rect.Left < Rect.Right && Rect.Top < Rect.Bottom;
 }
 
-void Star::Render(CPURenderer& Renderer) const
+bool CPURenderer::AddDamage(DamageRect& Rect)
 {
-    if (RemainingLifetime <= 0.0f)
+    if (!ClipRect(Rect))
     {
-        return;
+        return false;
     }
 
-    Color ColorToSet = GetColor();
-    float HalfSize = (float)Size * 0.5f;
-    float QuaterSize = HalfSize * 0.5f;
-    float EigthSize = QuaterSize * 0.5f;
-    float RadiusSquared = HalfSize * HalfSize;
+    Frames[DrawFrame].DirtyRects.Add(Rect);
+    return true;
+}
+
+static uint32_t GetPixelValue(Color ColorToSet)
+{
+    return ColorToSet.B | ColorToSet.G << 8 | ColorToSet.R << 16;
+}
 
-    for (int32_t YIndex = (int32_t)(-1.0f * HalfSize); YIndex < (int32_t)(HalfSize + 0.5f); YIndex++)
+uint8_t CPURenderer::GetPaletteIndex(Color ColorToSet)
+{
+    uint32_t PixelValue = GetPixelValue(ColorToSet);
+    for (uint32_t Index = 0; Index < PaletteCount; Index++)
     {
-        for (int32_t XIndex = (int32_t)(-1.0f * HalfSize); XIndex < (int32_t)(HalfSize + 0.5f); XIndex++)
+        if (Palette[Index] == PixelValue)
         {
-            bool bShouldRenderPixel = true;
-            switch (Shape)
-            {
-                case StarShape::Circle:
-                {
-                    bShouldRenderPixel = (YIndex * YIndex + XIndex * XIndex) <= RadiusSquared;
-                } break;
+            return (uint8_t)Index;
+        }
+    }
 
-                case StarShape::Diamond:
-                {
-                    float YIndexAbs = (float)((YIndex > 0.0f) ? YIndex : -1 * YIndex);
-                    float XIndexAbs = (float)((XIndex > 0.0f) ? XIndex : -1 * XIndex);
+    if (PaletteCount < MaxPaletteColors)
+    {
+        Palette[PaletteCount] = PixelValue;
+        return (uint8_t)PaletteCount++;
+    }
 
-                    bShouldRenderPixel = 0.0f < (-XIndexAbs + HalfSize - YIndexAbs);
-                } break;
+    uint32_t ClosestIndex = 0;
+    int32_t ClosestDistance = 0x7FFFFFFF;
+    for (uint32_t Index = 0; Index < PaletteCount; Index++)
+    {
+        int32_t DeltaB = (int32_t)(Palette[Index] & 0xFF) - ColorToSet.B;
+        int32_t DeltaG = (int32_t)((Palette[Index] >> 8) & 0xFF) - ColorToSet.G;
+        int32_t DeltaR = (int32_t)((Palette[Index] >> 16) & 0xFF) - ColorToSet.R;
+        int32_t Distance = DeltaB * DeltaB + DeltaG * DeltaG + DeltaR * DeltaR;
+        if (Distance < ClosestDistance)
+        {
+            ClosestDistance = Distance;
+            ClosestIndex = Index;
+        }
+    }
 
-                //Diamond - center + diagonals
-                case StarShape::Twinkle:
-                {
-                    float YIndexAbs = (float)((YIndex > 0.0f) ? YIndex : -1 * YIndex);
-                    float XIndexAbs = (float)((XIndex > 0.0f) ? XIndex : -1 * XIndex);
-                    bool bIsDiagonal = false;
+    return (uint8_t)ClosestIndex;
+}
 
-                    if (EigthSize >= 2.0f)
-                    {
-                        bIsDiagonal = (0.0f > (XIndexAbs - EigthSize - YIndexAbs)) && (0.0f < (XIndexAbs + EigthSize - YIndexAbs));
-                    }
-                    else
-                    {
-                        bIsDiagonal = (YIndexAbs == XIndexAbs);
-                    }
+//Palette lookup of Count indices, Palette has MaxPaletteColors entries
+static void ExpandPaletteScalar(uint32_t* Out, const uint8_t* Indices, uint32_t Count, const uint32_t* Palette)
+{
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        Out[Index] = Palette[Indices[Index]];
+    }
+}
 
-                    bool bIsOutsideOfCenter = (0.0f > (-XIndexAbs + QuaterSize - YIndexAbs));
+//8 pixels per step, each half of the palette is a register permuted by the low 3 bits of the index and bit 3 picks the half
+TARGET_AVX2 static void ExpandPaletteAVX2(uint32_t* Out, const uint8_t* Indices, uint32_t Count, const uint32_t* Palette)
+{
+    static_assert(CPURenderer::MaxPaletteColors == 16, "Expansion assumes two registers of palette");
 
-                    bShouldRenderPixel = bIsOutsideOfCenter && ((0.0f < (-XIndexAbs + HalfSize - YIndexAbs)) || bIsDiagonal);
-                } break;
-            }
+    __m256i PaletteLow = _mm256_loadu_si256((const __m256i*)Palette);
+    __m256i PaletteHigh = _mm256_loadu_si256((const __m256i*)(Palette + 8));
 
-            if (bShouldRenderPixel)
-            {
-                uint32_t YPixelPos = YPos + YIndex;
-                uint32_t XPixelPos = XPos + XIndex;
+    uint32_t Index = 0;
+    for (; Index + 8 <= Count; Index += 8)
+    {
+        __m256i Lookup = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(Indices + Index)));
+        __m256i Low = _mm256_permutevar8x32_epi32(PaletteLow, Lookup);
+        __m256i High = _mm256_permutevar8x32_epi32(PaletteHigh, Lookup);
+        __m256 Select = _mm256_castsi256_ps(_mm256_slli_epi32(Lookup, 28));
+        _mm256_storeu_si256((__m256i*)(Out + Index), _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(Low), _mm256_castsi256_ps(High), Select)));
+    }
 
-                //Bounds checking
-                if (YPixelPos >= 0 && YPixelPos < Renderer.Height && XPixelPos >= 0 && XPixelPos < Renderer.Width)
-                {
-                    uint32_t& Pixel = *(Renderer.RenderBuffer + YPixelPos * Renderer.Width + XPixelPos);
-                    Pixel = ColorToSet.B | ColorToSet.G << 8 | ColorToSet.R << 16;
-                }
-            }
+    ExpandPaletteScalar(Out + Index, Indices + Index, Count - Index, Palette);
+}
+
+//Palette lookup of Count indices, each written Scale times
+static void ExpandPaletteScaled(uint32_t* Out, const uint8_t* Indices, uint32_t Count, const uint32_t* Palette, uint32_t Scale)
+{
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        uint32_t PixelValue = Palette[Indices[Index]];
+        for (uint32_t Repeat = 0; Repeat < Scale; Repeat++)
+        {
+            *Out++ = PixelValue;
         }
     }
 }
 
-CPURenderer::CPURenderer(uint32_t InWidth, uint32_t InHeight)
+//Binomial kernel, close to a gaussian, its weights add up to 64 along each axis
+static const uint32_t GlowTapCount = CPURenderer::GlowRadius * 2 + 1;
+static const uint16_t GlowWeights[GlowTapCount] = { 1, 6, 15, 20, 15, 6, 1 };
+//Horizontal sums keep 2 fractional bits so vertical sums of 64 weights still fit 16 bits, the result is 8 bits
+static const uint32_t GlowHorizontalShift = 4;
+static const uint32_t GlowVerticalShift = 8;
+//Blurred intensity per halo level
+static const uint32_t GlowLevelShift = 4;
+static const uint32_t GlowLevelBrightness = 16;
+//Pixels per step of the SIMD kernels
+static const uint32_t GlowStep = 16;
+
+//Star intensity of Count indices, Table has MaxPaletteColors entries, returns nonzero if any star is among them
+static uint32_t GlowIntensityScalar(uint8_t* Out, const uint8_t* Indices, uint32_t Count, const uint8_t* Table)
 {
-    Width = InWidth;
-    Height = InHeight;
+    uint32_t AnyIntensity = 0;
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        Out[Index] = Table[Indices[Index]];
+        AnyIntensity |= Out[Index];
+    }
+    return AnyIntensity;
+}
 
-    Info.bmiHeader.biSize = sizeof(Info.bmiHeader);
-    Info.bmiHeader.biWidth = Width;
-    Info.bmiHeader.biHeight = -(int32_t)Height;
-    Info.bmiHeader.biPlanes = 1;
-    Info.bmiHeader.biBitCount = 32;
-    Info.bmiHeader.biCompression = BI_RGB;
+//In is padded with GlowRadius intensities on both sides of the Count blurred
+static void GlowHorizontalScalar(uint16_t* Out, const uint8_t* In, uint32_t Count)
+{
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        uint32_t Sum = 0;
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            Sum += GlowWeights[Tap] * In[Index + Tap];
+        }
+        Out[Index] = (uint16_t)(Sum >> GlowHorizontalShift);
+    }
+}
 
-    RenderBuffer = new uint32_t[Width * Height];
-    Clear();
+//Rows are the horizontally blurred rows from GlowRadius above to GlowRadius below the one finished, Out gets the palette index of every pixel's halo level
+//Returns nonzero if any pixel got a level above 0
+static uint32_t GlowVerticalScalar(uint8_t* Out, const uint16_t* const* Rows, uint32_t Count, const uint8_t* LevelIndices)
+{
+    uint32_t AnyHalo = 0;
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        uint32_t Sum = 0;
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            Sum += GlowWeights[Tap] * Rows[Tap][Index];
+        }
+
+        uint32_t Level = (Sum >> GlowVerticalShift) >> GlowLevelShift;
+        Level = (Level < CPURenderer::GlowLevelCount - 1) ? Level : CPURenderer::GlowLevelCount - 1;
+        Out[Index] = LevelIndices[Level];
+        AnyHalo |= Level;
+    }
+    return AnyHalo;
 }
 
-CPURenderer::~CPURenderer()
+//Columns halo was written to, Left is past Right while there are none
+struct GlowSpan
 {
-    delete[] RenderBuffer;
+    uint32_t Left;
+    uint32_t Right;
+};
+
+//Halo goes only where there is background, stars keep their color, returns false if none was written
+static bool GlowMergeScalar(uint8_t* Pixels, const uint8_t* Halo, uint32_t Count, GlowSpan& Written)
+{
+    bool bWritten = false;
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        if (Pixels[Index] == 0 && Halo[Index] != 0)
+        {
+            Pixels[Index] = Halo[Index];
+            Written.Left = (Index < Written.Left) ? Index : Written.Left;
+            Written.Right = (Index + 1 > Written.Right) ? Index + 1 : Written.Right;
+            bWritten = true;
+        }
+    }
+    return bWritten;
 }
 
-void CPURenderer::Clear()
+//Without a byte shuffle only runs of background, which has no intensity, are looked up at once, they are most of what's read
+static uint32_t GlowIntensitySSE2(uint8_t* Out, const uint8_t* Indices, uint32_t Count, const uint8_t* Table)
 {
-    memset(RenderBuffer, 0, Width * Height * sizeof(*RenderBuffer));
+    uint32_t AnyIntensity = 0;
+    uint32_t Index = 0;
+    for (; Index + 16 <= Count; Index += 16)
+    {
+        __m128i Values = _mm_loadu_si128((const __m128i*)(Indices + Index));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(Values, _mm_setzero_si128())) == 0xFFFF)
+        {
+            _mm_storeu_si128((__m128i*)(Out + Index), _mm_setzero_si128());
+            continue;
+        }
+        AnyIntensity |= GlowIntensityScalar(Out + Index, Indices + Index, 16, Table);
+    }
+
+    return AnyIntensity | GlowIntensityScalar(Out + Index, Indices + Index, Count - Index, Table);
 }
 
-void CPURenderer::Present(HWND WindowHandle) const
+//Sums stay below 2^16, so 16 bit multiplies and adds are exact
+static void GlowHorizontalSSE2(uint16_t* Out, const uint8_t* In, uint32_t Count)
 {
-    HDC DeviceContext = GetDC(WindowHandle);
+    uint32_t Index = 0;
+    for (; Index + 16 <= Count; Index += 16)
+    {
+        __m128i SumLow = _mm_setzero_si128();
+        __m128i SumHigh = _mm_setzero_si128();
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            __m128i Values = _mm_loadu_si128((const __m128i*)(In + Index + Tap));
+            __m128i Weight = _mm_set1_epi16((int16_t)GlowWeights[Tap]);
+            SumLow = _mm_add_epi16(SumLow, _mm_mullo_epi16(_mm_unpacklo_epi8(Values, _mm_setzero_si128()), Weight));
+            SumHigh = _mm_add_epi16(SumHigh, _mm_mullo_epi16(_mm_unpackhi_epi8(Values, _mm_setzero_si128()), Weight));
+        }
+        _mm_storeu_si128((__m128i*)(Out + Index), _mm_srli_epi16(SumLow, GlowHorizontalShift));
+        _mm_storeu_si128((__m128i*)(Out + Index + 8), _mm_srli_epi16(SumHigh, GlowHorizontalShift));
+    }
 
-    StretchDIBits(DeviceContext,
-        0, 0, Width, Height,
-        0, 0, Width, Height,
-        RenderBuffer,
-        &Info,
-        DIB_RGB_COLORS, SRCCOPY);
+    GlowHorizontalScalar(Out + Index, In + Index, Count - Index);
+}
 
-    ReleaseDC(WindowHandle, DeviceContext);
+//Levels are small enough for signed minimums, each is looked up by comparing against all of them
+static uint32_t GlowVerticalSSE2(uint8_t* Out, const uint16_t* const* Rows, uint32_t Count, const uint8_t* LevelIndices)
+{
+    __m128i MaxLevel = _mm_set1_epi16(CPURenderer::GlowLevelCount - 1);
+    __m128i AnyHalo = _mm_setzero_si128();
+
+    uint32_t Index = 0;
+    for (; Index + 16 <= Count; Index += 16)
+    {
+        __m128i SumLow = _mm_setzero_si128();
+        __m128i SumHigh = _mm_setzero_si128();
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            __m128i Weight = _mm_set1_epi16((int16_t)GlowWeights[Tap]);
+            SumLow = _mm_add_epi16(SumLow, _mm_mullo_epi16(_mm_loadu_si128((const __m128i*)(Rows[Tap] + Index)), Weight));
+            SumHigh = _mm_add_epi16(SumHigh, _mm_mullo_epi16(_mm_loadu_si128((const __m128i*)(Rows[Tap] + Index + 8)), Weight));
+        }
+
+        __m128i LevelsLow = _mm_min_epi16(_mm_srli_epi16(SumLow, GlowVerticalShift + GlowLevelShift), MaxLevel);
+        __m128i LevelsHigh = _mm_min_epi16(_mm_srli_epi16(SumHigh, GlowVerticalShift + GlowLevelShift), MaxLevel);
+        __m128i Levels = _mm_packus_epi16(LevelsLow, LevelsHigh);
+        AnyHalo = _mm_or_si128(AnyHalo, Levels);
+        __m128i Result = _mm_setzero_si128();
+        for (uint32_t Level = 1; Level < CPURenderer::GlowLevelCount; Level++)
+        {
+            __m128i IsLevel = _mm_cmpeq_epi8(Levels, _mm_set1_epi8((char)Level));
+            Result = _mm_or_si128(Result, _mm_and_si128(IsLevel, _mm_set1_epi8((char)LevelIndices[Level])));
+        }
+        _mm_storeu_si128((__m128i*)(Out + Index), Result);
+    }
+
+    uint32_t AnyTailHalo = 0;
+    if (Index < Count)
+    {
+        const uint16_t* TailRows[GlowTapCount];
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            TailRows[Tap] = Rows[Tap] + Index;
+        }
+        AnyTailHalo = GlowVerticalScalar(Out + Index, TailRows, Count - Index, LevelIndices);
+    }
+    return (uint32_t)(_mm_movemask_epi8(_mm_cmpeq_epi8(AnyHalo, _mm_setzero_si128())) != 0xFFFF) | AnyTailHalo;
+}
+
+//Count is rounded up to whole steps, pixels past it are read and written back unchanged
+static bool GlowMergeSSE2(uint8_t* Pixels, const uint8_t* Halo, uint32_t Count, GlowSpan& Written)
+{
+    __m128i Lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    bool bWritten = false;
+    for (uint32_t Index = 0; Index < Count; Index += 16)
+    {
+        uint32_t Remaining = (Count - Index < 16) ? Count - Index : 16;
+        __m128i InArea = _mm_cmpgt_epi8(_mm_set1_epi8((char)Remaining), Lanes);
+        __m128i Values = _mm_loadu_si128((const __m128i*)(Pixels + Index));
+        __m128i Background = _mm_and_si128(_mm_cmpeq_epi8(Values, _mm_setzero_si128()), InArea);
+        __m128i HaloValues = _mm_and_si128(Background, _mm_loadu_si128((const __m128i*)(Halo + Index)));
+        _mm_storeu_si128((__m128i*)(Pixels + Index), _mm_or_si128(_mm_andnot_si128(Background, Values), HaloValues));
+
+        uint32_t WrittenLanes = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(HaloValues, _mm_setzero_si128())) ^ 0xFFFF;
+        if (WrittenLanes != 0)
+        {
+            uint32_t Left = Index + FindLowestSetBit(WrittenLanes);
+            uint32_t Right = Index + FindHighestSetBit(WrittenLanes) + 1;
+            Written.Left = (Left < Written.Left) ? Left : Written.Left;
+            Written.Right = (Right > Written.Right) ? Right : Written.Right;
+            bWritten = true;
+        }
+    }
+    return bWritten;
+}
+
+//16 pixels per step, the palette fits a byte shuffle
+TARGET_AVX2 static uint32_t GlowIntensityAVX2(uint8_t* Out, const uint8_t* Indices, uint32_t Count, const uint8_t* Table)
+{
+    static_assert(CPURenderer::MaxPaletteColors == 16, "Lookup assumes a palette of one register");
+
+    __m128i Lookup = _mm_loadu_si128((const __m128i*)Table);
+    __m128i AnyIntensity = _mm_setzero_si128();
+
+    uint32_t Index = 0;
+    for (; Index + 16 <= Count; Index += 16)
+    {
+        __m128i Intensity = _mm_shuffle_epi8(Lookup, _mm_loadu_si128((const __m128i*)(Indices + Index)));
+        _mm_storeu_si128((__m128i*)(Out + Index), Intensity);
+        AnyIntensity = _mm_or_si128(AnyIntensity, Intensity);
+    }
+
+    return (uint32_t)!_mm_testz_si128(AnyIntensity, AnyIntensity) | GlowIntensityScalar(Out + Index, Indices + Index, Count - Index, Table);
+}
+
+//Sums stay below 2^16, so 16 bit multiplies and adds are exact
+TARGET_AVX2 static void GlowHorizontalAVX2(uint16_t* Out, const uint8_t* In, uint32_t Count)
+{
+    uint32_t Index = 0;
+    for (; Index + 16 <= Count; Index += 16)
+    {
+        __m256i Sum = _mm256_setzero_si256();
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            __m256i Values = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(In + Index + Tap)));
+            Sum = _mm256_add_epi16(Sum, _mm256_mullo_epi16(Values, _mm256_set1_epi16((int16_t)GlowWeights[Tap])));
+        }
+        _mm256_storeu_si256((__m256i*)(Out + Index), _mm256_srli_epi16(Sum, GlowHorizontalShift));
+    }
+
+    //Compilers don't always clear upper halves before calls, the scalar tail and the caller would pay for every SSE instruction
+    _mm256_zeroupper();
+    GlowHorizontalScalar(Out + Index, In + Index, Count - Index);
+}
+
+//LevelIndices has MaxPaletteColors entries, a byte shuffle looks up 16 levels at once
+TARGET_AVX2 static uint32_t GlowVerticalAVX2(uint8_t* Out, const uint16_t* const* Rows, uint32_t Count, const uint8_t* LevelIndices)
+{
+    static_assert(CPURenderer::GlowLevelCount <= CPURenderer::MaxPaletteColors, "Level lookup assumes a table of one register");
+
+    __m128i Lookup = _mm_loadu_si128((const __m128i*)LevelIndices);
+    __m256i MaxLevel = _mm256_set1_epi16(CPURenderer::GlowLevelCount - 1);
+    __m128i AnyHalo = _mm_setzero_si128();
+
+    uint32_t Index = 0;
+    for (; Index + 16 <= Count; Index += 16)
+    {
+        __m256i Sum = _mm256_setzero_si256();
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            __m256i Values = _mm256_loadu_si256((const __m256i*)(Rows[Tap] + Index));
+            Sum = _mm256_add_epi16(Sum, _mm256_mullo_epi16(Values, _mm256_set1_epi16((int16_t)GlowWeights[Tap])));
+        }
+
+        //Levels packed to bytes, packing works per 128 bit lane so the halves are gathered into the low lane
+        __m256i Levels = _mm256_min_epu16(_mm256_srli_epi16(Sum, GlowVerticalShift + GlowLevelShift), MaxLevel);
+        __m128i LevelBytes = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(Levels, Levels), 0x08));
+        _mm_storeu_si128((__m128i*)(Out + Index), _mm_shuffle_epi8(Lookup, LevelBytes));
+        AnyHalo = _mm_or_si128(AnyHalo, LevelBytes);
+    }
+
+    _mm256_zeroupper();
+    uint32_t AnyTailHalo = 0;
+    if (Index < Count)
+    {
+        const uint16_t* TailRows[GlowTapCount];
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            TailRows[Tap] = Rows[Tap] + Index;
+        }
+        AnyTailHalo = GlowVerticalScalar(Out + Index, TailRows, Count - Index, LevelIndices);
+    }
+    return (uint32_t)!_mm_testz_si128(AnyHalo, AnyHalo) | AnyTailHalo;
+}
+
+//Kernels of one instruction set, rows are padded to whole Steps of pixels for them
+struct GlowKernels
+{
+    uint32_t (*Intensity)(uint8_t* Out, const uint8_t* Indices, uint32_t Count, const uint8_t* Table);
+    void (*Horizontal)(uint16_t* Out, const uint8_t* In, uint32_t Count);
+    uint32_t (*Vertical)(uint8_t* Out, const uint16_t* const* Rows, uint32_t Count, const uint8_t* LevelIndices);
+    bool (*Merge)(uint8_t* Pixels, const uint8_t* Halo, uint32_t Count, GlowSpan& Written);
+    uint32_t Step;
+};
+
+static const GlowKernels GlowKernelsScalar = { GlowIntensityScalar, GlowHorizontalScalar, GlowVerticalScalar, GlowMergeScalar, 1 };
+static const GlowKernels GlowKernelsSSE2 = { GlowIntensitySSE2, GlowHorizontalSSE2, GlowVerticalSSE2, GlowMergeSSE2, GlowStep };
+static const GlowKernels GlowKernelsAVX2 = { GlowIntensityAVX2, GlowHorizontalAVX2, GlowVerticalAVX2, GlowMergeSSE2, GlowStep };
+
+template<typename Type>
+static void GrowArray(Type*& Array, uint32_t& Capacity, uint32_t Used, uint32_t Required)
+{
+    if (Required <= Capacity)
+    {
+        return;
+    }
+
+    uint32_t NewCapacity = (Capacity > 0) ? Capacity : 256;
+    while (NewCapacity < Required)
+    {
+        NewCapacity *= 2;
+    }
+
+    Type* NewArray = new Type[NewCapacity];
+    if (Array)
+    {
+        memcpy(NewArray, Array, Used * sizeof(Type));
+        delete[] Array;
+    }
+
+    Array = NewArray;
+    Capacity = NewCapacity;
+}
+
+void CPURenderer::DrawStar(uint32_t XPos, uint32_t YPos, uint32_t Size, StarShape Shape, Color ColorToSet)
+{
+    StarDrawCommand Command = { (int32_t)XPos, YPos, Size, Shape, GetPaletteIndex(ColorToSet) };
+    SubmitStar(Command);
+
+    //Copy one buffer width over draws the part cut off by the edge, halos included, on the other side
+    if (bWrapColumns)
+    {
+        int32_t GlowPadding = bGlowEnabled ? (int32_t)GlowRadius : 0;
+        if (Command.XPos + GetStarMinOffset(Size) - GlowPadding < 0)
+        {
+            Command.XPos += (int32_t)Width;
+            SubmitStar(Command);
+        }
+        else if (Command.XPos + GetStarMaxOffset(Size) + GlowPadding > (int32_t)Width)
+        {
+            Command.XPos -= (int32_t)Width;
+            SubmitStar(Command);
+        }
+    }
+}
+
+void CPURenderer::SubmitStar(const StarDrawCommand& Command)
+{
+    int32_t MinOffset = GetStarMinOffset(Command.Size);
+    int32_t MaxOffset = GetStarMaxOffset(Command.Size);
+    DamageRect Area = { Command.XPos + MinOffset, (int32_t)Command.YPos + MinOffset, Command.XPos + MaxOffset, (int32_t)Command.YPos + MaxOffset };
+    bool bVisible = AddDamage(Area);
+
+    //Halos reach up to GlowRadius past the star, ApplyGlow damages only as far as they turn out to, dim stars' fade out well before it
+    if (bGlowEnabled)
+    {
+        int32_t Radius = (int32_t)GlowRadius;
+        DamageRect GlowArea = { Command.XPos + MinOffset - Radius, (int32_t)Command.YPos + MinOffset - Radius, Command.XPos + MaxOffset + Radius, (int32_t)Command.YPos + MaxOffset + Radius };
+        if (ClipRect(GlowArea))
+        {
+            GrowArray(GlowRects, GlowRectCapacity, GlowRectCount, GlowRectCount + 1);
+            GlowRects[GlowRectCount++] = GlowArea;
+        }
+
+        if (bVisible)
+        {
+            uint64_t Bands = GetGlowBands(Area.Left, Area.Right);
+            for (int32_t Row = Area.Top; Row < Area.Bottom; Row++)
+            {
+                GlowStarBands[Row] |= Bands;
+            }
+        }
+    }
+
+    //With a worker pool stars are collected and rasterized per tile in FlushStars
+    if (RasterPool)
+    {
+        GrowArray(StarCommands, StarCommandCapacity, StarCommandCount, StarCommandCount + 1);
+        StarCommands[StarCommandCount++] = Command;
+        return;
+    }
+
+    Stats.DrawnPixels += RasterizeStar(Command, { 0, 0, (int32_t)Width, (int32_t)Height });
+}
+
+void CPURenderer::DrawStarReference(uint32_t XPos, uint32_t YPos, uint32_t Size, StarShape Shape, Color ColorToSet)
+{
+    Stats.DrawnPixels += RasterizeStarReference({ (int32_t)XPos, YPos, Size, Shape, GetPaletteIndex(ColorToSet) }, { 0, 0, (int32_t)Width, (int32_t)Height });
+}
+
+uint32_t CPURenderer::RasterizeStar(const StarDrawCommand& Command, const DamageRect& Clip) const
+{
+    uint32_t Size = Command.Size;
+    if (Size > AtlasMaxStarSize || !Atlas.Sprites[Command.Shape][Size].bIsValid)
+    {
+        return RasterizeStarReference(Command, Clip);
+    }
+
+    const StarSprite& Sprite = Atlas.Sprites[Command.Shape][Size];
+    const StarSpan* Span = Atlas.Spans + Sprite.FirstSpan;
+    const StarSpan* SpanEnd = Span + Sprite.SpanCount;
+    uint8_t PaletteIndex = Command.PaletteIndex;
+
+    //Visible offsets relative to star center
+    int32_t MinX = Clip.Left - Command.XPos;
+    int32_t MaxX = Clip.Right - Command.XPos;
+    int32_t MinY = Clip.Top - (int32_t)Command.YPos;
+    int32_t MaxY = Clip.Bottom - (int32_t)Command.YPos;
+
+    int32_t MinOffset = GetStarMinOffset(Size);
+    int32_t MaxOffset = GetStarMaxOffset(Size);
+
+    uint8_t* Center = RenderBuffer + (intptr_t)Command.YPos * Stride + Command.XPos;
+    uint32_t PixelCount = 0;
+
+    //Clipping is decided once for the whole star, most stars are fully visible and skip it
+    if (MinOffset >= MinX && MinOffset >= MinY && MaxOffset <= MaxX && MaxOffset <= MaxY)
+    {
+        for (; Span != SpanEnd; Span++)
+        {
+            uint8_t* Pixel = Center + Span->YOffset * (int32_t)Stride + Span->XOffset;
+            for (uint32_t Index = 0; Index < Span->Length; Index++)
+            {
+                Pixel[Index] = PaletteIndex;
+            }
+            PixelCount += Span->Length;
+        }
+
+        return PixelCount;
+    }
+
+    for (; Span != SpanEnd; Span++)
+    {
+        if (Span->YOffset < MinY || Span->YOffset >= MaxY)
+        {
+            continue;
+        }
+
+        int32_t SpanStart = (Span->XOffset > MinX) ? Span->XOffset : MinX;
+        int32_t SpanEnd = (Span->XOffset + Span->Length < MaxX) ? Span->XOffset + Span->Length : MaxX;
+
+        uint8_t* Row = Center + Span->YOffset * (int32_t)Stride;
+        for (int32_t XOffset = SpanStart; XOffset < SpanEnd; XOffset++)
+        {
+            Row[XOffset] = PaletteIndex;
+        }
+        PixelCount += (SpanEnd > SpanStart) ? SpanEnd - SpanStart : 0;
+    }
+
+    return PixelCount;
+}
+
+uint32_t CPURenderer::RasterizeStarReference(const StarDrawCommand& Command, const DamageRect& Clip) const
+{
+    uint32_t Size = Command.Size;
+    StarShape Shape = Command.Shape;
+    uint32_t PixelCount = 0;
+
+    int32_t MinOffset = GetStarMinOffset(Size);
+    int32_t MaxOffset = GetStarMaxOffset(Size);
+
+    for (int32_t YIndex = MinOffset; YIndex < MaxOffset; YIndex++)
+    {
+        for (int32_t XIndex = MinOffset; XIndex < MaxOffset; XIndex++)
+        {
+            if (IsStarPixelSet(Shape, Size, XIndex, YIndex))
+            {
+                int32_t YPixelPos = (int32_t)Command.YPos + YIndex;
+                int32_t XPixelPos = Command.XPos + XIndex;
+
+                //Bounds checking
+                if (YPixelPos >= Clip.Top && YPixelPos < Clip.Bottom && XPixelPos >= Clip.Left && XPixelPos < Clip.Right)
+                {
+                    uint8_t& Pixel = *(RenderBuffer + YPixelPos * Stride + XPixelPos);
+                    Pixel = Command.PaletteIndex;
+                    PixelCount++;
+                }
+            }
+        }
+    }
+
+    return PixelCount;
+}
+
+void CPURenderer::SetRasterPool(WorkerPool* Pool)
+{
+    FlushStars();
+    RasterPool = Pool;
+}
+
+void CPURenderer::RasterizeTileJob(void* Context, uint32_t JobIndex)
+{
+    CPURenderer* Renderer = (CPURenderer*)Context;
+    uint32_t Tile = Renderer->NonEmptyTiles[JobIndex];
+    uint32_t TileX = Tile % Renderer->TileCountX;
+    uint32_t TileY = Tile / Renderer->TileCountX;
+
+    DamageRect Clip = {
+        (int32_t)(TileX * TileSize),
+        (int32_t)(TileY * TileSize),
+        (int32_t)((TileX + 1) * TileSize < Renderer->Width ? (TileX + 1) * TileSize : Renderer->Width),
+        (int32_t)((TileY + 1) * TileSize < Renderer->Height ? (TileY + 1) * TileSize : Renderer->Height),
+    };
+
+    //Stars were binned in submission order, so overlapping stars end up layered the same as when drawn one by one
+    uint32_t First = (Tile > 0) ? Renderer->TileStarOffsets[Tile - 1] : 0;
+    uint32_t Last = Renderer->TileStarOffsets[Tile];
+    uint32_t PixelCount = 0;
+    for (uint32_t Index = First; Index < Last; Index++)
+    {
+        PixelCount += Renderer->RasterizeStar(Renderer->StarCommands[Renderer->TileStarIndices[Index]], Clip);
+    }
+
+    Renderer->TileDrawnPixels.fetch_add(PixelCount);
+}
+
+void CPURenderer::FlushStars()
+{
+    if (StarCommandCount == 0)
+    {
+        return;
+    }
+
+    DamageRect FullClip = { 0, 0, (int32_t)Width, (int32_t)Height };
+
+    //Binning and waking workers costs more than rasterizing small batches directly
+    if (!RasterPool || StarCommandCount < MinStarsForParallelRaster)
+    {
+        for (uint32_t Index = 0; Index < StarCommandCount; Index++)
+        {
+            Stats.DrawnPixels += RasterizeStar(StarCommands[Index], FullClip);
+        }
+
+        StarCommandCount = 0;
+        return;
+    }
+
+    uint32_t TileCount = TileCountX * TileCountY;
+    memset(TileStarOffsets, 0, TileCount * sizeof(*TileStarOffsets));
+
+    //First pass counts stars per tile, stars are clipped to the buffer first so every tile index is valid
+    uint32_t TotalEntries = 0;
+    for (uint32_t Index = 0; Index < StarCommandCount; Index++)
+    {
+        const StarDrawCommand& Command = StarCommands[Index];
+        int32_t Left = Command.XPos + GetStarMinOffset(Command.Size);
+        int32_t Top = (int32_t)Command.YPos + GetStarMinOffset(Command.Size);
+        int32_t Right = Command.XPos + GetStarMaxOffset(Command.Size) - 1;
+        int32_t Bottom = (int32_t)Command.YPos + GetStarMaxOffset(Command.Size) - 1;
+
+        uint32_t FirstTileX = (uint32_t)((Left > 0) ? Left : 0) / TileSize;
+        uint32_t FirstTileY = (uint32_t)((Top > 0) ? Top : 0) / TileSize;
+        uint32_t LastTileX = (uint32_t)((Right < (int32_t)Width) ? Right : (int32_t)Width - 1) / TileSize;
+        uint32_t LastTileY = (uint32_t)((Bottom < (int32_t)Height) ? Bottom : (int32_t)Height - 1) / TileSize;
+
+        for (uint32_t TileY = FirstTileY; TileY <= LastTileY; TileY++)
+        {
+            for (uint32_t TileX = FirstTileX; TileX <= LastTileX; TileX++)
+            {
+                TileStarOffsets[TileY * TileCountX + TileX]++;
+                TotalEntries++;
+            }
+        }
+    }
+
+    GrowArray(TileStarIndices, TileStarIndexCapacity, 0, TotalEntries);
+
+    //Turn counts into start offsets and collect tiles that have any work
+    NonEmptyTileCount = 0;
+    uint32_t Offset = 0;
+    for (uint32_t Tile = 0; Tile < TileCount; Tile++)
+    {
+        uint32_t Count = TileStarOffsets[Tile];
+        TileStarOffsets[Tile] = Offset;
+        Offset += Count;
+
+        if (Count > 0)
+        {
+            NonEmptyTiles[NonEmptyTileCount++] = Tile;
+        }
+    }
+
+    //Second pass fills the bins, afterwards every offset points at the end of its tile
+    for (uint32_t Index = 0; Index < StarCommandCount; Index++)
+    {
+        const StarDrawCommand& Command = StarCommands[Index];
+        int32_t Left = Command.XPos + GetStarMinOffset(Command.Size);
+        int32_t Top = (int32_t)Command.YPos + GetStarMinOffset(Command.Size);
+        int32_t Right = Command.XPos + GetStarMaxOffset(Command.Size) - 1;
+        int32_t Bottom = (int32_t)Command.YPos + GetStarMaxOffset(Command.Size) - 1;
+
+        uint32_t FirstTileX = (uint32_t)((Left > 0) ? Left : 0) / TileSize;
+        uint32_t FirstTileY = (uint32_t)((Top > 0) ? Top : 0) / TileSize;
+        uint32_t LastTileX = (uint32_t)((Right < (int32_t)Width) ? Right : (int32_t)Width - 1) / TileSize;
+        uint32_t LastTileY = (uint32_t)((Bottom < (int32_t)Height) ? Bottom : (int32_t)Height - 1) / TileSize;
+
+        for (uint32_t TileY = FirstTileY; TileY <= LastTileY; TileY++)
+        {
+            for (uint32_t TileX = FirstTileX; TileX <= LastTileX; TileX++)
+            {
+                TileStarIndices[TileStarOffsets[TileY * TileCountX + TileX]++] = Index;
+            }
+        }
+    }
+
+    TileDrawnPixels = 0;
+    RasterPool->Run(&CPURenderer::RasterizeTileJob, this, NonEmptyTileCount);
+    Stats.DrawnPixels += TileDrawnPixels.load();
+
+    StarCommandCount = 0;
+}
+
+void CPURenderer::SetGlowEnabled(bool bEnabled)
+{
+    bGlowEnabled = bEnabled;
+    if (!bGlowEnabled)
+    {
+        return;
+    }
+
+    for (uint32_t Level = 1; Level < GlowLevelCount; Level++)
+    {
+        uint8_t Brightness = (uint8_t)(Level * GlowLevelBrightness);
+        GlowPaletteIndices[Level] = GetPaletteIndex({ Brightness, Brightness, Brightness });
+    }
+    GrowGlowScratch();
+}
+
+void CPURenderer::GrowGlowScratch()
+{
+    //Bands are as narrow as 64 of them per row allow
+    GlowBandShift = 0;
+    while (((Width - 1) >> GlowBandShift) >= 64)
+    {
+        GlowBandShift++;
+    }
+    if (GlowStarBandCapacity < Height)
+    {
+        if (GlowStarBands)
+        {
+            delete[] GlowStarBands;
+        }
+        GlowStarBandCapacity = Height;
+        GlowStarBands = new uint64_t[GlowStarBandCapacity];
+    }
+    memset(GlowStarBands, 0, Height * sizeof(*GlowStarBands));
+
+    if (GlowScratchWidth >= Width)
+    {
+        return;
+    }
+
+    if (GlowRows)
+    {
+        delete[] GlowIntensityRow;
+        delete[] GlowRows;
+        delete[] GlowHaloRow;
+    }
+
+    //Ring of the rows a vertical tap reaches, the zero row after it stands in for rows outside of what's read
+    //Rows are whole SIMD steps long, so the kernels never fall back to scalar tails on narrow areas, columns past an area are computed and dropped
+    GlowScratchWidth = (Width + GlowStep - 1) & ~(GlowStep - 1);
+    GlowIntensityRow = new uint8_t[GlowScratchWidth + GlowRadius * 2 + GlowStep];
+    GlowRows = new uint16_t[(GlowTapCount + 1) * GlowScratchWidth];
+    GlowHaloRow = new uint8_t[GlowScratchWidth];
+    memset(GlowIntensityRow, 0, GlowScratchWidth + GlowRadius * 2 + GlowStep);
+    memset(GlowRows, 0, (GlowTapCount + 1) * GlowScratchWidth * sizeof(*GlowRows));
+}
+
+void CPURenderer::ApplyGlow()
+{
+    if (!bGlowEnabled)
+    {
+        return;
+    }
+    FlushStars();
+
+    //Stars glow as bright as they are, halo levels don't glow themselves
+    uint8_t IntensityTable[MaxPaletteColors] = {};
+    for (uint32_t Index = 1; Index < PaletteCount; Index++)
+    {
+        uint32_t PixelValue = Palette[Index];
+        IntensityTable[Index] = (uint8_t)(((PixelValue & 0xFF) + ((PixelValue >> 8) & 0xFF) * 2 + ((PixelValue >> 16) & 0xFF)) / 4);
+    }
+    for (uint32_t Level = 1; Level < GlowLevelCount; Level++)
+    {
+        IntensityTable[GlowPaletteIndices[Level]] = 0;
+    }
+
+    //Only the area a star's halo reaches is blurred, merged damage would take the empty sky between stars along
+    //Areas are blurred whole or not at all, stars close enough to overlap both blur the overlap the same way
+    uint32_t RemainingPixels = GlowBudgetPixels;
+    for (uint32_t Index = 0; Index < GlowRectCount; Index++)
+    {
+        uint32_t Area = GetRectArea(GlowRects[Index]);
+        if (Area > RemainingPixels)
+        {
+            Stats.GlowSkippedPixels += Area;
+            continue;
+        }
+
+        DamageRect HaloArea = GlowRect(GlowRects[Index], IntensityTable);
+        AddDamage(HaloArea);
+        RemainingPixels -= Area;
+        Stats.GlowPixels += Area;
+    }
+    if (GlowRectCount > 0)
+    {
+        memset(GlowStarBands, 0, Height * sizeof(*GlowStarBands));
+        GlowRectCount = 0;
+    }
+}
+
+DamageRect CPURenderer::GlowRect(const DamageRect& Rect, const uint8_t* IntensityTable)
+{
+    const CPUFeatures& Features = GetCPUFeatures();
+    const GlowKernels* Kernels = Features.bHasAVX2 ? &GlowKernelsAVX2 : (Features.bHasSSE2 ? &GlowKernelsSSE2 : &GlowKernelsScalar);
+
+    //Stars up to GlowRadius outside the rectangle reach into it, so rows and columns that far around it are read as well
+    //Columns past an edge of a wrapping buffer are the ones on the other side, where the parts of stars cut off by the edge are, past other edges there is only background
+    int32_t Radius = (int32_t)GlowRadius;
+    int32_t ReadLeft = (Rect.Left > Radius) ? Rect.Left - Radius : 0;
+    int32_t ReadRight = (Rect.Right + Radius < (int32_t)Width) ? Rect.Right + Radius : (int32_t)Width;
+    int32_t ReadTop = (Rect.Top > Radius) ? Rect.Top - Radius : 0;
+    int32_t ReadBottom = (Rect.Bottom + Radius < (int32_t)Height) ? Rect.Bottom + Radius : (int32_t)Height;
+    uint32_t LeftOutside = (uint32_t)(ReadLeft - (Rect.Left - Radius));
+    uint32_t RightOutside = (uint32_t)(Rect.Right + Radius - ReadRight);
+    uint32_t ReadWidth = (uint32_t)(ReadRight - ReadLeft);
+    uint32_t RectWidth = Rect.Right - Rect.Left;
+
+    //SIMD kernels read and merge whole steps, past the area into the rest of the row or the next one, areas where that would leave the buffer are done in scalar
+    uint32_t StepMask = Kernels->Step - 1;
+    uint32_t ReadEnd = (ReadBottom - 1) * Stride + ReadLeft + ((ReadWidth + StepMask) & ~StepMask);
+    uint32_t MergeEnd = (Rect.Bottom - 1) * Stride + Rect.Left + ((RectWidth + StepMask) & ~StepMask);
+    if (ReadEnd > FrameCapacity || MergeEnd > FrameCapacity)
+    {
+        Kernels = &GlowKernelsScalar;
+        StepMask = 0;
+    }
+    uint32_t IntensityWidth = (ReadWidth + StepMask) & ~StepMask;
+    uint32_t BlurWidth = (RectWidth + StepMask) & ~StepMask;
+    const uint16_t* ZeroRow = GlowRows + GlowTapCount * GlowScratchWidth;
+
+    bool bWrap = bWrapColumns && Width >= GlowRadius;
+    uint64_t ReadBands = GetGlowBands(ReadLeft, ReadRight);
+    if (bWrap)
+    {
+        ReadBands |= (LeftOutside > 0) ? GetGlowBands((int32_t)(Width - LeftOutside), (int32_t)Width) : 0;
+        ReadBands |= (RightOutside > 0) ? GetGlowBands(0, (int32_t)RightOutside) : 0;
+    }
+    else
+    {
+        memset(GlowIntensityRow, 0, LeftOutside);
+    }
+
+    //Slots of rows without star intensity point at the zero row, they're not blurred horizontally
+    const uint16_t* RingRows[GlowTapCount];
+    for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+    {
+        RingRows[Tap] = ZeroRow;
+    }
+    uint32_t Slot = 0;
+    int32_t LastStarRow = ReadTop - (int32_t)GlowTapCount;
+    GlowSpan Written = { RectWidth, 0 };
+    int32_t HaloTop = Rect.Bottom;
+    int32_t HaloBottom = Rect.Top;
+
+    //Row GlowRadius above the last read one is finished once that is, its source pixels have been read by then
+    for (int32_t SourceRow = ReadTop; SourceRow < Rect.Bottom + Radius; SourceRow++)
+    {
+        //Rows without stars where they're read are all background, most rows around a star are, and skipping them keeps their pixels out of the cache
+        RingRows[Slot] = ZeroRow;
+        if (SourceRow < ReadBottom && (GlowStarBands[SourceRow] & ReadBands) != 0)
+        {
+            //Whole steps read past the area also overwrite the zeros right of it, so those are put back every row
+            const uint8_t* SourcePixels = RenderBuffer + SourceRow * Stride;
+            uint32_t AnyIntensity = Kernels->Intensity(GlowIntensityRow + LeftOutside, SourcePixels + ReadLeft, IntensityWidth, IntensityTable);
+            if (bWrap)
+            {
+                AnyIntensity |= Kernels->Intensity(GlowIntensityRow, SourcePixels + Width - LeftOutside, LeftOutside, IntensityTable);
+                AnyIntensity |= Kernels->Intensity(GlowIntensityRow + LeftOutside + ReadWidth, SourcePixels, RightOutside, IntensityTable);
+            }
+            else if (RightOutside > 0)
+            {
+                memset(GlowIntensityRow + LeftOutside + ReadWidth, 0, RightOutside);
+            }
+
+            if (AnyIntensity)
+            {
+                uint16_t* Blurred = GlowRows + Slot * GlowScratchWidth;
+                Kernels->Horizontal(Blurred, GlowIntensityRow, BlurWidth);
+                RingRows[Slot] = Blurred;
+                LastStarRow = SourceRow;
+            }
+        }
+        Slot = (Slot + 1 < GlowTapCount) ? Slot + 1 : 0;
+
+        //Rows with no star within reach get level 0, which is the background index and leaves them as they are
+        int32_t Row = SourceRow - Radius;
+        if (Row < Rect.Top || SourceRow - LastStarRow >= (int32_t)GlowTapCount)
+        {
+            continue;
+        }
+
+        //Slot is back at the oldest row, the topmost tap
+        const uint16_t* Rows[GlowTapCount];
+        for (uint32_t Tap = 0; Tap < GlowTapCount; Tap++)
+        {
+            Rows[Tap] = RingRows[(Slot + Tap < GlowTapCount) ? Slot + Tap : Slot + Tap - GlowTapCount];
+        }
+        //Rows left at level 0 aren't touched, they're most of the rows around dim stars
+        if (Kernels->Vertical(GlowHaloRow, Rows, BlurWidth, GlowPaletteIndices) && Kernels->Merge(RenderBuffer + Row * Stride + Rect.Left, GlowHaloRow, RectWidth, Written))
+        {
+            HaloTop = (Row < HaloTop) ? Row : HaloTop;
+            HaloBottom = Row + 1;
+        }
+    }
+
+    return { Rect.Left + (int32_t)Written.Left, HaloTop, Rect.Left + (int32_t)Written.Right, HaloBottom };
+}
+
+CPURenderer::CPURenderer(uint32_t InWidth, uint32_t InHeight)
+{
+    Width = InWidth;
+    Height = InHeight;
+    Stride = (Width + 3) & ~3u;
+
+#ifdef _WIN32
+    memset(&Info, 0, sizeof(Info));
+    Info.bmiHeader.biSize = sizeof(Info.bmiHeader);
+    Info.bmiHeader.biWidth = Width;
+    Info.bmiHeader.biHeight = -(int32_t)Height;
+    Info.bmiHeader.biPlanes = 1;
+    Info.bmiHeader.biBitCount = 8;
+    Info.bmiHeader.biCompression = BI_RGB;
+    Info.bmiHeader.biClrUsed = PresentPaletteCount;
+#endif
+
+    FrameCapacity = Stride * Height;
+    RenderBuffer = new uint8_t[FrameCapacity];
+
+    DamageCellCapacity = DamageList::GetCellCount(Width, Height);
+    DamageCellMemory = new uint8_t[DamageCellCapacity * (FrameBufferCount + 2)];
+    memset(DamageCellMemory, 0, DamageCellCapacity * (FrameBufferCount + 2));
+    PresentedRects.SetCells(DamageCellMemory, Width, Height);
+    PresentRects.SetCells(DamageCellMemory + DamageCellCapacity, Width, Height);
+    for (uint32_t Index = 0; Index < FrameBufferCount; Index++)
+    {
+        FrameBuffer& Frame = Frames[Index];
+        Frame.Pixels = (Index == 0) ? RenderBuffer : nullptr;
+        Frame.DirtyRects.SetCells(DamageCellMemory + DamageCellCapacity * (Index + 2), Width, Height);
+        Frame.bClearAll = true;
+        Frame.PaletteCount = PaletteCount;
+        Frame.ScrollOrigin = 0;
+    }
+    ExchangeFrame = 2;
+
+    TileCountX = (Width + TileSize - 1) / TileSize;
+    TileCountY = (Height + TileSize - 1) / TileSize;
+    TileCapacity = TileCountX * TileCountY;
+    TileStarOffsets = new uint32_t[TileCapacity];
+    NonEmptyTiles = new uint32_t[TileCapacity];
+    TileDrawnPixels = 0;
+
+    Clear();
+}
+
+size_t CPURenderer::GetMemoryEstimate(uint32_t Width, uint32_t Height, uint32_t StarCount)
+{
+    size_t FrameBytes = (size_t)((Width + 3) & ~3u) * Height * FrameBufferCount;
+    //Rectangles built from cells are at most one per marked cell row of a star, two stars' worth in the list presented from, grown by doubling
+    size_t DamageRectCount = (size_t)(StarCount + DamageList::MaxMergedRects) * 4 * 2 * 2;
+    size_t DamageBytes = (DamageRectCount * sizeof(DamageRect) + DamageList::GetCellCount(Width, Height)) * (FrameBufferCount + 2);
+    size_t TileBytes = (size_t)((Width + TileSize - 1) / TileSize) * ((Height + TileSize - 1) / TileSize) * sizeof(uint32_t) * 2;
+    //Queued commands and tile entries are grown by doubling, every old array stays behind in an arena, a star is binned into at most 4 tiles
+    size_t StarBytes = (size_t)(StarCount + 256) * 4 * (sizeof(StarDrawCommand) + 4 * sizeof(uint32_t));
+    //Halo areas are one per queued star, wrapped copies included, grown by doubling the same way
+    size_t GlowBytes = (size_t)(Width + GlowStep) * (2 + (GlowTapCount + 1) * sizeof(uint16_t)) + GlowRadius * 2 + GlowStep + (size_t)Height * sizeof(uint64_t) + (size_t)(StarCount + 256) * 4 * sizeof(DamageRect);
+
+    return FrameBytes + DamageBytes + TileBytes + StarBytes + GlowBytes;
+}
+
+CPURenderer::~CPURenderer()
+{
+    for (uint32_t Index = 0; Index < FrameBufferCount; Index++)
+    {
+        if (Frames[Index].Pixels)
+        {
+            delete[] Frames[Index].Pixels;
+        }
+    }
+    delete[] DamageCellMemory;
+    delete[] TileStarOffsets;
+    delete[] NonEmptyTiles;
+
+    if (StarCommands)
+    {
+        delete[] StarCommands;
+    }
+
+    if (TileStarIndices)
+    {
+        delete[] TileStarIndices;
+    }
+
+    if (GlowRects)
+    {
+        delete[] GlowRects;
+    }
+
+    if (GlowRows)
+    {
+        delete[] GlowIntensityRow;
+        delete[] GlowRows;
+        delete[] GlowHaloRow;
+    }
+
+    if (GlowStarBands)
+    {
+        delete[] GlowStarBands;
+    }
+}
+
+void CPURenderer::Clear()
+{
+    FrameBuffer& Frame = Frames[DrawFrame];
+    DamageList& DirtyRects = Frame.DirtyRects;
+
+    //When most of the buffer is dirty a single memset is cheaper than many small ones
+    DirtyRects.Resolve();
+    if (Frame.bClearAll || DirtyRects.GetArea() > Width * Height / 2)
+    {
+        memset(RenderBuffer, 0, Stride * Height * sizeof(*RenderBuffer));
+        Stats.ClearedPixels += Width * Height;
+    }
+    else
+    {
+        for (uint32_t Index = 0; Index < DirtyRects.Count; Index++)
+        {
+            const DamageRect& Rect = DirtyRects.Rects[Index];
+            for (int32_t Row = Rect.Top; Row < Rect.Bottom; Row++)
+            {
+                memset(RenderBuffer + Row * Stride + Rect.Left, 0, (Rect.Right - Rect.Left) * sizeof(*RenderBuffer));
+            }
+        }
+        Stats.ClearedPixels += DirtyRects.GetArea();
+    }
+
+    DirtyRects.Reset();
+    Frame.bClearAll = false;
+    if (GlowRectCount > 0)
+    {
+        memset(GlowStarBands, 0, Height * sizeof(*GlowStarBands));
+        GlowRectCount = 0;
+    }
+}
+
+void CPURenderer::InvalidateAll()
+{
+    for (uint32_t Index = 0; Index < FrameBufferCount; Index++)
+    {
+        Frames[Index].bClearAll = true;
+    }
+    bPresentAll = true;
+}
+
+void CPURenderer::Resize(uint32_t NewWidth, uint32_t NewHeight)
+{
+    Width = NewWidth;
+    Height = NewHeight;
+    Stride = (Width + 3) & ~3u;
+    ScrollOrigin = (ScrollOrigin < Width) ? ScrollOrigin : 0;
+
+    //Contents are cleared anyway, so growing doesn't copy
+    if (Stride * Height > FrameCapacity)
+    {
+        FrameCapacity = Stride * Height;
+        for (uint32_t Index = 0; Index < FrameBufferCount; Index++)
+        {
+            if (Frames[Index].Pixels)
+            {
+                delete[] Frames[Index].Pixels;
+                Frames[Index].Pixels = new uint8_t[FrameCapacity];
+            }
+        }
+        RenderBuffer = Frames[DrawFrame].Pixels;
+    }
+
+    TileCountX = (Width + TileSize - 1) / TileSize;
+    TileCountY = (Height + TileSize - 1) / TileSize;
+    if (TileCountX * TileCountY > TileCapacity)
+    {
+        TileCapacity = TileCountX * TileCountY;
+        delete[] TileStarOffsets;
+        delete[] NonEmptyTiles;
+        TileStarOffsets = new uint32_t[TileCapacity];
+        NonEmptyTiles = new uint32_t[TileCapacity];
+    }
+
+    if (bGlowEnabled)
+    {
+        GrowGlowScratch();
+    }
+
+#ifdef _WIN32
+    Info.bmiHeader.biWidth = Width;
+#endif
+
+    //Damage of every buffer is in the old layout, it's replaced by clearing and presenting everything
+    for (uint32_t Index = 0; Index < FrameBufferCount; Index++)
+    {
+        Frames[Index].DirtyRects.Reset();
+    }
+    PresentedRects.Reset();
+    PresentRects.Reset();
+
+    uint32_t CellCount = DamageList::GetCellCount(Width, Height);
+    if (CellCount > DamageCellCapacity)
+    {
+        DamageCellCapacity = CellCount;
+        delete[] DamageCellMemory;
+        DamageCellMemory = new uint8_t[DamageCellCapacity * (FrameBufferCount + 2)];
+        memset(DamageCellMemory, 0, DamageCellCapacity * (FrameBufferCount + 2));
+    }
+    PresentedRects.SetCells(DamageCellMemory, Width, Height);
+    PresentRects.SetCells(DamageCellMemory + DamageCellCapacity, Width, Height);
+    for (uint32_t Index = 0; Index < FrameBufferCount; Index++)
+    {
+        Frames[Index].DirtyRects.SetCells(DamageCellMemory + DamageCellCapacity * (Index + 2), Width, Height);
+    }
+    PresentedScrollOrigin = 0;
+    InvalidateAll();
+}
+
+bool CPURenderer::FitsBuffers(uint32_t NewWidth, uint32_t NewHeight) const
+{
+    uint32_t NewStride = (NewWidth + 3) & ~3u;
+    uint32_t NewTileCount = ((NewWidth + TileSize - 1) / TileSize) * ((NewHeight + TileSize - 1) / TileSize);
+    bool bGlowFits = !bGlowEnabled || (GlowScratchWidth >= NewWidth && GlowStarBandCapacity >= NewHeight);
+
+    return NewStride * NewHeight <= FrameCapacity && NewTileCount <= TileCapacity && DamageList::GetCellCount(NewWidth, NewHeight) <= DamageCellCapacity && bGlowFits;
+}
+
+void CPURenderer::SetPresentOffset(int32_t X, int32_t Y)
+{
+    PresentOffsetX = X;
+    PresentOffsetY = Y;
+    bPresentAll = true;
+}
+
+void CPURenderer::SetPresentScale(uint32_t Scale)
+{
+    PresentScale = (Scale > 0) ? Scale : 1;
+    bPresentAll = true;
+}
+
+void CPURenderer::FinishFrame()
+{
+    FlushStars();
+    Frames[DrawFrame].DirtyRects.Resolve();
+    Frames[DrawFrame].PaletteCount = PaletteCount;
+    Frames[DrawFrame].ScrollOrigin = ScrollOrigin;
+}
+
+void CPURenderer::PublishFrame()
+{
+    FinishFrame();
+
+    //Single buffered renderers never allocate the other two
+    if (!Frames[1].Pixels)
+    {
+        for (uint32_t Index = 1; Index < FrameBufferCount; Index++)
+        {
+            Frames[Index].Pixels = new uint8_t[FrameCapacity];
+        }
+    }
+
+    //Release makes the frame's pixels and palette entries visible to the presenting side, acquire makes sure it's done reading the buffer handed back
+    CompletedFrame = DrawFrame;
+    DrawFrame = ExchangeFrame.exchange(DrawFrame | FreshFrameBit, std::memory_order_acq_rel) & ~FreshFrameBit;
+    RenderBuffer = Frames[DrawFrame].Pixels;
+}
+
+bool CPURenderer::AcquirePublishedFrame()
+{
+    //Only the drawing side can change the exchange in between and it would leave a fresh frame there as well
+    if ((ExchangeFrame.load(std::memory_order_relaxed) & FreshFrameBit) == 0)
+    {
+        return false;
+    }
+
+    PresentFrame = ExchangeFrame.exchange(PresentFrame, std::memory_order_acq_rel) & ~FreshFrameBit;
+    return true;
+}
+
+void CPURenderer::GatherPresentRects(const FrameBuffer& Frame)
+{
+    for (; PresentPaletteCount < Frame.PaletteCount; PresentPaletteCount++)
+    {
+        uint32_t PixelValue = Palette[PresentPaletteCount];
+        PresentPalette[PresentPaletteCount] = PixelValue;
+#ifdef _WIN32
+        Info.bmiColors[PresentPaletteCount] = { (BYTE)PixelValue, (BYTE)(PixelValue >> 8), (BYTE)(PixelValue >> 16), 0 };
+        Info.bmiHeader.biClrUsed = PresentPaletteCount + 1;
+#endif
+    }
+
+    //Screen needs this frame's stars drawn and the previously presented ones erased
+    //Those are erased where they're shown now, if the buffer scrolled since that is a different buffer area, wrapped around the right edge
+    PresentRects.CopyFrom(Frame.DirtyRects);
+    int32_t ScrollDelta = (int32_t)((Frame.ScrollOrigin + Width - PresentedScrollOrigin) % Width);
+    for (uint32_t Index = 0; Index < PresentedRects.Count; Index++)
+    {
+        DamageRect Rect = PresentedRects.Rects[Index];
+        Rect.Left += ScrollDelta;
+        Rect.Right += ScrollDelta;
+        if (Rect.Left >= (int32_t)Width)
+        {
+            Rect.Left -= (int32_t)Width;
+            Rect.Right -= (int32_t)Width;
+        }
+        else if (Rect.Right > (int32_t)Width)
+        {
+            PresentRects.Add({ 0, Rect.Top, Rect.Right - (int32_t)Width, Rect.Bottom });
+            Rect.Right = (int32_t)Width;
+        }
+        PresentRects.Add(Rect);
+    }
+    PresentRects.Resolve();
+
+    if (bPresentAll || PresentRects.GetArea() > Width * Height / 2)
+    {
+        PresentRects.Reset();
+        PresentRects.Rects[0] = { 0, 0, (int32_t)Width, (int32_t)Height };
+        PresentRects.Count = 1;
+    }
+
+    PresentedRects.CopyFrom(Frame.DirtyRects);
+    PresentedScrollOrigin = Frame.ScrollOrigin;
+    bPresentAll = false;
+
+    Stats.PresentedPixels += PresentRects.GetArea() * PresentScale * PresentScale;
+}
+
+//Splits Rect where the scroll origin cuts it in two, OutWindowLefts gets the window column every piece is presented at, counted in buffer pixels
+//Returns the number of pieces, the whole buffer scrolled is presented in two
+static uint32_t SplitAtScrollOrigin(const DamageRect& Rect, uint32_t ScrollOrigin, uint32_t Width, DamageRect* OutPieces, int32_t* OutWindowLefts)
+{
+    int32_t Origin = (int32_t)ScrollOrigin;
+    if (Rect.Left < Origin && Rect.Right > Origin)
+    {
+        OutPieces[0] = { Origin, Rect.Top, Rect.Right, Rect.Bottom };
+        OutWindowLefts[0] = 0;
+        OutPieces[1] = { Rect.Left, Rect.Top, Origin, Rect.Bottom };
+        OutWindowLefts[1] = Rect.Left - Origin + (int32_t)Width;
+        return 2;
+    }
+
+    OutPieces[0] = Rect;
+    OutWindowLefts[0] = (Rect.Left >= Origin) ? Rect.Left - Origin : Rect.Left - Origin + (int32_t)Width;
+    return 1;
+}
+
+#ifdef _WIN32
+void CPURenderer::PresentRect(HDC DeviceContext, const uint8_t* Pixels, const DamageRect& Rect, int32_t WindowLeft)
+{
+    //Source is described as a DIB made of just the rows of the rectangle, so the source origin is unambiguous for top-down DIB
+    int32_t RectWidth = Rect.Right - Rect.Left;
+    int32_t RectHeight = Rect.Bottom - Rect.Top;
+    Info.bmiHeader.biHeight = -RectHeight;
+
+    //Scaled up by the same blit, COLORONCOLOR set by the caller keeps it nearest neighbor
+    StretchDIBits(DeviceContext,
+        PresentOffsetX + WindowLeft * (int32_t)PresentScale, PresentOffsetY + Rect.Top * (int32_t)PresentScale, RectWidth * (int32_t)PresentScale, RectHeight * (int32_t)PresentScale,
+        Rect.Left, 0, RectWidth, RectHeight,
+        Pixels + Rect.Top * Stride,
+        (const BITMAPINFO*)&Info,
+        DIB_RGB_COLORS, SRCCOPY);
+}
+
+void CPURenderer::PresentFrameBuffer(HWND WindowHandle, const FrameBuffer& Frame, FrameProfiler* BlitProfiler)
+{
+    GatherPresentRects(Frame);
+
+    ProfileScope BlitScope = { BlitProfiler, PhasePresentBlit };
+    HDC DeviceContext = GetDC(WindowHandle);
+    //Halftone stretching would average pixels and blur stars
+    SetStretchBltMode(DeviceContext, COLORONCOLOR);
+
+    for (uint32_t Index = 0; Index < PresentRects.Count; Index++)
+    {
+        DamageRect Pieces[2];
+        int32_t WindowLefts[2];
+        uint32_t PieceCount = SplitAtScrollOrigin(PresentRects.Rects[Index], Frame.ScrollOrigin, Width, Pieces, WindowLefts);
+        for (uint32_t Piece = 0; Piece < PieceCount; Piece++)
+        {
+            PresentRect(DeviceContext, Frame.Pixels, Pieces[Piece], WindowLefts[Piece]);
+        }
+    }
+
+    ReleaseDC(WindowHandle, DeviceContext);
+}
+
+void CPURenderer::Present(HWND WindowHandle)
+{
+    FinishFrame();
+    PresentFrameBuffer(WindowHandle, Frames[DrawFrame], Profiler);
+}
+
+bool CPURenderer::PresentLatest(HWND WindowHandle, FrameProfiler* PresentProfiler)
+{
+    if (!AcquirePublishedFrame())
+    {
+        return false;
+    }
+
+    PresentFrameBuffer(WindowHandle, Frames[PresentFrame], PresentProfiler);
+    return true;
+}
+#endif
+
+void CPURenderer::Present(PresentSurface& Surface)
+{
+    FinishFrame();
+    PresentFrameBuffer(Surface, Frames[DrawFrame], Profiler);
+}
+
+bool CPURenderer::PresentLatest(PresentSurface& Surface, FrameProfiler* PresentProfiler)
+{
+    if (!AcquirePublishedFrame())
+    {
+        return false;
+    }
+
+    PresentFrameBuffer(Surface, Frames[PresentFrame], PresentProfiler);
+    return true;
+}
+
+void CPURenderer::PresentFrameBuffer(PresentSurface& Surface, const FrameBuffer& Frame, FrameProfiler* BlitProfiler)
+{
+    GatherPresentRects(Frame);
+
+    ProfileScope BlitScope = { BlitProfiler, PhasePresentBlit };
+
+    void (*ExpandPalette)(uint32_t*, const uint8_t*, uint32_t, const uint32_t*) = GetCPUFeatures().bHasAVX2 ? ExpandPaletteAVX2 : ExpandPaletteScalar;
+
+    //Surface is expected to cover the scaled buffer at the present offset, same as a window would
+    int32_t Scale = (int32_t)PresentScale;
+    for (uint32_t Index = 0; Index < PresentRects.Count; Index++)
+    {
+        DamageRect Pieces[2];
+        int32_t WindowLefts[2];
+        uint32_t PieceCount = SplitAtScrollOrigin(PresentRects.Rects[Index], Frame.ScrollOrigin, Width, Pieces, WindowLefts);
+        for (uint32_t Piece = 0; Piece < PieceCount; Piece++)
+        {
+            const DamageRect& Rect = Pieces[Piece];
+            for (int32_t Row = Rect.Top; Row < Rect.Bottom; Row++)
+            {
+                uint32_t* Destination = Surface.Pixels + (PresentOffsetY + Row * Scale) * (int32_t)Surface.Width + PresentOffsetX + WindowLefts[Piece] * Scale;
+                if (Scale == 1)
+                {
+                    ExpandPalette(Destination, Frame.Pixels + Row * Stride + Rect.Left, Rect.Right - Rect.Left, PresentPalette);
+                    continue;
+                }
+
+                //First window row of the pixel row is expanded, the others are copies of it
+                uint32_t RowBytes = (Rect.Right - Rect.Left) * Scale * sizeof(uint32_t);
+                ExpandPaletteScaled(Destination, Frame.Pixels + Row * Stride + Rect.Left, Rect.Right - Rect.Left, PresentPalette, Scale);
+                for (int32_t Repeat = 1; Repeat < Scale; Repeat++)
+                {
+                    memcpy(Destination + Repeat * (int32_t)Surface.Width, Destination, RowBytes);
+                }
+            }
+        }
+    }
+}
+
+//Multiply and rotate rounds of xxHash64 over four independent lanes, so the loop isn't bound by multiply latency
+static const uint64_t HashPrime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t HashPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+static inline uint64_t HashRound(uint64_t Accumulator, uint64_t Value)
+{
+    Accumulator += Value * HashPrime2;
+    Accumulator = (Accumulator << 31) | (Accumulator >> 33);
+    return Accumulator * HashPrime1;
+}
+
+uint64_t CPURenderer::HashRenderBuffer() const
+{
+    uint64_t Lanes[4] = { HashPrime1 + HashPrime2, HashPrime2, 0, 0 - HashPrime1 };
+
+    //Pixels are hashed as 32 bit colors in row order without padding, so hashes don't depend on how the buffer stores them
+    //Columns are taken in the order they're presented in, starting at the scroll origin
+    const uint32_t PixelsPerRound = 8;
+    uint32_t Pending[PixelsPerRound];
+    uint32_t PendingCount = 0;
+    const uint8_t* Pixels = Frames[CompletedFrame].Pixels;
+    uint32_t Origin = Frames[CompletedFrame].ScrollOrigin;
+    for (uint32_t Row = 0; Row < Height; Row++)
+    {
+        const uint8_t* Indices = Pixels + Row * Stride;
+        for (uint32_t X = 0; X < Width; X++)
+        {
+            uint32_t Column = (X < Width - Origin) ? X + Origin : X + Origin - Width;
+            Pending[PendingCount++] = Palette[Indices[Column]];
+            if (PendingCount == PixelsPerRound)
+            {
+                for (uint32_t Lane = 0; Lane < 4; Lane++)
+                {
+                    Lanes[Lane] = HashRound(Lanes[Lane], (uint64_t)Pending[Lane * 2] | ((uint64_t)Pending[Lane * 2 + 1] << 32));
+                }
+                PendingCount = 0;
+            }
+        }
+    }
+
+    for (uint32_t Pixel = 0; Pixel < PendingCount; Pixel++)
+    {
+        Lanes[0] = HashRound(Lanes[0], Pending[Pixel]);
+    }
+
+    //Size is mixed in so buffers of different shapes with the same pixels don't collide
+    uint64_t Result = HashRound(HashRound(Lanes[0], Lanes[1]), HashRound(Lanes[2], Lanes[3])) ^ ((uint64_t)Width << 32 | Height);
+    Result ^= Result >> 33;
+    Result *= HashPrime2;
+    Result ^= Result >> 29;
+
+    return Result;
+}
+
+bool ValidateStarAtlas()
+{
+    const uint32_t BufferSize = 64;
+    //Center, edges and corners, so both unclipped and clipped paths get compared
+    const uint32_t TestPositions[][2] = {
+        { 32, 32 }, { 0, 0 }, { 1, 1 }, { BufferSize - 1, 0 }, { 0, BufferSize - 1 },
+        { BufferSize - 1, BufferSize - 1 }, { BufferSize - 2, BufferSize - 2 }, { 32, 0 }, { 0, 32 },
+    };
+    const Color TestColor = { 255, 255, 255 };
+
+    CPURenderer AtlasRenderer = { BufferSize, BufferSize };
+    CPURenderer ReferenceRenderer = { BufferSize, BufferSize };
+
+    for (uint32_t Shape = 0; Shape < StarShapeCount; Shape++)
+    {
+        for (uint32_t Size = 1; Size <= AtlasMaxStarSize; Size++)
+        {
+            if (!Atlas.Sprites[Shape][Size].bIsValid)
+            {
+                continue;
+            }
+
+            for (uint32_t PositionIndex = 0; PositionIndex < sizeof(TestPositions) / sizeof(TestPositions[0]); PositionIndex++)
+            {
+                AtlasRenderer.Clear();
+                ReferenceRenderer.Clear();
+
+                AtlasRenderer.DrawStar(TestPositions[PositionIndex][0], TestPositions[PositionIndex][1], Size, (StarShape)Shape, TestColor);
+                ReferenceRenderer.DrawStarReference(TestPositions[PositionIndex][0], TestPositions[PositionIndex][1], Size, (StarShape)Shape, TestColor);
+
+                for (uint32_t PixelIndex = 0; PixelIndex < BufferSize * AtlasRenderer.Stride; PixelIndex++)
+                {
+                    if (AtlasRenderer.RenderBuffer[PixelIndex] != ReferenceRenderer.RenderBuffer[PixelIndex])
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
 }
\ No newline at end of file
@@ -1,23 +1,8 @@
 #pragma once
 
 #include "Globals.h"
-
-class CPURenderer
-{
-public:
-    CPURenderer(uint32_t InWidth, uint32_t InHeight);
-    ~CPURenderer();
-
-    void Clear();
-    void Present(HWND WindowHandle) const;
-
-    uint32_t* RenderBuffer;
-    uint32_t Width;
-    uint32_t Height;
-
-private:
-    BITMAPINFO Info;
-};
+#include "WorkerPool.h"
+#include "FrameProfiler.h"
 
 struct Color
 {
@@ -34,30 +19,312 @@ enum StarShape
     Twinkle,
 };
 
-//Treating Star as a mix of render primitive and world object
-class Star
+struct StarDrawCommand
+{
+    //Negative or past the last column for copies of stars wrapped around the buffer's edge
+    int32_t XPos;
+    uint32_t YPos;
+    uint32_t Size;
+    StarShape Shape;
+    uint8_t PaletteIndex;
+};
+
+//Pixel rectangle, Right and Bottom are exclusive
+struct DamageRect
+{
+    int32_t Left;
+    int32_t Top;
+    int32_t Right;
+    int32_t Bottom;
+};
+
+//List of disjoint rectangles, rectangles closer than MergeDistance are merged on insertion
+//Past MaxMergedRects damage is marked in cells of CellSize pixels instead, which Resolve turns back into rectangles
+//Merging would otherwise grow rectangles over the empty sky between stars, and take time growing with the square of the star count
+//Cells are owned by whoever creates the list, rectangles by the list, grown by doubling as Resolve needs them
+struct DamageList
+{
+    static const uint32_t MaxMergedRects = 256;
+    static const int32_t MergeDistance = 8;
+    static const uint32_t CellSize = 8;
+
+    ~DamageList();
+
+    //Cells has a byte per cell of a Width by Height buffer, zeroed, the list has to be empty
+    void SetCells(uint8_t* InCells, uint32_t Width, uint32_t Height);
+    static uint32_t GetCellCount(uint32_t Width, uint32_t Height);
+
+    void Add(DamageRect Rect);
+    //Rebuilds Rects from the cells marked since the last call, Rects and Count are only complete after it
+    void Resolve();
+    void Reset();
+    //Other has to be resolved
+    void CopyFrom(const DamageList& Other);
+    uint32_t GetArea() const;
+
+    DamageRect* Rects = nullptr;
+    uint32_t Count = 0;
+
+private:
+    //Rectangles aren't kept when growing
+    void ReserveRects(uint32_t Needed);
+    void FillCells(const DamageRect& Rect, uint8_t Value);
+    //Rectangles of runs of marked cells, false if they don't fit Capacity
+    bool ResolveCells();
+
+    uint32_t Capacity = 0;
+    uint8_t* Cells = nullptr;
+    uint32_t CellCountX = 0;
+    uint32_t CellCountY = 0;
+    int32_t PixelWidth = 0;
+    int32_t PixelHeight = 0;
+    //Cells hold the damage and Rects are built from them, until the list is reset
+    bool bCells = false;
+    bool bCellsChanged = false;
+};
+
+//Memory standing in for a window where there is no display to present to, Present copies changed areas into it
+struct PresentSurface
+{
+    uint32_t* Pixels;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+//Pixels touched since the renderer was created, for benchmarking
+struct RenderStats
+{
+    uint64_t ClearedPixels;
+    uint64_t DrawnPixels;
+    uint64_t PresentedPixels;
+    //Pixels blurred by ApplyGlow, and pixels of star areas left without halo because the frame's budget was spent
+    uint64_t GlowPixels;
+    uint64_t GlowSkippedPixels;
+};
+
+class CPURenderer
 {
 public:
-    Star() {};
-    void Initialize(uint32_t WorldWidth, uint32_t WorldHeight, uint32_t InMaxSize, float InMaxLifetime);
+    CPURenderer(uint32_t InWidth, uint32_t InHeight);
+    ~CPURenderer();
+
+    //Clears only pixels drawn since the last Clear
+    void Clear();
+    //Copies to the window only areas drawn this frame or in the previously presented frame
+#ifdef _WIN32
+    void Present(HWND WindowHandle);
+#endif
+    //Surface gets 32 bit colors expanded from the palette
+    void Present(PresentSurface& Surface);
+
+    //Pipelined alternative to Present, the finished frame is handed to another thread and drawing continues in a different buffer
+    //Three buffers are cycled, so neither side ever waits for the other, frames published faster than they are presented are dropped
+    void PublishFrame();
+    //Presents the most recently published frame, returns false if it was presented already
+    //Called from a single thread other than the one drawing, PresentProfiler gets PhasePresentBlit of that thread
+#ifdef _WIN32
+    bool PresentLatest(HWND WindowHandle, FrameProfiler* PresentProfiler);
+#endif
+    bool PresentLatest(PresentSurface& Surface, FrameProfiler* PresentProfiler);
+
+    //Next Clear and Present will process the whole buffer, with the presenting side idle if frames are published
+    void InvalidateAll();
+    //Changes the size in place, buffers are only reallocated when they are too small, every frame is cleared and presented whole afterwards
+    //Called between frames with no stars queued, and with the presenting side idle if frames are published
+    void Resize(uint32_t NewWidth, uint32_t NewHeight);
+    //True if Resize to this size reuses every buffer instead of allocating larger ones
+    bool FitsBuffers(uint32_t NewWidth, uint32_t NewHeight) const;
+    //Position of the buffer's top left corner in the window, for renderers covering only part of it
+    void SetPresentOffset(int32_t X, int32_t Y);
+    //Every buffer pixel is presented as Scale by Scale window pixels with nearest neighbor filtering, the offset stays in window pixels
+    //Called between frames, with the presenting side idle if frames are published
+    void SetPresentScale(uint32_t Scale);
+
+    //Buffer columns form a ring, stars reaching past the left or right edge are drawn on the other side as well
+    //The buffer is then a seamless band of sky, which scrolls by presenting it from a different column without redrawing anything
+    void SetColumnWrap(bool bEnabled) { bWrapColumns = bEnabled; }
+    //Buffer column presented at the window's left edge from the frame being drawn on, columns left of it are presented after the last one
+    //Areas drawn in the previous presented frame are presented again where they have scrolled to, so stars move without presenting the whole buffer
+    void SetScrollOrigin(uint32_t Column) { ScrollOrigin = (Column < Width) ? Column : Column % Width; }
+
+    //Copies precomputed spans from the star atlas, falls back to DrawStarReference for sprites not in the atlas
+    void DrawStar(uint32_t XPos, uint32_t YPos, uint32_t Size, StarShape Shape, Color ColorToSet);
+    //Evaluates star shape per pixel
+    void DrawStarReference(uint32_t XPos, uint32_t YPos, uint32_t Size, StarShape Shape, Color ColorToSet);
+
+    //While a pool is set DrawStar only queues stars, FlushStars bins them per tile and rasterizes tiles on the pool
+    //Every tile is written by a single thread, so output is identical to drawing stars one by one
+    void SetRasterPool(WorkerPool* Pool);
+    void FlushStars();
 
-    void Tick(float DeltaTime);
-    void Render(CPURenderer& Renderer) const;
+    //Soft halo around stars, blurred from the stars drawn this frame over the background next to them
+    //Only the area around each star is blurred, never the whole buffer, and only the part of it a halo is written to is damaged
+    //Takes GlowLevelCount - 1 palette entries, called between frames
+    void SetGlowEnabled(bool bEnabled);
+    //Most pixels ApplyGlow blurs per frame, stars past it are left without halo in that frame
+    void SetGlowBudget(uint32_t Pixels) { GlowBudgetPixels = Pixels; }
+    //Adds halos to the stars drawn this frame, called once after the last star is flushed, does nothing while glow is off
+    void ApplyGlow();
 
-    Color GetColor() const;
-    
-    //Used to determine if Star should tick/render
-    float RemainingLifetime = 0.0f;
+    //PresentedPixels is counted by the presenting thread, read it only while no frame is being presented
+    const RenderStats& GetStats() const { return Stats; }
+    //Hash of the image of the last presented or published frame, for checking that output stays bit identical across changes
+    uint64_t HashRenderBuffer() const;
+    //Present records time spent in the OS blit into PhasePresentBlit of the profiler
+    void SetProfiler(FrameProfiler* InProfiler) { Profiler = InProfiler; }
+
+    //Upper bound of what a renderer allocates over its lifetime with up to StarCount stars per frame, for sizing arenas
+    static size_t GetMemoryEstimate(uint32_t Width, uint32_t Height, uint32_t StarCount);
+
+    static const uint32_t TileSize = 128;
+    static const uint32_t MinStarsForParallelRaster = 1024;
+    //Colors beyond this are drawn with the closest one already in the palette
+    static const uint32_t MaxPaletteColors = 16;
+    //Halo reaches this many pixels past a star's edge
+    static const uint32_t GlowRadius = 3;
+    //Brightness steps of the halo, black included
+    static const uint32_t GlowLevelCount = 8;
+    //Default budget, the halos of the default star count take about 20K pixels, more stars are left without halo instead of slowing frames down
+    static const uint32_t DefaultGlowBudgetPixels = 32 * 1024;
+
+    //One palette index per pixel, expanded to 32 bit colors only when presenting
+    //Rows are Stride bytes apart, which keeps them 4 byte aligned the way 8 bit DIBs require
+    //Points into the buffer currently drawn into, which changes with every PublishFrame
+    uint8_t* RenderBuffer;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Stride;
 
 private:
+    //Both return number of pixels written
+    uint32_t RasterizeStar(const StarDrawCommand& Command, const DamageRect& Clip) const;
+    uint32_t RasterizeStarReference(const StarDrawCommand& Command, const DamageRect& Clip) const;
+    static void RasterizeTileJob(void* Context, uint32_t JobIndex);
+
+    //Damages the star's area and rasterizes it or queues it for FlushStars
+    void SubmitStar(const StarDrawCommand& Command);
+
+    //Adds ColorToSet to the palette when it's new, index 0 is black which Clear fills with
+    uint8_t GetPaletteIndex(Color ColorToSet);
+    //Blurs Rect of the draw buffer with what's within GlowRadius around it and writes halo levels over its background pixels
+    //Returns the part of Rect halo was written to, empty if none was
+    DamageRect GlowRect(const DamageRect& Rect, const uint8_t* IntensityTable);
+    //Row buffers of the blur are sized for the buffer width, star bands for its height
+    void GrowGlowScratch();
+    //Bits of the bands of GlowStarBands that columns Left to Right, exclusive, fall into
+    uint64_t GetGlowBands(int32_t Left, int32_t Right) const
+    {
+        return (~0ull >> (63 - ((uint32_t)(Right - 1) >> GlowBandShift))) & (~0ull << ((uint32_t)Left >> GlowBandShift));
+    }
+
+    static const uint32_t FrameBufferCount = 3;
+    //Flag in ExchangeFrame, set by PublishFrame and cleared once the frame is taken for presenting
+    static const uint32_t FreshFrameBit = 4;
+
+    //Pixels with the areas drawn into them since they were last cleared, and the palette size and scroll origin they were drawn with
+    struct FrameBuffer
+    {
+        uint8_t* Pixels;
+        DamageList DirtyRects;
+        bool bClearAll;
+        uint32_t PaletteCount;
+        uint32_t ScrollOrigin;
+    };
+
+    //Clips Rect to the buffer, returns false if nothing is left of it
+    bool ClipRect(DamageRect& Rect) const;
+    //Clips Rect to the buffer and damages what's left of it, returns false if nothing is
+    bool AddDamage(DamageRect& Rect);
+    //Flushes stars and records the palette the frame needs
+    void FinishFrame();
+    //Collects areas to copy for presenting Frame into PresentRects and copies palette entries new to the presenting side
+    void GatherPresentRects(const FrameBuffer& Frame);
+    //Takes the latest published frame into PresentFrame
+    bool AcquirePublishedFrame();
+    void PresentFrameBuffer(PresentSurface& Surface, const FrameBuffer& Frame, FrameProfiler* BlitProfiler);
+#ifdef _WIN32
+    void PresentFrameBuffer(HWND WindowHandle, const FrameBuffer& Frame, FrameProfiler* BlitProfiler);
+    void PresentRect(HDC DeviceContext, const uint8_t* Pixels, const DamageRect& Rect, int32_t WindowLeft);
+
+    //BITMAPINFO with room for the whole palette, GDI expands indices while blitting
+    struct PaletteBitmapInfo
+    {
+        BITMAPINFOHEADER bmiHeader;
+        RGBQUAD bmiColors[MaxPaletteColors];
+    };
+    PaletteBitmapInfo Info;
+#endif
+
+    //Colors in render buffer order, B | G << 8 | R << 16, unused entries are black
+    //Entries are only ever appended, the presenting side copies the ones a frame uses into PresentPalette
+    uint32_t Palette[MaxPaletteColors] = {};
+    uint32_t PaletteCount = 1;
+    uint32_t PresentPalette[MaxPaletteColors] = {};
+    uint32_t PresentPaletteCount = 1;
+
+    //Only the first buffer exists until the first PublishFrame
+    FrameBuffer Frames[FrameBufferCount];
+    //Bytes allocated per frame buffer, Resize reuses them as long as Stride * Height fits
+    uint32_t FrameCapacity;
+    //Owned by the drawing side
+    uint32_t DrawFrame = 0;
+    //Frame HashRenderBuffer looks at
+    uint32_t CompletedFrame = 0;
+    //Owned by the presenting side
+    uint32_t PresentFrame = 1;
+    //Index of the buffer between the two sides, swapped with DrawFrame on publish and with PresentFrame on acquire
+    std::atomic<uint32_t> ExchangeFrame;
+
+    //Areas drawn in the frame which is currently on screen, and the column it was presented from
+    DamageList PresentedRects;
+    uint32_t PresentedScrollOrigin = 0;
+    DamageList PresentRects;
+    uint8_t* DamageCellMemory;
+    //Cells allocated per damage list, Resize reuses them as long as the buffer's cells fit
+    uint32_t DamageCellCapacity;
+    bool bPresentAll = true;
+    int32_t PresentOffsetX = 0;
+    int32_t PresentOffsetY = 0;
+    uint32_t PresentScale = 1;
+    bool bWrapColumns = false;
+    //Drawing side's origin, recorded in every frame it finishes
+    uint32_t ScrollOrigin = 0;
+
+    WorkerPool* RasterPool = nullptr;
+    StarDrawCommand* StarCommands = nullptr;
+    uint32_t StarCommandCount = 0;
+    uint32_t StarCommandCapacity = 0;
+
+    uint32_t TileCountX;
+    uint32_t TileCountY;
+    //Entries allocated in TileStarOffsets and NonEmptyTiles
+    uint32_t TileCapacity;
+    //Per tile end offset into TileStarIndices once binning is done
+    uint32_t* TileStarOffsets;
+    uint32_t* TileStarIndices = nullptr;
+    uint32_t TileStarIndexCapacity = 0;
+    uint32_t* NonEmptyTiles;
+    uint32_t NonEmptyTileCount = 0;
+    std::atomic<uint32_t> TileDrawnPixels;
 
-    uint32_t XPos = 0;
-    uint32_t YPos = 0;
-    uint32_t Size = 0;
-    StarShape Shape = StarShape::Square;
-    bool bShouldProgress = false; //Should star expand and twinkle
+    bool bGlowEnabled = false;
+    uint32_t GlowBudgetPixels = DefaultGlowBudgetPixels;
+    //Palette index of every halo level, 0 is the background, padded to a SIMD register for the level lookup
+    uint8_t GlowPaletteIndices[MaxPaletteColors] = {};
+    //Area of every star submitted this frame with its halo, clipped to the buffer
+    DamageRect* GlowRects = nullptr;
+    uint32_t GlowRectCount = 0;
+    uint32_t GlowRectCapacity = 0;
+    //Star intensities of one row with GlowRadius more on both sides and a SIMD step of slack, the horizontally blurred rows around the one being finished plus a row of zeros, and its halo
+    uint8_t* GlowIntensityRow = nullptr;
+    uint16_t* GlowRows = nullptr;
+    uint8_t* GlowHaloRow = nullptr;
+    uint32_t GlowScratchWidth = 0;
+    //Bit per band of 1 << GlowBandShift columns of every row, set where a star submitted this frame has pixels
+    uint64_t* GlowStarBands = nullptr;
+    uint32_t GlowStarBandCapacity = 0;
+    uint32_t GlowBandShift = 0;
 
-    float MaxLifetime = 0;
-    
-    uint8_t ExpandStage = 0;
+    RenderStats Stats = {};
+    FrameProfiler* Profiler = nullptr;
 };
\ No newline at end of file
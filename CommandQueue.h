@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <atomic>
+
+//Bounded lock free queue, any number of threads push and a single thread pops, items come out in the order their pushes claimed a cell
+//Every cell carries a sequence telling whose turn it is, so pushes never wait on each other and a full queue is reported instead of blocking
+//Sequences are stored minus the cell index, so a zeroed queue is valid and empty and it can live in global objects of the CRT free build
+template<typename ItemType, uint32_t Capacity>
+class CommandQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+public:
+    //Returns false without waiting if the queue is full
+    bool Push(const ItemType& Item)
+    {
+        uint32_t Position = EnqueuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& Target = Cells[Position & (Capacity - 1)];
+            int32_t Difference = (int32_t)(Target.Sequence.load(std::memory_order_acquire) + (Position & (Capacity - 1)) - Position);
+            if (Difference == 0)
+            {
+                //Cell is free for this position, the first producer to claim the position writes it
+                if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+                {
+                    Target.Item = Item;
+                    Target.Sequence.store(Position + 1 - (Position & (Capacity - 1)), std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (Difference < 0)
+            {
+                //Consumer hasn't taken the item pushed one lap earlier yet
+                return false;
+            }
+            else
+            {
+                Position = EnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Only called by the consuming thread, returns false if nothing was pushed or the oldest push is still writing its item
+    bool Pop(ItemType& OutItem)
+    {
+        Cell& Source = Cells[DequeuePosition & (Capacity - 1)];
+        uint32_t Sequence = Source.Sequence.load(std::memory_order_acquire) + (DequeuePosition & (Capacity - 1));
+        if (Sequence != DequeuePosition + 1)
+        {
+            return false;
+        }
+
+        OutItem = Source.Item;
+        //Hands the cell to the push one lap later
+        Source.Sequence.store(DequeuePosition + Capacity - (DequeuePosition & (Capacity - 1)), std::memory_order_release);
+        DequeuePosition++;
+
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint32_t> Sequence;
+        ItemType Item;
+    };
+
+    Cell Cells[Capacity];
+    std::atomic<uint32_t> EnqueuePosition;
+    //Only touched by the consumer
+    uint32_t DequeuePosition;
+};
@@ -0,0 +1,241 @@
+#include "FrameProfiler.h"
+#include "Platform.h"
+
+static const char* PhaseNames[PhaseCount] = { "clear", "world_tick", "star_render", "glow", "present", "present_blit", "wait", "wait_spin", "present_overlap" };
+
+//Log linear buckets of microseconds, 8 buckets per power of two keep p99 within 12.5% of the real value
+static const uint32_t HistogramSubBucketBits = 3;
+static const uint32_t HistogramSubBucketCount = 1 << HistogramSubBucketBits;
+static const uint32_t HistogramBucketCount = (32 - HistogramSubBucketBits + 1) << HistogramSubBucketBits;
+
+static uint32_t GetHistogramBucket(uint32_t Value)
+{
+    if (Value < HistogramSubBucketCount)
+    {
+        return Value;
+    }
+
+    uint32_t Octave = FindHighestSetBit(Value);
+    uint32_t SubBucket = (Value >> (Octave - HistogramSubBucketBits)) & (HistogramSubBucketCount - 1);
+
+    return ((Octave - HistogramSubBucketBits + 1) << HistogramSubBucketBits) + SubBucket;
+}
+
+static uint32_t GetHistogramBucketLowerBound(uint32_t Bucket)
+{
+    if (Bucket < HistogramSubBucketCount)
+    {
+        return Bucket;
+    }
+
+    uint32_t Octave = (Bucket >> HistogramSubBucketBits) + HistogramSubBucketBits - 1;
+    return (HistogramSubBucketCount + (Bucket & (HistogramSubBucketCount - 1))) << (Octave - HistogramSubBucketBits);
+}
+
+static uint32_t GetHistogramBucketWidth(uint32_t Bucket)
+{
+    if (Bucket < HistogramSubBucketCount)
+    {
+        return 1;
+    }
+
+    return 1u << ((Bucket >> HistogramSubBucketBits) - 1);
+}
+
+FrameProfiler::FrameProfiler()
+{
+    History = new FrameRecord[HistoryFrameCount];
+    for (uint32_t Index = 0; Index < HistoryFrameCount; Index++)
+    {
+        History[Index].Sequence = 0;
+    }
+    RecordedFrameCount = 0;
+
+    for (uint32_t Phase = 0; Phase < PhaseCount; Phase++)
+    {
+        PhaseStartTicks[Phase] = 0;
+        CurrentPhaseTicks[Phase] = 0;
+    }
+
+    //Through signed integers, the 32 bit build has no helpers for unsigned 64 bit conversions
+    NanosecondsPerTick = 1000000000.0 / (double)(int64_t)PlatformGetTickFrequency();
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    delete[] History;
+}
+
+void FrameProfiler::BeginPhase(ProfilePhase Phase)
+{
+    PhaseStartTicks[Phase] = PlatformGetTicks();
+}
+
+void FrameProfiler::EndPhase(ProfilePhase Phase)
+{
+    CurrentPhaseTicks[Phase] += PlatformGetTicks() - PhaseStartTicks[Phase];
+}
+
+void FrameProfiler::AddPhaseTicks(ProfilePhase Phase, uint64_t Ticks)
+{
+    CurrentPhaseTicks[Phase] += Ticks;
+}
+
+void FrameProfiler::EndFrame()
+{
+    uint32_t FrameIndex = RecordedFrameCount.load(std::memory_order_relaxed);
+    FrameRecord& Record = History[FrameIndex % HistoryFrameCount];
+
+    Record.Sequence.store(FrameIndex * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint32_t Phase = 0; Phase < PhaseCount; Phase++)
+    {
+        double Nanoseconds = (double)(int64_t)CurrentPhaseTicks[Phase] * NanosecondsPerTick;
+        Record.PhaseNanoseconds[Phase].store((Nanoseconds < 4294967295.0) ? (uint32_t)(int64_t)Nanoseconds : 0xFFFFFFFF, std::memory_order_relaxed);
+        CurrentPhaseTicks[Phase] = 0;
+    }
+
+    Record.Sequence.store(FrameIndex * 2 + 2, std::memory_order_release);
+    RecordedFrameCount.store(FrameIndex + 1, std::memory_order_release);
+}
+
+void FrameProfiler::DiscardFrame()
+{
+    for (uint32_t Phase = 0; Phase < PhaseCount; Phase++)
+    {
+        CurrentPhaseTicks[Phase] = 0;
+    }
+}
+
+bool FrameProfiler::ReadFrame(uint32_t FrameIndex, uint32_t* OutPhaseNanoseconds) const
+{
+    const FrameRecord& Record = History[FrameIndex % HistoryFrameCount];
+    uint32_t ExpectedSequence = FrameIndex * 2 + 2;
+
+    if (Record.Sequence.load(std::memory_order_acquire) != ExpectedSequence)
+    {
+        return false;
+    }
+
+    for (uint32_t Phase = 0; Phase < PhaseCount; Phase++)
+    {
+        OutPhaseNanoseconds[Phase] = Record.PhaseNanoseconds[Phase].load(std::memory_order_relaxed);
+    }
+
+    //Frame was overwritten while copying if the sequence moved on
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return Record.Sequence.load(std::memory_order_relaxed) == ExpectedSequence;
+}
+
+void FrameProfiler::WriteReport(ReportWriter& Report) const
+{
+    //Last entry is the whole frame, PhasePresentBlit and PhaseWaitSpin are excluded from it as they are part of other phases, PhasePresentOverlap as it's another thread's time
+    const uint32_t StatCount = PhaseCount + 1;
+
+    uint32_t* Histograms = new uint32_t[StatCount * HistogramBucketCount];
+    memset(Histograms, 0, StatCount * HistogramBucketCount * sizeof(*Histograms));
+
+    double Sums[StatCount] = {};
+    uint32_t Minimums[StatCount];
+    uint32_t Maximums[StatCount] = {};
+    for (uint32_t Stat = 0; Stat < StatCount; Stat++)
+    {
+        Minimums[Stat] = 0xFFFFFFFF;
+    }
+
+    uint32_t HistoryEnd = RecordedFrameCount.load(std::memory_order_acquire);
+    uint32_t HistoryBegin = (HistoryEnd > HistoryFrameCount) ? HistoryEnd - HistoryFrameCount : 0;
+    uint32_t FrameCount = 0;
+
+    for (uint32_t FrameIndex = HistoryBegin; FrameIndex < HistoryEnd; FrameIndex++)
+    {
+        uint32_t Values[StatCount];
+        if (!ReadFrame(FrameIndex, Values))
+        {
+            continue;
+        }
+
+        Values[PhaseCount] = 0;
+        for (uint32_t Phase = 0; Phase < PhaseCount; Phase++)
+        {
+            if (Phase != PhasePresentBlit && Phase != PhaseWaitSpin && Phase != PhasePresentOverlap)
+            {
+                uint32_t Total = Values[PhaseCount] + Values[Phase];
+                Values[PhaseCount] = (Total >= Values[PhaseCount]) ? Total : 0xFFFFFFFF;
+            }
+        }
+
+        for (uint32_t Stat = 0; Stat < StatCount; Stat++)
+        {
+            uint32_t Microseconds = Values[Stat] / 1000;
+
+            Sums[Stat] += Microseconds;
+            Minimums[Stat] = (Microseconds < Minimums[Stat]) ? Microseconds : Minimums[Stat];
+            Maximums[Stat] = (Microseconds > Maximums[Stat]) ? Microseconds : Maximums[Stat];
+            Histograms[Stat * HistogramBucketCount + GetHistogramBucket(Microseconds)]++;
+        }
+
+        FrameCount++;
+    }
+
+    Report.Append("{ \"recorded_frames\": ");
+    Report.AppendUInt(HistoryEnd);
+    Report.Append(", \"window_frames\": ");
+    Report.AppendUInt(FrameCount);
+    Report.Append(",\n  \"phases\": [");
+
+    for (uint32_t Stat = 0; Stat < StatCount; Stat++)
+    {
+        const uint32_t* Histogram = Histograms + Stat * HistogramBucketCount;
+
+        //Upper bound of the bucket holding the 99th percentile frame, but never above the slowest frame seen
+        uint32_t Percentile99 = 0;
+        uint32_t FramesBelow = 0;
+        uint32_t FramesNeeded = FrameCount - FrameCount / 100;
+        for (uint32_t Bucket = 0; Bucket < HistogramBucketCount && FrameCount > 0; Bucket++)
+        {
+            FramesBelow += Histogram[Bucket];
+            if (FramesBelow >= FramesNeeded)
+            {
+                Percentile99 = GetHistogramBucketLowerBound(Bucket) + GetHistogramBucketWidth(Bucket) - 1;
+                Percentile99 = (Percentile99 < Maximums[Stat]) ? Percentile99 : Maximums[Stat];
+                break;
+            }
+        }
+
+        Report.Append((Stat == 0) ? "\n    { \"name\": \"" : ",\n    { \"name\": \"");
+        Report.Append((Stat < PhaseCount) ? PhaseNames[Stat] : "frame");
+        Report.Append("\", \"min_us\": ");
+        Report.AppendUInt(FrameCount ? Minimums[Stat] : 0);
+        Report.Append(", \"mean_us\": ");
+        Report.AppendFloat(FrameCount ? Sums[Stat] / FrameCount : 0.0, 1);
+        Report.Append(", \"p99_us\": ");
+        Report.AppendUInt(Percentile99);
+        Report.Append(", \"max_us\": ");
+        Report.AppendUInt(Maximums[Stat]);
+
+        //Only buckets with frames in them, as [lower bound in microseconds, frame count] pairs
+        Report.Append(",\n      \"histogram\": [");
+        bool bIsFirstBucket = true;
+        for (uint32_t Bucket = 0; Bucket < HistogramBucketCount; Bucket++)
+        {
+            if (Histogram[Bucket] == 0)
+            {
+                continue;
+            }
+
+            Report.Append(bIsFirstBucket ? "[" : ", [");
+            Report.AppendUInt(GetHistogramBucketLowerBound(Bucket));
+            Report.Append(", ");
+            Report.AppendUInt(Histogram[Bucket]);
+            Report.Append("]");
+            bIsFirstBucket = false;
+        }
+        Report.Append("] }");
+    }
+
+    Report.Append("\n  ] }");
+
+    delete[] Histograms;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Globals.h"
+#include "Benchmark.h"
+
+#include <atomic>
+
+enum ProfilePhase
+{
+    PhaseClear,
+    PhaseWorldTick,
+    PhaseStarRender,
+    //Blurring halos around the stars rendered, only while glow is on
+    PhaseGlow,
+    PhasePresent,
+    //Part of PhasePresent spent handing pixels to the OS, StretchDIBits on Windows
+    PhasePresentBlit,
+    PhaseWait,
+    //Part of PhaseWait spent spinning after the timer woke up
+    PhaseWaitSpin,
+    //Time a present thread spent presenting the previous frame while this one was built, not part of this thread's frame
+    PhasePresentOverlap,
+    PhaseCount,
+};
+
+//Records how long each phase of every frame took, keeps the last HistoryFrameCount frames for reports
+//Frames are recorded by a single thread, reports can be made from any thread while recording goes on
+class FrameProfiler
+{
+public:
+    FrameProfiler();
+    ~FrameProfiler();
+
+    //Time between begin and end is added to the phase for the current frame, a phase can be entered multiple times per frame
+    void BeginPhase(ProfilePhase Phase);
+    void EndPhase(ProfilePhase Phase);
+    //For time measured elsewhere
+    void AddPhaseTicks(ProfilePhase Phase, uint64_t Ticks);
+    //Publishes the current frame to the history and starts a new one
+    void EndFrame();
+    //Starts a new frame without recording the current one
+    void DiscardFrame();
+
+    //Appends min, mean, p99, max and a histogram per phase over the frames in history as JSON
+    void WriteReport(ReportWriter& Report) const;
+
+    static const uint32_t HistoryFrameCount = 512;
+
+private:
+    //Sequence is odd while the frame is written, readers retry until they see the same even value before and after copying
+    struct FrameRecord
+    {
+        std::atomic<uint32_t> Sequence;
+        std::atomic<uint32_t> PhaseNanoseconds[PhaseCount];
+    };
+
+    bool ReadFrame(uint32_t FrameIndex, uint32_t* OutPhaseNanoseconds) const;
+
+    FrameRecord* History;
+    std::atomic<uint32_t> RecordedFrameCount;
+
+    uint64_t PhaseStartTicks[PhaseCount];
+    uint64_t CurrentPhaseTicks[PhaseCount];
+    double NanosecondsPerTick;
+};
+
+//Times the enclosing block, does nothing without a profiler
+class ProfileScope
+{
+public:
+    ProfileScope(FrameProfiler* InProfiler, ProfilePhase InPhase)
+        : Profiler(InProfiler), Phase(InPhase)
+    {
+        if (Profiler)
+        {
+            Profiler->BeginPhase(Phase);
+        }
+    }
+
+    ~ProfileScope()
+    {
+        if (Profiler)
+        {
+            Profiler->EndPhase(Phase);
+        }
+    }
+
+private:
+    FrameProfiler* Profiler;
+    ProfilePhase Phase;
+};
@@ -1,43 +1,113 @@
 #include "FrameTimer.h"
 
-#include <timeapi.h>
+//Used until enough oversleeps were seen, about what a timer at 1 millisecond system tick needs
+static const float InitialWakeUpMarginSeconds = 0.002f;
+//Margin covers this share of recent oversleeps, remaining ones end up past the deadline and the next frame starts a bit late
+static const uint32_t WakeUpMarginPercentile = 95;
 
 FrameTimer::FrameTimer(float InTargetSecondsPerFrame)
 {
-    //Request for sleep to be accurate to 1 millisecond, it may fail, but given the context we don't want to spin lock even if sleep isn't accurate
-    timeBeginPeriod(1);
-    QueryPerformanceCounter(&LastCounter);
+    WaitTimer = PlatformCreateWaitTimer();
 
-    LARGE_INTEGER PerfCountFrequencyResult;
-    QueryPerformanceFrequency(&PerfCountFrequencyResult);
-    PerfCountFrequency = PerfCountFrequencyResult.QuadPart;
+    //Through signed integers, the 32 bit build has no helpers for unsigned 64 bit conversions
+    TickFrequency = PlatformGetTickFrequency();
+    SetTargetSecondsPerFrame(InTargetSecondsPerFrame);
+    WakeUpMarginTicks = (uint64_t)(int64_t)((double)InitialWakeUpMarginSeconds * (double)(int64_t)TickFrequency);
 
-    TargetSecondsPerFrame = InTargetSecondsPerFrame;
+    LastFrameTicks = PlatformGetTicks();
+    NextDeadline = LastFrameTicks + TargetTicksPerFrame;
 }
 
-void FrameTimer::WaitUntilFrametime()
+void FrameTimer::SetTargetSecondsPerFrame(float InTargetSecondsPerFrame)
 {
-    LARGE_INTEGER CurrentCounter;
-    QueryPerformanceCounter(&CurrentCounter);
-    CurrentFrameTime = ((float)(CurrentCounter.QuadPart - LastCounter.QuadPart) / (float)PerfCountFrequency);
+    TargetTicksPerFrame = (uint64_t)(int64_t)((double)InTargetSecondsPerFrame * (double)(int64_t)TickFrequency);
+}
+
+FrameTimer::~FrameTimer()
+{
+    PlatformDestroyWaitTimer(WaitTimer);
+}
+
+void FrameTimer::RecordOversleep(uint64_t OversleepTicks)
+{
+    OversleepSamples[RecordedOversleepCount % MaxOversleepSamples] = (OversleepTicks < 0xFFFFFFFF) ? (uint32_t)OversleepTicks : 0xFFFFFFFF;
+    RecordedOversleepCount++;
+
+    uint32_t SampleCount = (RecordedOversleepCount < MaxOversleepSamples) ? RecordedOversleepCount : MaxOversleepSamples;
+    if (SampleCount < MaxOversleepSamples / 4)
+    {
+        return;
+    }
 
-    if (CurrentFrameTime < TargetSecondsPerFrame)
+    //Insertion sort of a copy, cheap enough for once per frame
+    uint32_t Sorted[MaxOversleepSamples];
+    for (uint32_t Index = 0; Index < SampleCount; Index++)
     {
-        //Sleep if we have more than 1 millisecond until frame time
-        DWORD SleepMS = (DWORD)(1000.0f * (TargetSecondsPerFrame - CurrentFrameTime));
-        if (SleepMS > 0)
+        uint32_t Value = OversleepSamples[Index];
+        uint32_t Position = Index;
+        while (Position > 0 && Sorted[Position - 1] > Value)
         {
-            Sleep(SleepMS);
+            Sorted[Position] = Sorted[Position - 1];
+            Position--;
         }
+        Sorted[Position] = Value;
+    }
+
+    WakeUpMarginTicks = Sorted[(SampleCount - 1) * WakeUpMarginPercentile / 100];
+    if (WakeUpMarginTicks > TargetTicksPerFrame)
+    {
+        WakeUpMarginTicks = TargetTicksPerFrame;
+    }
+}
+
+void FrameTimer::WaitUntilFrametime(uint32_t FrameCount)
+{
+    ProfileScope WaitScope = { &Profiler, PhaseWait };
 
-        while (CurrentFrameTime < TargetSecondsPerFrame)
+    if (FrameCount > 1)
+    {
+        NextDeadline += TargetTicksPerFrame * (FrameCount - 1);
+    }
+
+    uint64_t CurrentTicks = PlatformGetTicks();
+    if (CurrentTicks < NextDeadline)
+    {
+        //Sleep only if the timer is expected to wake up before the deadline
+        if (NextDeadline - CurrentTicks > WakeUpMarginTicks)
         {
-            LARGE_INTEGER CurrentCounter;
-            QueryPerformanceCounter(&CurrentCounter);
+            uint64_t WakeUpTicks = NextDeadline - WakeUpMarginTicks;
+            PlatformWaitUntil(WaitTimer, WakeUpTicks);
+
+            CurrentTicks = PlatformGetTicks();
+            RecordOversleep((CurrentTicks > WakeUpTicks) ? CurrentTicks - WakeUpTicks : 0);
+        }
 
-            CurrentFrameTime = ((float)(CurrentCounter.QuadPart - LastCounter.QuadPart) / (float)PerfCountFrequency);
+        ProfileScope SpinScope = { &Profiler, PhaseWaitSpin };
+        uint64_t SpinStartTicks = CurrentTicks;
+        while (CurrentTicks < NextDeadline)
+        {
+            CurrentTicks = PlatformGetTicks();
         }
+        SpinTicks += CurrentTicks - SpinStartTicks;
+    }
+
+    CurrentFrameTime = (float)(int64_t)(CurrentTicks - LastFrameTicks) / (float)(int64_t)TickFrequency;
+    LastFrameTicks = CurrentTicks;
+
+    //Deadlines stay on a fixed grid so a late frame doesn't delay all later ones, after a long stall the grid restarts instead of catching up
+    NextDeadline += TargetTicksPerFrame;
+    if (NextDeadline <= CurrentTicks)
+    {
+        NextDeadline = CurrentTicks + TargetTicksPerFrame;
     }
+}
+
+float FrameTimer::GetWakeUpMarginSeconds() const
+{
+    return (float)(int64_t)WakeUpMarginTicks / (float)(int64_t)TickFrequency;
+}
 
-    LastCounter = CurrentCounter;
-}
\ No newline at end of file
+double FrameTimer::GetSpinSeconds() const
+{
+    return (double)(int64_t)SpinTicks / (double)(int64_t)TickFrequency;
+}
@@ -1,21 +1,47 @@
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN 1
-#include "Windows.h"
-#undef WIN32_LEAN_AND_MEAN
-#include <stdint.h>
+#include "Globals.h"
+#include "Platform.h"
+#include "FrameProfiler.h"
 
+//Paces frames to a fixed rate, sleeps on a high resolution timer until shortly before the deadline and spins the rest
+//How early to wake up is learned from how late the timer woke up in recent frames
 class FrameTimer
 {
 public:
     FrameTimer(float InTargetSecondsPerFrame);
-    void WaitUntilFrametime();
+    ~FrameTimer();
 
+    //Waits for the deadline FrameCount frames after the previous one, frames in between are skipped
+    void WaitUntilFrametime(uint32_t FrameCount = 1);
+    //Takes effect from the next deadline on, the one already set is kept
+    void SetTargetSecondsPerFrame(float InTargetSecondsPerFrame);
+
+    //Seconds between the end of the last two waits
     float CurrentFrameTime = 0.0f;
 
+    //Time spent in WaitUntilFrametime is recorded as PhaseWait, spinning part of it also as PhaseWaitSpin, other phases are recorded by the frame loop
+    FrameProfiler Profiler;
+
+    uint64_t GetTargetTicksPerFrame() const { return TargetTicksPerFrame; }
+    float GetWakeUpMarginSeconds() const;
+    //Total time spent spinning instead of sleeping
+    double GetSpinSeconds() const;
+
+    static const uint32_t MaxOversleepSamples = 64;
+
 private:
-    LARGE_INTEGER LastCounter;
-    int64_t PerfCountFrequency;
+    void RecordOversleep(uint64_t OversleepTicks);
+
+    PlatformWaitTimer WaitTimer;
+    uint64_t TickFrequency;
+    uint64_t TargetTicksPerFrame;
+    uint64_t LastFrameTicks;
+    uint64_t NextDeadline;
 
-    float TargetSecondsPerFrame;
-};
\ No newline at end of file
+    //How late the timer woke up in the most recent waits, in ticks
+    uint32_t OversleepSamples[MaxOversleepSamples];
+    uint32_t RecordedOversleepCount = 0;
+    uint64_t WakeUpMarginTicks;
+    uint64_t SpinTicks = 0;
+};
@@ -1,92 +1,461 @@
 #include "Globals.h"
+#include "MemoryArena.h"
 
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+#ifndef _WIN32
+#include <new>
+#endif
+
+#ifdef _WIN32
 extern "C" {
     int _fltused = 0;
 }
+#endif
+
+//Replaced on POSIX as well, so the headless build allocates the same way as the screen saver
+//Screen saver has no exceptions without the CRT and returns nullptr when out of memory, POSIX throws as operator new has to
+static void* AllocateOrFail(size_t Size)
+{
+    //Every block has an address of its own, zero sized ones included
+    void* Result = AllocateMemory((Size > 0) ? Size : 1);
+#ifndef _WIN32
+    if (!Result)
+    {
+        throw std::bad_alloc();
+    }
+#endif
+
+    return Result;
+}
 
 void* operator new(size_t sz)
 {
-    return VirtualAlloc(0, sz, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    return AllocateOrFail(sz);
 }
 
 void* operator new[](size_t sz)
 {
-    return VirtualAlloc(0, sz, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    return AllocateOrFail(sz);
 }
 
-void operator delete(void* ptr)
+void operator delete(void* ptr) noexcept
 {
-    VirtualFree(ptr, 0, MEM_RELEASE);
+    FreeMemory(ptr);
 }
 
-void operator delete[](void* ptr, size_t Size)
+void operator delete(void* ptr, size_t Size) noexcept
 {
-    VirtualFree(ptr, 0, MEM_RELEASE);
+    FreeMemory(ptr);
 }
 
-void operator delete[](void* ptr)
+void operator delete[](void* ptr, size_t Size) noexcept
 {
-    VirtualFree(ptr, 0, MEM_RELEASE);
+    FreeMemory(ptr);
 }
 
-#pragma function(memset)
-void* memset(void* Address, int32_t Value, size_t Size)
+void operator delete[](void* ptr) noexcept
 {
-    int32_t* Temp = (int32_t*)Address;
-    while ((uint64_t)(Temp - (int32_t*)Address) < Size / sizeof(int32_t))
+    FreeMemory(ptr);
+}
+
+void* MemsetScalar(void* Address, int32_t Value, size_t Size)
+{
+    uint8_t* Destination = (uint8_t*)Address;
+    uint8_t* End = Destination + Size;
+
+    //Align to word and then store whole words of replicated byte
+    while (Destination < End && ((uintptr_t)Destination & (sizeof(uintptr_t) - 1)))
     {
-        *Temp = Value;
-        Temp++;
+        *Destination++ = (uint8_t)Value;
     }
 
-    uint64_t SizeReminder = Size % sizeof(int32_t);
-    switch (SizeReminder)
+    uintptr_t WordValue = (uintptr_t)(uint8_t)Value * ((uintptr_t)-1 / 0xFF);
+    while ((size_t)(End - Destination) >= sizeof(uintptr_t))
     {
-        case 3:
+        *(uintptr_t*)Destination = WordValue;
+        Destination += sizeof(uintptr_t);
+    }
+
+    while (Destination < End)
+    {
+        *Destination++ = (uint8_t)Value;
+    }
+
+    return Address;
+}
+
+void* MemsetSSE2(void* Address, int32_t Value, size_t Size)
+{
+    if (Size < 16)
+    {
+        return MemsetScalar(Address, Value, Size);
+    }
+
+    uint8_t* Destination = (uint8_t*)Address;
+    uint8_t* End = Destination + Size;
+    __m128i Fill = _mm_set1_epi8((char)Value);
+
+    //Unaligned head, then aligned body and an unaligned tail overlapping the body
+    _mm_storeu_si128((__m128i*)Destination, Fill);
+    Destination = (uint8_t*)(((uintptr_t)Destination + 16) & ~(uintptr_t)15);
+
+    if (Size >= NonTemporalThreshold)
+    {
+        for (; Destination + 64 <= End; Destination += 64)
         {
-            *(char*)Temp = (char)Value;
-            (char*)Temp++;
+            _mm_stream_si128((__m128i*)Destination, Fill);
+            _mm_stream_si128((__m128i*)(Destination + 16), Fill);
+            _mm_stream_si128((__m128i*)(Destination + 32), Fill);
+            _mm_stream_si128((__m128i*)(Destination + 48), Fill);
         }
-        case 2:
+        _mm_sfence();
+    }
+
+    for (; Destination + 16 <= End; Destination += 16)
+    {
+        _mm_store_si128((__m128i*)Destination, Fill);
+    }
+
+    _mm_storeu_si128((__m128i*)(End - 16), Fill);
+
+    return Address;
+}
+
+TARGET_AVX2 void* MemsetAVX2(void* Address, int32_t Value, size_t Size)
+{
+    if (Size < 32)
+    {
+        return MemsetSSE2(Address, Value, Size);
+    }
+
+    uint8_t* Destination = (uint8_t*)Address;
+    uint8_t* End = Destination + Size;
+    __m256i Fill = _mm256_set1_epi8((char)Value);
+
+    _mm256_storeu_si256((__m256i*)Destination, Fill);
+    Destination = (uint8_t*)(((uintptr_t)Destination + 32) & ~(uintptr_t)31);
+
+    if (Size >= NonTemporalThreshold)
+    {
+        for (; Destination + 128 <= End; Destination += 128)
         {
-            *(char*)Temp = (char)Value;
-            (char*)Temp++;
+            _mm256_stream_si256((__m256i*)Destination, Fill);
+            _mm256_stream_si256((__m256i*)(Destination + 32), Fill);
+            _mm256_stream_si256((__m256i*)(Destination + 64), Fill);
+            _mm256_stream_si256((__m256i*)(Destination + 96), Fill);
         }
-        case 1:
+        _mm_sfence();
+    }
+
+    for (; Destination + 32 <= End; Destination += 32)
+    {
+        _mm256_store_si256((__m256i*)Destination, Fill);
+    }
+
+    _mm256_storeu_si256((__m256i*)(End - 32), Fill);
+
+    return Address;
+}
+
+void* MemcpyScalar(void* Destination, const void* Source, size_t Size)
+{
+    uint8_t* Target = (uint8_t*)Destination;
+    const uint8_t* From = (const uint8_t*)Source;
+    uint8_t* End = Target + Size;
+
+    while (Target < End && ((uintptr_t)Target & (sizeof(uintptr_t) - 1)))
+    {
+        *Target++ = *From++;
+    }
+
+    while ((size_t)(End - Target) >= sizeof(uintptr_t))
+    {
+        //Source may be unaligned, which x86 handles fine for plain loads
+        *(uintptr_t*)Target = *(const uintptr_t*)From;
+        Target += sizeof(uintptr_t);
+        From += sizeof(uintptr_t);
+    }
+
+    while (Target < End)
+    {
+        *Target++ = *From++;
+    }
+
+    return Destination;
+}
+
+void* MemcpySSE2(void* Destination, const void* Source, size_t Size)
+{
+    if (Size < 16)
+    {
+        return MemcpyScalar(Destination, Source, Size);
+    }
+
+    uint8_t* Target = (uint8_t*)Destination;
+    const uint8_t* From = (const uint8_t*)Source;
+    uint8_t* End = Target + Size;
+
+    //Tail is loaded up front, so it's copied correctly even though the body overlaps it
+    __m128i Tail = _mm_loadu_si128((const __m128i*)(From + Size - 16));
+    _mm_storeu_si128((__m128i*)Target, _mm_loadu_si128((const __m128i*)From));
+
+    size_t HeadSize = 16 - ((uintptr_t)Target & 15);
+    Target += HeadSize;
+    From += HeadSize;
+
+    if (Size >= NonTemporalThreshold)
+    {
+        for (; Target + 64 <= End; Target += 64, From += 64)
         {
-            *(char*)Temp = (char)Value;
-            (char*)Temp++;
+            __m128i First = _mm_loadu_si128((const __m128i*)From);
+            __m128i Second = _mm_loadu_si128((const __m128i*)(From + 16));
+            __m128i Third = _mm_loadu_si128((const __m128i*)(From + 32));
+            __m128i Fourth = _mm_loadu_si128((const __m128i*)(From + 48));
+            _mm_stream_si128((__m128i*)Target, First);
+            _mm_stream_si128((__m128i*)(Target + 16), Second);
+            _mm_stream_si128((__m128i*)(Target + 32), Third);
+            _mm_stream_si128((__m128i*)(Target + 48), Fourth);
         }
+        _mm_sfence();
     }
 
-    return Address;
+    for (; Target + 16 <= End; Target += 16, From += 16)
+    {
+        _mm_store_si128((__m128i*)Target, _mm_loadu_si128((const __m128i*)From));
+    }
+
+    _mm_storeu_si128((__m128i*)(End - 16), Tail);
+
+    return Destination;
 }
 
-static uint64_t s[2] = { 1, 1 };
+TARGET_AVX2 void* MemcpyAVX2(void* Destination, const void* Source, size_t Size)
+{
+    if (Size < 32)
+    {
+        return MemcpySSE2(Destination, Source, Size);
+    }
 
-uint64_t xoroshiro128plus(void)
+    uint8_t* Target = (uint8_t*)Destination;
+    const uint8_t* From = (const uint8_t*)Source;
+    uint8_t* End = Target + Size;
+
+    __m256i Tail = _mm256_loadu_si256((const __m256i*)(From + Size - 32));
+    _mm256_storeu_si256((__m256i*)Target, _mm256_loadu_si256((const __m256i*)From));
+
+    size_t HeadSize = 32 - ((uintptr_t)Target & 31);
+    Target += HeadSize;
+    From += HeadSize;
+
+    if (Size >= NonTemporalThreshold)
+    {
+        for (; Target + 128 <= End; Target += 128, From += 128)
+        {
+            __m256i First = _mm256_loadu_si256((const __m256i*)From);
+            __m256i Second = _mm256_loadu_si256((const __m256i*)(From + 32));
+            __m256i Third = _mm256_loadu_si256((const __m256i*)(From + 64));
+            __m256i Fourth = _mm256_loadu_si256((const __m256i*)(From + 96));
+            _mm256_stream_si256((__m256i*)Target, First);
+            _mm256_stream_si256((__m256i*)(Target + 32), Second);
+            _mm256_stream_si256((__m256i*)(Target + 64), Third);
+            _mm256_stream_si256((__m256i*)(Target + 96), Fourth);
+        }
+        _mm_sfence();
+    }
+
+    for (; Target + 32 <= End; Target += 32, From += 32)
+    {
+        _mm256_store_si256((__m256i*)Target, _mm256_loadu_si256((const __m256i*)From));
+    }
+
+    _mm256_storeu_si256((__m256i*)(End - 32), Tail);
+
+    return Destination;
+}
+
+#ifdef _WIN32
+typedef void* (*MemsetFunction)(void* Address, int32_t Value, size_t Size);
+typedef void* (*MemcpyFunction)(void* Destination, const void* Source, size_t Size);
+
+static void* MemsetResolve(void* Address, int32_t Value, size_t Size);
+static void* MemcpyResolve(void* Destination, const void* Source, size_t Size);
+
+//Kernels are picked on first call, memset can be called before any initialization code runs
+static MemsetFunction MemsetKernel = MemsetResolve;
+static MemcpyFunction MemcpyKernel = MemcpyResolve;
+
+static void* MemsetResolve(void* Address, int32_t Value, size_t Size)
+{
+    const CPUFeatures& Features = GetCPUFeatures();
+    MemsetKernel = Features.bHasAVX2 ? MemsetAVX2 : (Features.bHasSSE2 ? MemsetSSE2 : MemsetScalar);
+
+    return MemsetKernel(Address, Value, Size);
+}
+
+static void* MemcpyResolve(void* Destination, const void* Source, size_t Size)
+{
+    const CPUFeatures& Features = GetCPUFeatures();
+    MemcpyKernel = Features.bHasAVX2 ? MemcpyAVX2 : (Features.bHasSSE2 ? MemcpySSE2 : MemcpyScalar);
+
+    return MemcpyKernel(Destination, Source, Size);
+}
+
+#pragma function(memset)
+void* memset(void* Address, int32_t Value, size_t Size)
+{
+    return MemsetKernel(Address, Value, Size);
+}
+
+#pragma function(memcpy)
+void* memcpy(void* Destination, const void* Source, size_t Size)
+{
+    return MemcpyKernel(Destination, Source, Size);
+}
+#endif
+
+void RandomStream::Seed(uint64_t InSeed)
+{
+    State[0] = { 1 };
+    State[1] = InSeed;
+}
+
+uint64_t RandomStream::Next()
 {
     const auto rotl = [](const uint64_t x, int k) { return (x << k) | (x >> (64 - k)); };
 
-    const uint64_t s0 = s[0];
-    uint64_t s1 = s[1];
+    const uint64_t s0 = State[0];
+    uint64_t s1 = State[1];
     const uint64_t result = s0 + s1;
 
     s1 ^= s0;
-    s[0] = rotl(s0, 24) ^ s1 ^ (s1 << 16); // a, b
-    s[1] = rotl(s1, 37); // c
+    State[0] = rotl(s0, 24) ^ s1 ^ (s1 << 16); // a, b
+    State[1] = rotl(s1, 37); // c
 
     return result;
 }
 
+float RandomStream::NextFloat()
+{
+    union U { uint32_t I; float F; };
+    return U{ uint32_t{0x3F800000u} | (static_cast<uint32_t>(Next()) & ((uint32_t{1} << 23) - uint32_t{1})) }.F - 1.0f;
+}
+
+//Jump polynomials of the published xoroshiro128+ jump and long_jump functions
+static const uint64_t RandomJumpPolynomial[2] = { 0xdf900294d8f554a5ull, 0x170865df4b3201fcull };
+static const uint64_t RandomLongJumpPolynomial[2] = { 0xd2a98b26625eee7bull, 0xdddf9b1090aa7ac1ull };
+
+void RandomStream::ApplyJump(const uint64_t JumpPolynomial[2])
+{
+    uint64_t JumpState[2] = { 0, 0 };
+    for (uint32_t Word = 0; Word < 2; Word++)
+    {
+        //Bits are shifted out one at a time, variable 64 bit shifts would need a CRT helper in the 32 bit build
+        uint64_t Bits = JumpPolynomial[Word];
+        for (uint32_t Bit = 0; Bit < 64; Bit++)
+        {
+            if (Bits & 1)
+            {
+                JumpState[0] ^= State[0];
+                JumpState[1] ^= State[1];
+            }
+            Bits >>= 1;
+            Next();
+        }
+    }
+
+    State[0] = JumpState[0];
+    State[1] = JumpState[1];
+}
+
+void RandomStream::Jump()
+{
+    ApplyJump(RandomJumpPolynomial);
+}
+
+void RandomStream::LongJump()
+{
+    ApplyJump(RandomLongJumpPolynomial);
+}
+
+static RandomStream GlobalRandom;
+
+uint64_t xoroshiro128plus(void)
+{
+    return GlobalRandom.Next();
+}
+
 void SeedRandom(uint64_t Seed)
 {
-    s[0] = { 1 };
-    s[1] = Seed;
+    GlobalRandom.Seed(Seed);
 }
 
 float RandomFloat()
 {
-    union U { uint32_t I; float F; };
-    return U{ uint32_t{0x3F800000u} | static_cast<uint32_t>(xoroshiro128plus()) & ((uint32_t{1} << 23) - uint32_t{1}) }.F - 1.0f;
+    return GlobalRandom.NextFloat();
+}
+
+static void QueryCPUID(uint32_t Leaf, uint32_t SubLeaf, uint32_t Registers[4])
+{
+#if defined(_MSC_VER)
+    __cpuidex((int*)Registers, (int)Leaf, (int)SubLeaf);
+#else
+    __cpuid_count(Leaf, SubLeaf, Registers[0], Registers[1], Registers[2], Registers[3]);
+#endif
+}
+
+static uint64_t QueryEnabledXSaveFeatures()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t Low;
+    uint32_t High;
+    __asm__ volatile("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+    return ((uint64_t)High << 32) | Low;
+#endif
+}
+
+static CPUFeatures DetectedFeatures = {};
+static bool bFeaturesDetected = false;
+
+const CPUFeatures& GetCPUFeatures()
+{
+    //Detection is idempotent, so if two threads race here they just write the same values
+    if (bFeaturesDetected)
+    {
+        return DetectedFeatures;
+    }
+
+    uint32_t Registers[4];
+    QueryCPUID(0, 0, Registers);
+    uint32_t MaxLeaf = Registers[0];
+
+    if (MaxLeaf >= 1)
+    {
+        QueryCPUID(1, 0, Registers);
+        DetectedFeatures.bHasSSE2 = (Registers[3] & (1u << 26)) != 0;
+
+        //AVX2 also needs the OS to save YMM registers on context switch, checked through OSXSAVE and XCR0
+        bool bOSSavesYMM = false;
+        if ((Registers[2] & (1u << 27)) && (Registers[2] & (1u << 28)))
+        {
+            bOSSavesYMM = (QueryEnabledXSaveFeatures() & 0x6) == 0x6;
+        }
+
+        if (bOSSavesYMM && MaxLeaf >= 7)
+        {
+            QueryCPUID(7, 0, Registers);
+            DetectedFeatures.bHasAVX2 = (Registers[1] & (1u << 5)) != 0;
+        }
+    }
+
+    bFeaturesDetected = true;
+
+    return DetectedFeatures;
 }
\ No newline at end of file
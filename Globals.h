@@ -1,23 +1,109 @@
 #pragma once
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN 1
 #include "Windows.h"
 #undef WIN32_LEAN_AND_MEAN
+#endif
 
+#include <stddef.h>
 #include <stdint.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+//Screen saver is built without CRT, allocation and memory functions are provided by Globals.cpp
+//Allocations go through MemoryArena.h on every platform, to the calling thread's arena if it has one
 void* operator new(size_t sz);
 void* operator new[](size_t sz);
-void operator delete(void* ptr);
-void operator delete[](void* ptr, size_t Size);
-void operator delete[](void* ptr);
+void operator delete(void* ptr) noexcept;
+void operator delete(void* ptr, size_t Size) noexcept;
+void operator delete[](void* ptr, size_t Size) noexcept;
+void operator delete[](void* ptr) noexcept;
 
-//Most likely way slower than intrinsic version
+//Dispatched at first call to the widest kernel CPU supports
 void* memset(void* Address, int32_t Value, size_t Size);
 #pragma intrinsic(memset)
+void* memcpy(void* Destination, const void* Source, size_t Size);
+#pragma intrinsic(memcpy)
+#else
+#include <string.h>
+#endif
+
+//Fills and copies bigger than this bypass the cache, so clearing the whole framebuffer doesn't evict everything else
+static const size_t NonTemporalThreshold = 4 * 1024 * 1024;
+
+//Kernels behind memset and memcpy, exposed for benchmarking, SIMD versions must only be called if GetCPUFeatures reports support
+void* MemsetScalar(void* Address, int32_t Value, size_t Size);
+void* MemsetSSE2(void* Address, int32_t Value, size_t Size);
+void* MemsetAVX2(void* Address, int32_t Value, size_t Size);
+void* MemcpyScalar(void* Destination, const void* Source, size_t Size);
+void* MemcpySSE2(void* Destination, const void* Source, size_t Size);
+void* MemcpyAVX2(void* Destination, const void* Source, size_t Size);
 
 // From http://xoroshiro.di.unimi.it/xoroshiro128plus.c
+//Generator state is not shared, every thread drawing random numbers owns its own stream
+struct RandomStream
+{
+    uint64_t State[2] = { 1, 1 };
+
+    void Seed(uint64_t InSeed);
+    uint64_t Next();
+    //Uniform float in [0, 1)
+    float NextFloat();
+
+    //Advance the stream by 2^64 and 2^96 draws, for splitting it into streams which don't overlap
+    void Jump();
+    void LongJump();
+
+private:
+    void ApplyJump(const uint64_t JumpPolynomial[2]);
+};
+
+//Process wide stream, only used from the window thread, e.g. to seed per thread streams
 uint64_t xoroshiro128plus(void);
 
 void SeedRandom(uint64_t Seed);
-float RandomFloat();
\ No newline at end of file
+float RandomFloat();
+
+//Instruction set extensions which have a vectorized code path, detected once through CPUID
+struct CPUFeatures
+{
+    bool bHasSSE2;
+    bool bHasAVX2;
+};
+
+const CPUFeatures& GetCPUFeatures();
+
+//AVX2 code paths are compiled per function and only called after checking GetCPUFeatures
+#if defined(_MSC_VER)
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+//Index of the lowest set bit, Value must not be 0
+inline uint32_t FindLowestSetBit(uint32_t Value)
+{
+#if defined(_MSC_VER)
+    unsigned long Index;
+    _BitScanForward(&Index, Value);
+    return (uint32_t)Index;
+#else
+    return (uint32_t)__builtin_ctz(Value);
+#endif
+}
+
+//Index of the highest set bit, Value must not be 0
+inline uint32_t FindHighestSetBit(uint32_t Value)
+{
+#if defined(_MSC_VER)
+    unsigned long Index;
+    _BitScanReverse(&Index, Value);
+    return (uint32_t)Index;
+#else
+    return 31 - (uint32_t)__builtin_clz(Value);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,1261 @@
+//Headless benchmark, drives World and CPURenderer for a fixed number of frames without a window and reports frame cost as JSON
+//Monitors are described with layout strings instead of being enumerated, every monitor is ticked on the calling thread one after another
+
+#include "Globals.h"
+#include "Platform.h"
+#include "CPURenderer.h"
+#include "PresentThread.h"
+#include "World.h"
+#include "MonitorLayout.h"
+#include "Benchmark.h"
+#include "FrameProfiler.h"
+#include "FrameTimer.h"
+#include "MemoryArena.h"
+#include "Visibility.h"
+#include "Settings.h"
+#include "QualityGovernor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char DefaultLayout[] = "1920x1080+0+0";
+static const char DefaultReportPath[] = "StarryNightHeadless.json";
+
+//Every option can be given multiple times, all combinations of the given values are benchmarked
+struct HeadlessOptions
+{
+    static const uint32_t MaxValues = 16;
+
+    const char* Layouts[MaxValues];
+    uint32_t LayoutCount = 0;
+    uint32_t StarCounts[MaxValues];
+    uint32_t StarCountCount = 0;
+    uint32_t SizeMaxes[MaxValues];
+    uint32_t SizeMaxCount = 0;
+    float DeltaTimes[MaxValues];
+    uint32_t DeltaTimeCount = 0;
+    uint32_t RenderScales[MaxValues];
+    uint32_t RenderScaleCount = 0;
+
+    uint32_t FrameCount = 600;
+    uint32_t WarmupFrameCount = 30;
+    uint32_t RasterWorkerCount = WorkerPool::GetDefaultWorkerCount();
+    //0 runs frames back to back, otherwise frames are paced like in the screen saver
+    uint32_t PacedFrameRate = 0;
+    //Only update worlds in frames which wouldn't change their image, like the screen saver does
+    bool bSkipUnchangedFrames = false;
+    //Present every monitor on a thread of its own while the next frame is built, like the screen saver does
+    bool bUsePresentThreads = false;
+    //Blur a halo around stars after they're drawn, within the renderer's default per frame budget
+    bool bGlow = false;
+    //Monitor pixels per second the sky pans left by, right if negative
+    int32_t DriftSpeed = 0;
+    //Hundredths of a percent of one core every monitor may use, a governor per monitor lowers quality to stay within it, 0 turns it off
+    uint32_t CPUBudget = 0;
+    //Runs fail when more than this many pixels per pixel drawn are cleared or presented, 0 doesn't check
+    uint32_t MaxDamageRatio = 0;
+    //0 allocates from the OS, 1 from an arena reserved once and rewound per run like the screen saver's, 2 backs the arena with large pages
+    uint32_t ArenaMode = 1;
+    //Monitors are resized in place to this layout halfway through the measured frames, like the screen saver does on display changes
+    const char* ResizeLayout = nullptr;
+    //Visibility events fed to a tracker like the screen saver's window messages, all monitors are parked while it says nothing is seen
+    const char* VisibilityScript = nullptr;
+    uint64_t RandomSeed = 1;
+    const char* ReportPath = DefaultReportPath;
+    //Same schema as the screen saver's registry values, star sizes, lifetimes and the defaults of the options above come from it
+    const char* SettingsPath = nullptr;
+    SettingsSnapshot Settings = GetDefaultSettings();
+
+    //Replay, see ReplayState
+    const char* DeltaTimeSequencePath = nullptr;
+    const char* HashLogPath = nullptr;
+    const char* GoldenHashPath = nullptr;
+};
+
+//Frames are numbered across runs in the order they're made, warm up frames included, so a hash log of a whole invocation is a golden file for the same options
+struct ReplayState
+{
+    //Cycled over frames instead of a fixed delta time
+    float* DeltaTimes = nullptr;
+    uint32_t DeltaTimeCount = 0;
+    uint64_t* GoldenHashes = nullptr;
+    uint32_t GoldenHashCount = 0;
+
+    uint32_t HashedFrameCount = 0;
+    uint32_t MismatchCount = 0;
+    ReportWriter HashLog;
+};
+
+static const uint32_t MaxReportedMismatches = 10;
+
+//Shared by all runs, stays registered until the process exits so blocks freed late are still recognized
+static MemoryArena g_Arena;
+
+struct HeadlessRun
+{
+    const char* Layout;
+    uint32_t StarCount;
+    uint32_t SizeMax;
+    float DeltaTime;
+    //Setting like the screen saver's, resolved per monitor with GetRenderScale
+    uint32_t RenderScale;
+};
+
+//Whole file with a terminating zero, nullptr if it can't be read
+static char* ReadTextFile(const char* Path)
+{
+    FILE* File = fopen(Path, "rb");
+    if (!File)
+    {
+        return nullptr;
+    }
+
+    char* Text = nullptr;
+    if (fseek(File, 0, SEEK_END) == 0)
+    {
+        long Size = ftell(File);
+        if (Size >= 0 && fseek(File, 0, SEEK_SET) == 0)
+        {
+            Text = new char[Size + 1];
+            if (fread(Text, 1, (size_t)Size, File) != (size_t)Size)
+            {
+                delete[] Text;
+                Text = nullptr;
+            }
+            else
+            {
+                Text[Size] = 0;
+            }
+        }
+    }
+    fclose(File);
+
+    return Text;
+}
+
+//Calls Parse with every line which isn't empty or a comment, stops at the first line it rejects
+template<typename ParseFunction>
+static bool ForEachLine(char* Text, ParseFunction Parse)
+{
+    char* Line = Text;
+    while (*Line)
+    {
+        char* LineEnd = Line;
+        while (*LineEnd && *LineEnd != '\n')
+        {
+            LineEnd++;
+        }
+        bool bIsLast = *LineEnd == 0;
+        *LineEnd = 0;
+
+        while (*Line == ' ' || *Line == '\t' || *Line == '\r')
+        {
+            Line++;
+        }
+        if (*Line && *Line != '#' && !Parse(Line))
+        {
+            return false;
+        }
+
+        if (bIsLast)
+        {
+            break;
+        }
+        Line = LineEnd + 1;
+    }
+
+    return true;
+}
+
+//Settings only seed the defaults, ParseOptions reads the file before looking at any other option
+static bool LoadSettingsFile(const char* Path, SettingsSnapshot& Settings)
+{
+    char* Text = ReadTextFile(Path);
+    if (!Text)
+    {
+        return false;
+    }
+
+    bool bIsValid = ForEachLine(Text, [&Settings](char* Line)
+    {
+        return ParseSettingLine(Line, Settings);
+    });
+    delete[] Text;
+
+    return bIsValid;
+}
+
+static void PrintUsage()
+{
+    printf(
+        "Usage: StarryNightHeadless [options]\n"
+        "  -l LAYOUT   monitor layout, comma separated WIDTHxHEIGHT+LEFT+TOP entries with optional @DPI (default %s)\n"
+        "  -s COUNT    total star count, split between monitors by area (default %u)\n"
+        "  -z SIZE     largest initial star size at full resolution, scaled down with the render scale (default %u)\n"
+        "  -d SECONDS  fixed frame delta time (default 1/15)\n"
+        "  -c SCALE    render at 1/SCALE of every monitor's resolution and stretch it on present, 1 to %u, 0 picks it from @DPI (default 1)\n"
+        "  -f FRAMES   measured frames per run (default 600)\n"
+        "  -w FRAMES   unmeasured warm up frames per run (default 30)\n"
+        "  -t WORKERS  raster worker threads beside the calling thread (default one per extra processor)\n"
+        "  -p FPS      pace frames to FPS frames per second like the screen saver does (default off)\n"
+        "  -e 0|1      skip clearing, rendering and presenting frames which wouldn't change the image (default 0)\n"
+        "  -y 0|1      present on a thread per monitor, frames not presented before the next one is ready are dropped (default 0)\n"
+        "  -b 0|1      draw a blurred halo around stars (default 0)\n"
+        "  -m SPEED    pan the sky left by SPEED monitor pixels per second, right if negative, up to %d (default 0)\n"
+        "  -n BUDGET   keep every monitor within BUDGET hundredths of a percent of one core by lowering star count, spawn rate,\n"
+        "              render scale and frame rate, lower frame rates draw monitors only every few frames (default 0, off)\n"
+        "  -a 0|1|2    allocate from the OS, from a prefaulted arena rewound every run, or from an arena on large pages (default 1)\n"
+        "  -k LAYOUT   resize monitors in place to LAYOUT halfway through the measured frames, it needs as many monitors as -l\n"
+        "  -v EVENTS   comma separated FRAME:EVENT visibility changes, events are show, hide, expose, occlude, on and off\n"
+        "              frames count from the first warm up frame of every run, monitors are parked while hidden\n"
+        "  -r SEED     random seed (default 1)\n"
+        "  -o PATH     JSON report path (default %s)\n"
+        "  -u PATH     read settings from PATH, one NAME = VALUE line per setting with the screen saver's registry value names\n"
+        "              they are the defaults of the other options, which override them wherever they're given\n"
+        "  -q PATH     replay delta times from PATH, one per line, cycled over frames, instead of -d\n"
+        "  -x PATH     write a hash of every frame's render buffers to PATH, one per line\n"
+        "  -g PATH     compare frame hashes against a file written by -x, exits with 1 on any difference\n"
+        "  -j RATIO    exit with 1 if a run clears or presents more than RATIO pixels per frame for every pixel drawn (default 0, off)\n"
+        "-l, -s, -z, -d and -c can be repeated, every combination of their values is a separate run\n"
+        "Lines starting with # are ignored in -q, -g and -u files\n",
+        DefaultLayout, World::DefaultStarCount, DefaultStarSizeMax, MaxRenderScale, World::MaxDriftSpeed, DefaultReportPath);
+}
+
+static bool ParseOptions(int ArgumentCount, char** Arguments, HeadlessOptions& Options)
+{
+    //Layouts given on the command line have no DPI unless it's written out, so runs stay at full resolution unless settings ask otherwise
+    Options.Settings.Set(SettingRenderScale, 1);
+    for (int Index = 1; Index + 1 < ArgumentCount; Index += 2)
+    {
+        if (strcmp(Arguments[Index], "-u") == 0)
+        {
+            Options.SettingsPath = Arguments[Index + 1];
+        }
+    }
+    if (Options.SettingsPath && !LoadSettingsFile(Options.SettingsPath, Options.Settings))
+    {
+        fprintf(stderr, "Failed to read settings from %s\n", Options.SettingsPath);
+        return false;
+    }
+
+    const SettingsSnapshot& Settings = Options.Settings;
+    if (Settings.Get(SettingRasterThreads) != 0)
+    {
+        Options.RasterWorkerCount = Settings.Get(SettingRasterThreads) - 1;
+    }
+    Options.DriftSpeed = (int32_t)Settings.Get(SettingDriftSpeed);
+    Options.CPUBudget = Settings.Get(SettingCPUBudget);
+    Options.ArenaMode = Settings.IsEnabled(SettingLargePages) ? 2 : Options.ArenaMode;
+
+    for (int Index = 1; Index < ArgumentCount; Index++)
+    {
+        const char* Option = Arguments[Index];
+        if (Option[0] != '-' || Option[1] == 0 || Option[2] != 0 || Index + 1 >= ArgumentCount)
+        {
+            return false;
+        }
+
+        const char* Value = Arguments[++Index];
+        switch (Option[1])
+        {
+            case 'l':
+            {
+                if (Options.LayoutCount >= HeadlessOptions::MaxValues)
+                {
+                    return false;
+                }
+                Options.Layouts[Options.LayoutCount++] = Value;
+            } break;
+
+            case 's':
+            {
+                if (Options.StarCountCount >= HeadlessOptions::MaxValues)
+                {
+                    return false;
+                }
+                Options.StarCounts[Options.StarCountCount++] = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 'z':
+            {
+                if (Options.SizeMaxCount >= HeadlessOptions::MaxValues)
+                {
+                    return false;
+                }
+                Options.SizeMaxes[Options.SizeMaxCount++] = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 'd':
+            {
+                if (Options.DeltaTimeCount >= HeadlessOptions::MaxValues)
+                {
+                    return false;
+                }
+                Options.DeltaTimes[Options.DeltaTimeCount++] = strtof(Value, nullptr);
+            } break;
+
+            case 'c':
+            {
+                uint32_t RenderScale = (uint32_t)strtoul(Value, nullptr, 10);
+                if (Options.RenderScaleCount >= HeadlessOptions::MaxValues || RenderScale > MaxRenderScale)
+                {
+                    return false;
+                }
+                Options.RenderScales[Options.RenderScaleCount++] = RenderScale;
+            } break;
+
+            case 'f':
+            {
+                Options.FrameCount = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 'w':
+            {
+                Options.WarmupFrameCount = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 't':
+            {
+                Options.RasterWorkerCount = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 'p':
+            {
+                Options.PacedFrameRate = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 'e':
+            {
+                Options.bSkipUnchangedFrames = strtoul(Value, nullptr, 10) != 0;
+            } break;
+
+            case 'y':
+            {
+                Options.bUsePresentThreads = strtoul(Value, nullptr, 10) != 0;
+            } break;
+
+            case 'b':
+            {
+                Options.bGlow = strtoul(Value, nullptr, 10) != 0;
+            } break;
+
+            case 'm':
+            {
+                Options.DriftSpeed = (int32_t)strtol(Value, nullptr, 10);
+                if (Options.DriftSpeed < -World::MaxDriftSpeed || Options.DriftSpeed > World::MaxDriftSpeed)
+                {
+                    return false;
+                }
+            } break;
+
+            case 'n':
+            {
+                Options.CPUBudget = (uint32_t)strtoul(Value, nullptr, 10);
+                if (Options.CPUBudget > GetSettingDefinition(SettingCPUBudget).MaxValue)
+                {
+                    return false;
+                }
+            } break;
+
+            case 'a':
+            {
+                Options.ArenaMode = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 'k':
+            {
+                Options.ResizeLayout = Value;
+            } break;
+
+            case 'v':
+            {
+                Options.VisibilityScript = Value;
+            } break;
+
+            case 'r':
+            {
+                Options.RandomSeed = strtoull(Value, nullptr, 10);
+            } break;
+
+            case 'o':
+            {
+                Options.ReportPath = Value;
+            } break;
+
+            case 'q':
+            {
+                Options.DeltaTimeSequencePath = Value;
+            } break;
+
+            case 'j':
+            {
+                Options.MaxDamageRatio = (uint32_t)strtoul(Value, nullptr, 10);
+            } break;
+
+            case 'x':
+            {
+                Options.HashLogPath = Value;
+            } break;
+
+            case 'g':
+            {
+                Options.GoldenHashPath = Value;
+            } break;
+
+            //Read before the other options
+            case 'u':
+            {
+            } break;
+
+            default:
+            {
+                return false;
+            }
+        }
+    }
+
+    if (Options.LayoutCount == 0)
+    {
+        Options.Layouts[Options.LayoutCount++] = DefaultLayout;
+    }
+    if (Options.StarCountCount == 0)
+    {
+        Options.StarCounts[Options.StarCountCount++] = Settings.Get(SettingMaxStarCount);
+    }
+    if (Options.SizeMaxCount == 0)
+    {
+        Options.SizeMaxes[Options.SizeMaxCount++] = Settings.Get(SettingStarSizeMax);
+    }
+    //Skipping unchanged frames predicts ahead with a fixed delta time, so it can't follow a sequence
+    if (Options.DeltaTimeSequencePath && (Options.DeltaTimeCount > 0 || Options.bSkipUnchangedFrames))
+    {
+        return false;
+    }
+    if (Options.DeltaTimeCount == 0)
+    {
+        Options.DeltaTimes[Options.DeltaTimeCount++] = 1.0f / (float)Settings.Get(SettingFrameRate);
+    }
+    if (Options.RenderScaleCount == 0)
+    {
+        Options.RenderScales[Options.RenderScaleCount++] = Settings.Get(SettingRenderScale);
+    }
+
+    return Options.FrameCount > 0 && Options.ArenaMode <= 2;
+}
+
+static bool LoadDeltaTimeSequence(const char* Path, ReplayState& Replay)
+{
+    char* Text = ReadTextFile(Path);
+    if (!Text)
+    {
+        return false;
+    }
+
+    //A line holds at least two characters, so half the file size bounds the count
+    uint32_t MaxCount = (uint32_t)strlen(Text) / 2 + 1;
+    Replay.DeltaTimes = new float[MaxCount];
+    bool bIsValid = ForEachLine(Text, [&Replay](char* Line)
+    {
+        char* End;
+        float DeltaTime = strtof(Line, &End);
+        if (End == Line || !(DeltaTime >= 0.0f))
+        {
+            return false;
+        }
+        Replay.DeltaTimes[Replay.DeltaTimeCount++] = DeltaTime;
+        return true;
+    });
+    delete[] Text;
+
+    return bIsValid && Replay.DeltaTimeCount > 0;
+}
+
+static bool LoadGoldenHashes(const char* Path, ReplayState& Replay)
+{
+    char* Text = ReadTextFile(Path);
+    if (!Text)
+    {
+        return false;
+    }
+
+    uint32_t MaxCount = (uint32_t)strlen(Text) / 2 + 1;
+    Replay.GoldenHashes = new uint64_t[MaxCount];
+    bool bIsValid = ForEachLine(Text, [&Replay](char* Line)
+    {
+        char* End;
+        uint64_t Hash = strtoull(Line, &End, 16);
+        if (End == Line)
+        {
+            return false;
+        }
+        Replay.GoldenHashes[Replay.GoldenHashCount++] = Hash;
+        return true;
+    });
+    delete[] Text;
+
+    return bIsValid;
+}
+
+//Folds monitor hashes into frame hashes and frame hashes into a run's output hash, order matters
+static uint64_t CombineHash(uint64_t Hash, uint64_t Value)
+{
+    return (Hash ^ Value) * 0x100000001B3ull;
+}
+
+//Reserves Arena for the run or rewinds it if it's big enough, it's committed and faulted in as part of the run's initialization
+static size_t PrepareArena(const HeadlessOptions& Options, const HeadlessRun& Run, const MonitorLayout& Layout, MemoryArena& Arena)
+{
+    uint32_t SurfaceWidth;
+    uint32_t SurfaceHeight;
+    Layout.GetBounds(SurfaceWidth, SurfaceHeight);
+
+    //Same slack for profilers, threads and reports as the screen saver gives every monitor
+    size_t Size = (size_t)SurfaceWidth * SurfaceHeight * sizeof(uint32_t) + 4 * 1024 * 1024;
+    for (uint32_t Index = 0; Index < Layout.Count; Index++)
+    {
+        uint32_t RenderWidth, RenderHeight;
+        GetRenderSize(Layout.Monitors[Index], GetRenderScale(Layout.Monitors[Index], Run.RenderScale), RenderWidth, RenderHeight);
+        uint32_t StarBudget = Layout.GetStarBudget(Index, Run.StarCount);
+        Size += CPURenderer::GetMemoryEstimate(RenderWidth, RenderHeight, StarBudget) + World::GetMemoryEstimate(StarBudget) + 1024 * 1024;
+    }
+
+    uint32_t Flags = ArenaPrefault | ((Options.ArenaMode == 2) ? ArenaLargePages : 0);
+    if (Arena.IsInitialized() && Arena.GetCapacity() < Size)
+    {
+        Arena.Release();
+    }
+    if (Arena.IsInitialized())
+    {
+        Arena.Reset();
+    }
+    else
+    {
+        Arena.Initialize(Size, Flags);
+    }
+
+    return Size;
+}
+
+static bool RunBenchmark(const HeadlessOptions& Options, const HeadlessRun& Run, WorkerPool& RasterPool, MemoryArena& Arena, ReplayState& Replay, ReportWriter& Report)
+{
+    MonitorLayout Layout;
+    if (!ParseMonitorLayout(Run.Layout, Layout))
+    {
+        fprintf(stderr, "Invalid layout \"%s\"\n", Run.Layout);
+        return false;
+    }
+
+    MonitorLayout ResizeLayout;
+    if (Options.ResizeLayout && (!ParseMonitorLayout(Options.ResizeLayout, ResizeLayout) || ResizeLayout.Count != Layout.Count))
+    {
+        fprintf(stderr, "Resize layout \"%s\" is invalid or doesn't have as many monitors as \"%s\"\n", Options.ResizeLayout, Run.Layout);
+        return false;
+    }
+
+    VisibilityScript Visibility;
+    if (Options.VisibilityScript && !ParseVisibilityScript(Options.VisibilityScript, Visibility))
+    {
+        fprintf(stderr, "Invalid visibility events \"%s\"\n", Options.VisibilityScript);
+        return false;
+    }
+
+    //Initialization is everything up to the first frame, like an update thread's after a display change
+    uint64_t InitializationStartTicks = PlatformGetTicks();
+    uint64_t StartPageFaultCount = PlatformGetPageFaultCount();
+    uint32_t StartOSCallCount = GetHeapStats().OSCallCount;
+    if (Options.ArenaMode > 0)
+    {
+        size_t ArenaSize = PrepareArena(Options, Run, Layout, Arena);
+        if (Arena.IsInitialized())
+        {
+            Arena.Commit(ArenaSize);
+            SetThreadArena(&Arena);
+        }
+    }
+
+    //Surface stands in for the screen saver window covering all monitors, before and after resizing
+    PresentSurface Surface;
+    Layout.GetBounds(Surface.Width, Surface.Height);
+    if (Options.ResizeLayout)
+    {
+        uint32_t ResizeWidth;
+        uint32_t ResizeHeight;
+        ResizeLayout.GetBounds(ResizeWidth, ResizeHeight);
+        Surface.Width = (ResizeWidth > Surface.Width) ? ResizeWidth : Surface.Width;
+        Surface.Height = (ResizeHeight > Surface.Height) ? ResizeHeight : Surface.Height;
+    }
+    Surface.Pixels = new uint32_t[Surface.Width * Surface.Height];
+    memset(Surface.Pixels, 0, Surface.Width * Surface.Height * sizeof(*Surface.Pixels));
+
+    //Seeds are drawn the same way as in the screen saver, one per monitor from a single generator
+    RandomStream SeedStream;
+    SeedStream.Seed(Options.RandomSeed);
+
+    //Timer only waits for paced runs, its profiler records every measured frame and percentiles cover the last FrameProfiler::HistoryFrameCount of them
+    FrameTimer Timer = { Options.PacedFrameRate ? 1.0f / (float)Options.PacedFrameRate : 1.0f };
+    FrameProfiler& Profiler = Timer.Profiler;
+
+    World* Worlds[MonitorLayout::MaxMonitors];
+    CPURenderer* Renderers[MonitorLayout::MaxMonitors];
+    PresentThread* Presenters[MonitorLayout::MaxMonitors] = {};
+    //Every monitor is governed on its own like an update thread of the screen saver, levels start at full quality every run
+    QualityGovernor Governors[MonitorLayout::MaxMonitors] = {};
+    uint32_t RenderScales[MonitorLayout::MaxMonitors];
+    uint64_t GovernedPresentCPUTicks[MonitorLayout::MaxMonitors] = {};
+    const MonitorLayout* CurrentLayout = &Layout;
+    for (uint32_t Index = 0; Index < Layout.Count; Index++)
+    {
+        const MonitorRect& Monitor = Layout.Monitors[Index];
+        uint32_t RenderScale = GetRenderScale(Monitor, Run.RenderScale);
+        RenderScales[Index] = RenderScale;
+        Governors[Index].SetBudget(Options.CPUBudget, PlatformGetTickFrequency());
+        uint32_t RenderWidth, RenderHeight;
+        GetRenderSize(Monitor, RenderScale, RenderWidth, RenderHeight);
+
+        Worlds[Index] = new World(RenderWidth, RenderHeight, Layout.GetStarBudget(Index, Run.StarCount), SeedStream.Next());
+        Worlds[Index]->SetStarSizeMax(World::GetScaledStarSizeMax(Run.SizeMax, RenderScale));
+        Worlds[Index]->SetLifetimeRange(Options.Settings.Get(SettingMinLifetime), Options.Settings.Get(SettingMaxLifetime));
+        Worlds[Index]->SetDriftSpeed(World::GetScaledDriftSpeed(Options.DriftSpeed, RenderScale));
+
+        Renderers[Index] = new CPURenderer(RenderWidth, RenderHeight);
+        Renderers[Index]->SetPresentOffset(Monitor.Left, Monitor.Top);
+        Renderers[Index]->SetPresentScale(RenderScale);
+        Renderers[Index]->SetGlowEnabled(Options.bGlow);
+        Renderers[Index]->SetProfiler(&Profiler);
+        if (RasterPool.GetWorkerCount() > 0)
+        {
+            Renderers[Index]->SetRasterPool(&RasterPool);
+        }
+
+        if (Options.bUsePresentThreads)
+        {
+            Presenters[Index] = new PresentThread(*Renderers[Index], Surface);
+        }
+    }
+
+    double InitializationMilliseconds = (double)(PlatformGetTicks() - InitializationStartTicks) * 1000.0 / (double)PlatformGetTickFrequency();
+    uint64_t InitializationPageFaultCount = PlatformGetPageFaultCount() - StartPageFaultCount;
+    uint32_t InitializationOSCallCount = GetHeapStats().OSCallCount - StartOSCallCount;
+    uint64_t StartFramePageFaultCount = 0;
+    uint32_t StartFrameOSCallCount = 0;
+
+    const uint32_t ResizeFrame = Options.WarmupFrameCount + Options.FrameCount / 2;
+    uint64_t ResizeStartTicks = 0;
+    uint64_t ResizeTicks = 0;
+    uint64_t ResizeLatencyTicks = 0;
+    uint32_t ResizeDroppedStars = 0;
+
+    VisibilityTracker Tracker = {};
+    uint32_t NextVisibilityEvent = 0;
+    uint32_t ParkCount = 0;
+    uint32_t ParkedFrameCount = 0;
+    //World time skipped by the current park, and by all of them
+    float ParkedSeconds = 0.0f;
+    double TotalParkedSeconds = 0.0;
+
+    double FrameSeconds = 0.0;
+    double StartSpinSeconds = 0.0;
+
+    uint64_t ClearTicks = 0;
+    uint64_t TickRenderTicks = 0;
+    uint64_t PresentTicks = 0;
+    //Per monitor count of following frames which only need a world update
+    uint32_t UnchangedFrameCounts[MonitorLayout::MaxMonitors] = {};
+    uint32_t SkippedFrameCount = 0;
+    RenderStats StartStats = {};
+    RenderStats EndStats = {};
+    uint32_t StartPresentedFrameCounts[MonitorLayout::MaxMonitors] = {};
+    uint32_t StartPublishedFrameCounts[MonitorLayout::MaxMonitors] = {};
+    uint64_t OutputHash = 0xCBF29CE484222325ull;
+
+    //Keeps the world and renderer like the screen saver does for display changes and the governor's render scales, returns the stars dropped
+    auto ResizeMonitor = [&](uint32_t Index, const MonitorRect& Monitor, uint32_t RenderScale)
+    {
+        uint32_t RenderWidth, RenderHeight;
+        GetRenderSize(Monitor, RenderScale, RenderWidth, RenderHeight);
+        if (Presenters[Index])
+        {
+            Presenters[Index]->WaitUntilIdle();
+        }
+        Renderers[Index]->Resize(RenderWidth, RenderHeight);
+        Renderers[Index]->SetPresentOffset(Monitor.Left, Monitor.Top);
+        Renderers[Index]->SetPresentScale(RenderScale);
+        uint32_t DroppedStars = Worlds[Index]->Resize(RenderWidth, RenderHeight);
+        Worlds[Index]->SetStarSizeMax(World::GetScaledStarSizeMax(Run.SizeMax, RenderScale));
+        Worlds[Index]->SetDriftSpeed(World::GetScaledDriftSpeed(Options.DriftSpeed, RenderScale));
+        UnchangedFrameCounts[Index] = 0;
+        RenderScales[Index] = RenderScale;
+        return DroppedStars;
+    };
+
+    //Feeds the CPU time a monitor took this frame to its governor and applies a new level right away, frames stand for the delta time
+    uint64_t TickFrequency = PlatformGetTickFrequency();
+    auto GovernMonitor = [&](uint32_t Index, uint64_t CostTicks, float DeltaTime)
+    {
+        if (Presenters[Index])
+        {
+            uint64_t PresentCPUTicks = Presenters[Index]->GetTotalPresentCPUTicks();
+            CostTicks += PresentCPUTicks - GovernedPresentCPUTicks[Index];
+            GovernedPresentCPUTicks[Index] = PresentCPUTicks;
+        }
+
+        QualityGovernor& Governor = Governors[Index];
+        if (!Governor.AddFrame(CostTicks, (uint64_t)((double)DeltaTime * (double)TickFrequency)))
+        {
+            return;
+        }
+
+        Worlds[Index]->SetStarBudget(Governor.GetStarBudget(Layout.GetStarBudget(Index, Run.StarCount)));
+        Worlds[Index]->SetSpawnRateDivisor(Governor.GetQuality().SpawnRateDivisor);
+        const MonitorRect& Monitor = CurrentLayout->Monitors[Index];
+        uint32_t RenderScale = Governor.GetRenderScale(GetRenderScale(Monitor, Run.RenderScale));
+        if (RenderScale != RenderScales[Index])
+        {
+            ResizeMonitor(Index, Monitor, RenderScale);
+        }
+        UnchangedFrameCounts[Index] = 0;
+    };
+
+    if (Options.HashLogPath)
+    {
+        //Hash log outlives the run, it mustn't be rewound with the arena
+        ThreadArenaScope HashLogScope = { nullptr };
+        Replay.HashLog.Append("# ");
+        Replay.HashLog.Append(Run.Layout);
+        Replay.HashLog.Append(" stars ");
+        Replay.HashLog.AppendUInt(Run.StarCount);
+        Replay.HashLog.Append(" size max ");
+        Replay.HashLog.AppendUInt(Run.SizeMax);
+        Replay.HashLog.Append(" scale ");
+        Replay.HashLog.AppendUInt(Run.RenderScale);
+        Replay.HashLog.Append(" dt ");
+        if (Replay.DeltaTimeCount)
+        {
+            Replay.HashLog.Append(Options.DeltaTimeSequencePath);
+        }
+        else
+        {
+            Replay.HashLog.AppendFloat(Run.DeltaTime, 6);
+        }
+        Replay.HashLog.Append("\n");
+    }
+
+    for (uint32_t Frame = 0; Frame < Options.WarmupFrameCount + Options.FrameCount; Frame++)
+    {
+        bool bIsMeasured = Frame >= Options.WarmupFrameCount;
+        uint64_t FrameStartTicks = PlatformGetTicks();
+        float DeltaTime = Replay.DeltaTimeCount ? Replay.DeltaTimes[Frame % Replay.DeltaTimeCount] : Run.DeltaTime;
+        if (Frame == Options.WarmupFrameCount)
+        {
+            StartSpinSeconds = Timer.GetSpinSeconds();
+            StartFramePageFaultCount = PlatformGetPageFaultCount();
+            StartFrameOSCallCount = GetHeapStats().OSCallCount;
+
+            for (uint32_t Index = 0; Index < Layout.Count; Index++)
+            {
+                if (Presenters[Index])
+                {
+                    Presenters[Index]->WaitUntilIdle();
+                    Presenters[Index]->Profiler.DiscardFrame();
+                    StartPresentedFrameCounts[Index] = Presenters[Index]->GetPresentedFrameCount();
+                    StartPublishedFrameCounts[Index] = Presenters[Index]->GetPublishedFrameCount();
+                }
+
+                const RenderStats& Stats = Renderers[Index]->GetStats();
+                StartStats.ClearedPixels += Stats.ClearedPixels;
+                StartStats.DrawnPixels += Stats.DrawnPixels;
+                StartStats.PresentedPixels += Stats.PresentedPixels;
+                StartStats.GlowPixels += Stats.GlowPixels;
+                StartStats.GlowSkippedPixels += Stats.GlowSkippedPixels;
+            }
+        }
+
+        //Parked monitors are neither updated nor drawn, leaving the park catches worlds up in one update and presents every monitor whole
+        while (NextVisibilityEvent < Visibility.Count && Visibility.Frames[NextVisibilityEvent] <= Frame)
+        {
+            if (!Tracker.HandleEvent(Visibility.Events[NextVisibilityEvent++]))
+            {
+                continue;
+            }
+
+            if (!Tracker.IsVisible())
+            {
+                ParkCount++;
+                continue;
+            }
+
+            for (uint32_t Index = 0; Index < Layout.Count; Index++)
+            {
+                {
+                    ProfileScope Scope = { &Profiler, PhaseWorldTick };
+                    Worlds[Index]->CatchUp(ParkedSeconds);
+                }
+                if (Presenters[Index])
+                {
+                    Presenters[Index]->WaitUntilIdle();
+                }
+                Renderers[Index]->InvalidateAll();
+                UnchangedFrameCounts[Index] = 0;
+            }
+            TotalParkedSeconds += ParkedSeconds;
+            ParkedSeconds = 0.0f;
+        }
+        bool bIsParked = !Tracker.IsVisible();
+
+        //Stars still on their monitor stay, every monitor is drawn and presented whole in this frame
+        if (Options.ResizeLayout && Frame == ResizeFrame)
+        {
+            ResizeStartTicks = PlatformGetTicks();
+            CurrentLayout = &ResizeLayout;
+            for (uint32_t Index = 0; Index < Layout.Count; Index++)
+            {
+                const MonitorRect& Monitor = ResizeLayout.Monitors[Index];
+                ResizeDroppedStars += ResizeMonitor(Index, Monitor, Governors[Index].GetRenderScale(GetRenderScale(Monitor, Run.RenderScale)));
+            }
+            ResizeTicks = PlatformGetTicks() - ResizeStartTicks;
+        }
+
+        if (bIsParked)
+        {
+            ParkedSeconds += DeltaTime;
+            ParkedFrameCount += bIsMeasured;
+        }
+
+        for (uint32_t Index = 0; Index < Layout.Count && !bIsParked; Index++)
+        {
+            //Governor's frame rate draws only every few frames, the world is updated in all of them
+            bool bIsOffRate = Frame % Governors[Index].GetQuality().FrameRateDivisor != 0;
+            if (UnchangedFrameCounts[Index] > 0 || bIsOffRate)
+            {
+                uint64_t StartTicks = PlatformGetTicks();
+                uint64_t StartCPUTicks = PlatformGetThreadCPUTicks();
+                {
+                    ProfileScope Scope = { &Profiler, PhaseWorldTick };
+                    Worlds[Index]->Update(DeltaTime);
+                }
+                if (UnchangedFrameCounts[Index] > 0)
+                {
+                    UnchangedFrameCounts[Index]--;
+                }
+                uint64_t EndTicks = PlatformGetTicks();
+
+                if (bIsMeasured)
+                {
+                    TickRenderTicks += EndTicks - StartTicks;
+                    SkippedFrameCount++;
+                }
+                GovernMonitor(Index, PlatformGetThreadCPUTicks() - StartCPUTicks, DeltaTime);
+                continue;
+            }
+
+            uint64_t StartTicks = PlatformGetTicks();
+            uint64_t StartCPUTicks = PlatformGetThreadCPUTicks();
+            {
+                ProfileScope Scope = { &Profiler, PhaseClear };
+                Renderers[Index]->Clear();
+            }
+            uint64_t ClearEndTicks = PlatformGetTicks();
+            {
+                ProfileScope Scope = { &Profiler, PhaseWorldTick };
+                Worlds[Index]->Update(DeltaTime);
+            }
+            {
+                ProfileScope Scope = { &Profiler, PhaseStarRender };
+                Worlds[Index]->Render(*Renderers[Index]);
+                Renderers[Index]->FlushStars();
+            }
+            {
+                ProfileScope Scope = { &Profiler, PhaseGlow };
+                Renderers[Index]->ApplyGlow();
+            }
+            if (Options.bSkipUnchangedFrames)
+            {
+                ProfileScope Scope = { &Profiler, PhaseWorldTick };
+                UnchangedFrameCounts[Index] = Worlds[Index]->GetUpdatesWithoutVisualChange(Run.DeltaTime, Options.WarmupFrameCount + Options.FrameCount);
+            }
+            uint64_t TickEndTicks = PlatformGetTicks();
+            if (Presenters[Index])
+            {
+                //Monitors before this one in the frame count as well, the present thread runs alongside all of them
+                Profiler.AddPhaseTicks(PhasePresentOverlap, Presenters[Index]->GetPresentTicksWithin(FrameStartTicks, TickEndTicks));
+
+                ProfileScope Scope = { &Profiler, PhasePresent };
+                Presenters[Index]->Publish();
+            }
+            else
+            {
+                ProfileScope Scope = { &Profiler, PhasePresent };
+                Renderers[Index]->Present(Surface);
+            }
+            uint64_t PresentEndTicks = PlatformGetTicks();
+
+            if (bIsMeasured)
+            {
+                ClearTicks += ClearEndTicks - StartTicks;
+                TickRenderTicks += TickEndTicks - ClearEndTicks;
+                PresentTicks += PresentEndTicks - TickEndTicks;
+            }
+            GovernMonitor(Index, PlatformGetThreadCPUTicks() - StartCPUTicks, DeltaTime);
+        }
+
+        if (Options.ResizeLayout && Frame == ResizeFrame)
+        {
+            ResizeLatencyTicks = PlatformGetTicks() - ResizeStartTicks;
+        }
+
+        if (Options.PacedFrameRate)
+        {
+            Timer.WaitUntilFrametime();
+        }
+
+        if (bIsMeasured)
+        {
+            FrameSeconds += Timer.CurrentFrameTime;
+        }
+        //Parked frames cost nothing and count towards the means per frame, they're kept out of the profile which covers drawn frames
+        if (bIsMeasured && !bIsParked)
+        {
+            Profiler.EndFrame();
+        }
+        else
+        {
+            Profiler.DiscardFrame();
+        }
+
+        //Skipped monitors still hold their last image, which is what they would show
+        uint64_t FrameHash = 0xCBF29CE484222325ull;
+        for (uint32_t Index = 0; Index < Layout.Count; Index++)
+        {
+            FrameHash = CombineHash(FrameHash, Renderers[Index]->HashRenderBuffer());
+        }
+        OutputHash = CombineHash(OutputHash, FrameHash);
+
+        if (Options.HashLogPath)
+        {
+            ThreadArenaScope HashLogScope = { nullptr };
+            Replay.HashLog.AppendHex(FrameHash);
+            Replay.HashLog.Append("\n");
+        }
+        if (Options.GoldenHashPath && Replay.HashedFrameCount < Replay.GoldenHashCount && Replay.GoldenHashes[Replay.HashedFrameCount] != FrameHash)
+        {
+            if (Replay.MismatchCount < MaxReportedMismatches)
+            {
+                fprintf(stderr, "%s stars %u size max %u: frame %u differs from golden frame %u\n", Run.Layout, Run.StarCount, Run.SizeMax, Frame, Replay.HashedFrameCount);
+            }
+            Replay.MismatchCount++;
+        }
+        Replay.HashedFrameCount++;
+    }
+
+    uint64_t FramePageFaultCount = PlatformGetPageFaultCount() - StartFramePageFaultCount;
+    uint32_t FrameOSCallCount = GetHeapStats().OSCallCount - StartFrameOSCallCount;
+
+    ReportWriter PresentReport;
+    for (uint32_t Index = 0; Index < Layout.Count; Index++)
+    {
+        if (Presenters[Index])
+        {
+            Presenters[Index]->WaitUntilIdle();
+
+            uint32_t PresentedFrameCount = Presenters[Index]->GetPresentedFrameCount() - StartPresentedFrameCounts[Index];
+            uint32_t PublishedFrameCount = Presenters[Index]->GetPublishedFrameCount() - StartPublishedFrameCounts[Index];
+            PresentReport.Append((Index > 0) ? ",\n        { \"presented_frames\": " : "\n        { \"presented_frames\": ");
+            PresentReport.AppendUInt(PresentedFrameCount);
+            PresentReport.Append(", \"dropped_frames\": ");
+            PresentReport.AppendUInt(PublishedFrameCount - PresentedFrameCount);
+            PresentReport.Append(", \"profile\": ");
+            Presenters[Index]->Profiler.WriteReport(PresentReport);
+            PresentReport.Append(" }");
+
+            delete Presenters[Index];
+        }
+
+        const RenderStats& Stats = Renderers[Index]->GetStats();
+        EndStats.ClearedPixels += Stats.ClearedPixels;
+        EndStats.DrawnPixels += Stats.DrawnPixels;
+        EndStats.PresentedPixels += Stats.PresentedPixels;
+        EndStats.GlowPixels += Stats.GlowPixels;
+        EndStats.GlowSkippedPixels += Stats.GlowSkippedPixels;
+
+        delete Worlds[Index];
+        delete Renderers[Index];
+    }
+    delete[] Surface.Pixels;
+
+    //Report outlives the run, so it's grown with memory from the OS
+    SetThreadArena(nullptr);
+
+    double NanosecondsPerTick = 1000000000.0 / (double)PlatformGetTickFrequency();
+    double FrameCount = (double)Options.FrameCount;
+    double ClearNanoseconds = (double)ClearTicks * NanosecondsPerTick / FrameCount;
+    double TickRenderNanoseconds = (double)TickRenderTicks * NanosecondsPerTick / FrameCount;
+    double PresentNanoseconds = (double)PresentTicks * NanosecondsPerTick / FrameCount;
+    double ClearedPixels = (double)(EndStats.ClearedPixels - StartStats.ClearedPixels) / FrameCount;
+    double DrawnPixels = (double)(EndStats.DrawnPixels - StartStats.DrawnPixels) / FrameCount;
+    double PresentedPixels = (double)(EndStats.PresentedPixels - StartStats.PresentedPixels) / FrameCount;
+
+    Report.Append("{ \"layout\": \"");
+    Report.Append(Run.Layout);
+    Report.Append("\", \"monitors\": ");
+    Report.AppendUInt(Layout.Count);
+    Report.Append(", \"width\": ");
+    Report.AppendUInt(Surface.Width);
+    Report.Append(", \"height\": ");
+    Report.AppendUInt(Surface.Height);
+    Report.Append(", \"stars\": ");
+    Report.AppendUInt(Run.StarCount);
+    Report.Append(", \"size_max\": ");
+    Report.AppendUInt(Run.SizeMax);
+    Report.Append(", \"render_scale\": ");
+    Report.AppendUInt(Run.RenderScale);
+    Report.Append(", \"delta_time\": ");
+    Report.AppendFloat(Run.DeltaTime, 6);
+    if (Replay.DeltaTimeCount)
+    {
+        Report.Append(", \"delta_time_sequence\": \"");
+        Report.Append(Options.DeltaTimeSequencePath);
+        Report.Append("\"");
+    }
+    if (Options.SettingsPath)
+    {
+        Report.Append(", \"settings\": \"");
+        Report.Append(Options.SettingsPath);
+        Report.Append("\"");
+    }
+    Report.Append(",\n      \"ns_per_frame\": { \"clear\": ");
+    Report.AppendFloat(ClearNanoseconds, 1);
+    Report.Append(", \"tick_render\": ");
+    Report.AppendFloat(TickRenderNanoseconds, 1);
+    Report.Append(", \"present_copy\": ");
+    Report.AppendFloat(PresentNanoseconds, 1);
+    Report.Append(", \"total\": ");
+    Report.AppendFloat(ClearNanoseconds + TickRenderNanoseconds + PresentNanoseconds, 1);
+    Report.Append(" },\n      \"pixels_per_frame\": { \"cleared\": ");
+    Report.AppendFloat(ClearedPixels, 1);
+    Report.Append(", \"drawn\": ");
+    Report.AppendFloat(DrawnPixels, 1);
+    Report.Append(", \"presented\": ");
+    Report.AppendFloat(PresentedPixels, 1);
+    Report.Append(", \"total\": ");
+    Report.AppendFloat(ClearedPixels + DrawnPixels + PresentedPixels, 1);
+    Report.Append(" },\n      \"output_hash\": \"");
+    Report.AppendHex(OutputHash);
+    Report.Append("\",\n      ");
+    if (Options.bSkipUnchangedFrames)
+    {
+        Report.Append("\"skipped_frame_share\": ");
+        Report.AppendFloat((double)SkippedFrameCount / (FrameCount * Layout.Count), 4);
+        Report.Append(",\n      ");
+    }
+    if (Options.DriftSpeed != 0)
+    {
+        Report.Append("\"drift_speed\": ");
+        Report.AppendFloat((double)Options.DriftSpeed, 0);
+        Report.Append(",\n      ");
+    }
+    if (Options.bGlow)
+    {
+        Report.Append("\"glow\": { \"pixels_per_frame\": ");
+        Report.AppendFloat((double)(EndStats.GlowPixels - StartStats.GlowPixels) / FrameCount, 1);
+        Report.Append(", \"skipped_pixels_per_frame\": ");
+        Report.AppendFloat((double)(EndStats.GlowSkippedPixels - StartStats.GlowSkippedPixels) / FrameCount, 1);
+        Report.Append(" },\n      ");
+    }
+    if (Options.CPUBudget)
+    {
+        Report.Append("\"quality\": [");
+        for (uint32_t Index = 0; Index < Layout.Count; Index++)
+        {
+            Report.Append((Index > 0) ? ",\n        " : "\n        ");
+            Governors[Index].WriteReport(Report);
+        }
+        Report.Append("\n      ],\n      ");
+    }
+    if (Options.PacedFrameRate)
+    {
+        Report.Append("\"pacing\": { \"frame_rate\": ");
+        Report.AppendUInt(Options.PacedFrameRate);
+        Report.Append(", \"mean_frame_ms\": ");
+        Report.AppendFloat(FrameSeconds * 1000.0 / FrameCount);
+        Report.Append(", \"wake_up_margin_us\": ");
+        Report.AppendFloat(Timer.GetWakeUpMarginSeconds() * 1000000.0, 1);
+        Report.Append(", \"spin_us_per_frame\": ");
+        Report.AppendFloat((Timer.GetSpinSeconds() - StartSpinSeconds) * 1000000.0 / FrameCount, 1);
+        Report.Append(" },\n      ");
+    }
+    Report.Append("\"memory\": { \"initialization_ms\": ");
+    Report.AppendFloat(InitializationMilliseconds);
+    Report.Append(", \"initialization_page_faults\": ");
+    Report.AppendUInt((uint32_t)InitializationPageFaultCount);
+    Report.Append(", \"initialization_os_calls\": ");
+    Report.AppendUInt(InitializationOSCallCount);
+    Report.Append(", \"frame_page_faults\": ");
+    Report.AppendUInt((uint32_t)FramePageFaultCount);
+    Report.Append(", \"frame_os_calls\": ");
+    Report.AppendUInt(FrameOSCallCount);
+    if (Options.ArenaMode > 0)
+    {
+        MemoryArenaStats ArenaStats = Arena.GetStats();
+        Report.Append(",\n        \"arena\": { \"committed_bytes\": ");
+        Report.AppendUInt((uint32_t)ArenaStats.CommittedBytes);
+        Report.Append(", \"used_bytes\": ");
+        Report.AppendUInt((uint32_t)ArenaStats.UsedBytes);
+        Report.Append(", \"allocations\": ");
+        Report.AppendUInt(ArenaStats.AllocationCount);
+        Report.Append(", \"large_pages\": ");
+        Report.Append(ArenaStats.bLargePages ? "true" : "false");
+        Report.Append(" }");
+    }
+    Report.Append(" },\n      ");
+    if (Options.ResizeLayout)
+    {
+        Report.Append("\"resize\": { \"layout\": \"");
+        Report.Append(Options.ResizeLayout);
+        Report.Append("\", \"ms\": ");
+        Report.AppendFloat((double)ResizeTicks * NanosecondsPerTick / 1000000.0);
+        Report.Append(", \"latency_ms\": ");
+        Report.AppendFloat((double)ResizeLatencyTicks * NanosecondsPerTick / 1000000.0);
+        Report.Append(", \"dropped_stars\": ");
+        Report.AppendUInt(ResizeDroppedStars);
+        Report.Append(" },\n      ");
+    }
+    if (Options.VisibilityScript)
+    {
+        Report.Append("\"visibility\": { \"events\": \"");
+        Report.Append(Options.VisibilityScript);
+        Report.Append("\", \"parks\": ");
+        Report.AppendUInt(ParkCount);
+        Report.Append(", \"parked_frames\": ");
+        Report.AppendUInt(ParkedFrameCount);
+        Report.Append(", \"parked_frame_share\": ");
+        Report.AppendFloat((double)ParkedFrameCount / FrameCount, 4);
+        Report.Append(", \"parked_seconds\": ");
+        Report.AppendFloat(TotalParkedSeconds + ParkedSeconds);
+        Report.Append(" },\n      ");
+    }
+    if (Options.bUsePresentThreads)
+    {
+        Report.Append("\"present_threads\": [");
+        PresentReport.Append("\n      ],\n      ");
+        Report.Append(PresentReport);
+    }
+    Report.Append("\"profile\": ");
+    Profiler.WriteReport(Report);
+    Report.Append(" }");
+
+    printf("%s stars %u size max %u scale %u dt %.4f: %.0f ns/frame\n", Run.Layout, Run.StarCount, Run.SizeMax, Run.RenderScale, Run.DeltaTime,
+        ClearNanoseconds + TickRenderNanoseconds + PresentNanoseconds);
+
+    //Damage tracking has to keep clearing and presenting proportional to what's drawn, however many stars there are
+    if (Options.MaxDamageRatio && (ClearedPixels > DrawnPixels * Options.MaxDamageRatio || PresentedPixels > DrawnPixels * Options.MaxDamageRatio))
+    {
+        fprintf(stderr, "%s stars %u size max %u: %.0f pixels cleared and %.0f presented per frame for %.0f drawn, more than %u times\n", Run.Layout, Run.StarCount, Run.SizeMax,
+            ClearedPixels, PresentedPixels, DrawnPixels, Options.MaxDamageRatio);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int ArgumentCount, char** Arguments)
+{
+    HeadlessOptions Options;
+    if (!ParseOptions(ArgumentCount, Arguments, Options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    ReplayState Replay;
+    if (Options.DeltaTimeSequencePath)
+    {
+        if (!LoadDeltaTimeSequence(Options.DeltaTimeSequencePath, Replay))
+        {
+            fprintf(stderr, "Failed to read delta times from %s\n", Options.DeltaTimeSequencePath);
+            return 1;
+        }
+
+        //Runs report the mean, the sequence itself is what is replayed
+        double DeltaTimeSum = 0.0;
+        for (uint32_t Index = 0; Index < Replay.DeltaTimeCount; Index++)
+        {
+            DeltaTimeSum += Replay.DeltaTimes[Index];
+        }
+        Options.DeltaTimes[0] = (float)(DeltaTimeSum / Replay.DeltaTimeCount);
+    }
+    if (Options.GoldenHashPath && !LoadGoldenHashes(Options.GoldenHashPath, Replay))
+    {
+        fprintf(stderr, "Failed to read hashes from %s\n", Options.GoldenHashPath);
+        return 1;
+    }
+
+    //Workers are only started if some run has enough stars for the renderer to rasterize in parallel, a monitor never gets more than all of them
+    uint32_t MaxStarCount = 0;
+    for (uint32_t Index = 0; Index < Options.StarCountCount; Index++)
+    {
+        MaxStarCount = (Options.StarCounts[Index] > MaxStarCount) ? Options.StarCounts[Index] : MaxStarCount;
+    }
+    WorkerPool RasterPool = { (MaxStarCount >= CPURenderer::MinStarsForParallelRaster) ? Options.RasterWorkerCount : 0 };
+
+    ReportWriter Report;
+    Report.Append("{\n  \"frames\": ");
+    Report.AppendUInt(Options.FrameCount);
+    Report.Append(",\n  \"warmup_frames\": ");
+    Report.AppendUInt(Options.WarmupFrameCount);
+    Report.Append(",\n  \"raster_workers\": ");
+    Report.AppendUInt(RasterPool.GetWorkerCount());
+    Report.Append(",\n  \"runs\": [");
+
+    bool bIsFirst = true;
+    for (uint32_t LayoutIndex = 0; LayoutIndex < Options.LayoutCount; LayoutIndex++)
+    {
+        for (uint32_t StarCountIndex = 0; StarCountIndex < Options.StarCountCount; StarCountIndex++)
+        {
+            for (uint32_t SizeMaxIndex = 0; SizeMaxIndex < Options.SizeMaxCount; SizeMaxIndex++)
+            {
+                for (uint32_t DeltaTimeIndex = 0; DeltaTimeIndex < Options.DeltaTimeCount; DeltaTimeIndex++)
+                {
+                    for (uint32_t RenderScaleIndex = 0; RenderScaleIndex < Options.RenderScaleCount; RenderScaleIndex++)
+                    {
+                        HeadlessRun Run = { Options.Layouts[LayoutIndex], Options.StarCounts[StarCountIndex], Options.SizeMaxes[SizeMaxIndex], Options.DeltaTimes[DeltaTimeIndex],
+                            Options.RenderScales[RenderScaleIndex] };
+
+                        Report.Append(bIsFirst ? "\n    " : ",\n    ");
+                        if (!RunBenchmark(Options, Run, RasterPool, g_Arena, Replay, Report))
+                        {
+                            return 1;
+                        }
+                        bIsFirst = false;
+                    }
+                }
+            }
+        }
+    }
+    Report.Append("\n  ]\n}\n");
+    delete[] Replay.DeltaTimes;
+    delete[] Replay.GoldenHashes;
+
+    if (!Report.WriteToFile(Options.ReportPath))
+    {
+        fprintf(stderr, "Failed to write %s\n", Options.ReportPath);
+        return 1;
+    }
+    if (Options.HashLogPath && !Replay.HashLog.WriteToFile(Options.HashLogPath))
+    {
+        fprintf(stderr, "Failed to write %s\n", Options.HashLogPath);
+        return 1;
+    }
+
+    if (Options.GoldenHashPath)
+    {
+        if (Replay.MismatchCount > 0 || Replay.HashedFrameCount != Replay.GoldenHashCount)
+        {
+            fprintf(stderr, "%u of %u frames differ from %s, which has %u frames\n", Replay.MismatchCount, Replay.HashedFrameCount, Options.GoldenHashPath, Replay.GoldenHashCount);
+            return 1;
+        }
+        printf("All %u frames match %s\n", Replay.HashedFrameCount, Options.GoldenHashPath);
+    }
+
+    return 0;
+}
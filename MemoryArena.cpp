@@ -0,0 +1,273 @@
+#include "MemoryArena.h"
+#include "Platform.h"
+
+//Every arena ever initialized and not released, so FreeMemory can tell arena blocks from OS ones
+static std::atomic<MemoryArena*> g_Arenas[MemoryArena::MaxArenas];
+
+//Slot index plus one, 0 until the first arena is initialized
+static std::atomic<uint32_t> g_ThreadArenaSlot;
+
+static std::atomic<uint32_t> g_HeapAllocationCount;
+static std::atomic<uint32_t> g_HeapLiveBlocks;
+static std::atomic<uint32_t> g_MemoryOSCallCount;
+
+bool MemoryArena::Initialize(size_t Size, uint32_t InFlags)
+{
+    if (g_ThreadArenaSlot.load() == 0)
+    {
+        g_ThreadArenaSlot = PlatformAllocateThreadSlot() + 1;
+    }
+
+    uint32_t RegistryIndex = 0;
+    while (RegistryIndex < MaxArenas && g_Arenas[RegistryIndex].load() != nullptr)
+    {
+        RegistryIndex++;
+    }
+    if (RegistryIndex == MaxArenas)
+    {
+        return false;
+    }
+
+    Flags = InFlags;
+    Offset = 0;
+    HighWaterSize = 0;
+    LiveBlocks = 0;
+    AllocationCount = 0;
+    OSCallCount = 0;
+    PageFaultCount = 0;
+    bLargePages = false;
+
+    uint64_t StartPageFaults = PlatformGetPageFaultCount();
+
+    size_t LargePageSize = PlatformGetLargePageSize();
+    if ((Flags & ArenaLargePages) && LargePageSize > 0)
+    {
+        Capacity = (Size + LargePageSize - 1) / LargePageSize * LargePageSize;
+        Base = (uint8_t*)PlatformAllocateLargePages(Capacity);
+        OSCallCount++;
+        bLargePages = Base != nullptr;
+        CommittedSize = Capacity;
+    }
+
+    if (!bLargePages)
+    {
+        Capacity = (Size + CommitGranularity - 1) & ~(CommitGranularity - 1);
+        Base = (uint8_t*)PlatformReserveMemory(Capacity);
+        OSCallCount++;
+        CommittedSize = 0;
+    }
+
+    g_MemoryOSCallCount.fetch_add(OSCallCount);
+    if (!Base)
+    {
+        Capacity = 0;
+        return false;
+    }
+
+    //Large pages come committed, touching them still maps them on systems which back them lazily
+    if (bLargePages && (Flags & ArenaPrefault))
+    {
+        for (size_t PageOffset = 0; PageOffset < CommittedSize; PageOffset += LargePageSize)
+        {
+            ((volatile uint8_t*)Base)[PageOffset] = 0;
+        }
+    }
+    PageFaultCount += PlatformGetPageFaultCount() - StartPageFaults;
+
+    g_Arenas[RegistryIndex] = this;
+
+    return true;
+}
+
+void MemoryArena::Release()
+{
+    if (!Base)
+    {
+        return;
+    }
+
+    for (uint32_t Index = 0; Index < MaxArenas; Index++)
+    {
+        if (g_Arenas[Index].load() == this)
+        {
+            g_Arenas[Index] = nullptr;
+        }
+    }
+
+    PlatformReleaseMemory(Base, Capacity);
+    g_MemoryOSCallCount.fetch_add(1);
+
+    Base = nullptr;
+    Capacity = 0;
+    Offset = 0;
+    CommittedSize = 0;
+    HighWaterSize = 0;
+}
+
+void MemoryArena::Reset()
+{
+    Offset = 0;
+    AllocationCount = 0;
+}
+
+bool MemoryArena::Commit(size_t Size)
+{
+    if (Size <= CommittedSize)
+    {
+        return true;
+    }
+    if (Size > Capacity)
+    {
+        return false;
+    }
+
+    size_t NewCommittedSize = (Size + CommitGranularity - 1) & ~(CommitGranularity - 1);
+    NewCommittedSize = (NewCommittedSize < Capacity) ? NewCommittedSize : Capacity;
+
+    uint64_t StartPageFaults = PlatformGetPageFaultCount();
+
+    bool bCommitted = PlatformCommitMemory(Base + CommittedSize, NewCommittedSize - CommittedSize);
+    OSCallCount++;
+    g_MemoryOSCallCount.fetch_add(1);
+
+    if (bCommitted && (Flags & ArenaPrefault))
+    {
+        //Written rather than read, a read may map a shared zero page which faults again on the first write
+        uint32_t PageSize = PlatformGetPageSize();
+        for (size_t PageOffset = CommittedSize; PageOffset < NewCommittedSize; PageOffset += PageSize)
+        {
+            ((volatile uint8_t*)Base)[PageOffset] = 0;
+        }
+    }
+
+    PageFaultCount += PlatformGetPageFaultCount() - StartPageFaults;
+
+    if (!bCommitted)
+    {
+        return false;
+    }
+    CommittedSize = NewCommittedSize;
+
+    return true;
+}
+
+void* MemoryArena::Allocate(size_t Size)
+{
+    size_t Remaining = Capacity - Offset;
+    size_t AlignedSize = (Size + AllocationAlignment - 1) & ~(AllocationAlignment - 1);
+    if (Size > Remaining || AlignedSize > Remaining)
+    {
+        return nullptr;
+    }
+    //Zero sized blocks still get an address of their own
+    AlignedSize = (AlignedSize > 0) ? AlignedSize : AllocationAlignment;
+
+    size_t End = Offset + AlignedSize;
+    if (End > CommittedSize && !Commit(End))
+    {
+        return nullptr;
+    }
+
+    uint8_t* Result = Base + Offset;
+    if (Offset < HighWaterSize)
+    {
+        size_t DirtyEnd = (Offset + Size < HighWaterSize) ? Offset + Size : HighWaterSize;
+        memset(Result, 0, DirtyEnd - Offset);
+    }
+
+    Offset = End;
+    HighWaterSize = (Offset > HighWaterSize) ? Offset : HighWaterSize;
+    AllocationCount++;
+    LiveBlocks.fetch_add(1, std::memory_order_relaxed);
+
+    return Result;
+}
+
+void MemoryArena::Free(void* Address)
+{
+    LiveBlocks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+MemoryArenaStats MemoryArena::GetStats() const
+{
+    MemoryArenaStats Stats;
+    Stats.ReservedBytes = Capacity;
+    Stats.CommittedBytes = CommittedSize;
+    Stats.UsedBytes = Offset;
+    Stats.HighWaterBytes = HighWaterSize;
+    Stats.LiveBlocks = LiveBlocks.load(std::memory_order_relaxed);
+    Stats.AllocationCount = AllocationCount;
+    Stats.OSCallCount = OSCallCount;
+    Stats.PageFaultCount = PageFaultCount;
+    Stats.bLargePages = bLargePages;
+
+    return Stats;
+}
+
+void SetThreadArena(MemoryArena* Arena)
+{
+    uint32_t Slot = g_ThreadArenaSlot.load();
+    if (Slot != 0)
+    {
+        PlatformSetThreadSlotValue(Slot - 1, Arena);
+    }
+}
+
+MemoryArena* GetThreadArena()
+{
+    uint32_t Slot = g_ThreadArenaSlot.load();
+
+    return (Slot != 0) ? (MemoryArena*)PlatformGetThreadSlotValue(Slot - 1) : nullptr;
+}
+
+void* AllocateMemory(size_t Size)
+{
+    MemoryArena* Arena = GetThreadArena();
+    if (Arena)
+    {
+        void* Result = Arena->Allocate(Size);
+        if (Result)
+        {
+            return Result;
+        }
+    }
+
+    g_HeapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_HeapLiveBlocks.fetch_add(1, std::memory_order_relaxed);
+    g_MemoryOSCallCount.fetch_add(1, std::memory_order_relaxed);
+
+    return PlatformAllocateMemory(Size);
+}
+
+void FreeMemory(void* Address)
+{
+    if (!Address)
+    {
+        return;
+    }
+
+    for (uint32_t Index = 0; Index < MemoryArena::MaxArenas; Index++)
+    {
+        MemoryArena* Arena = g_Arenas[Index].load();
+        if (Arena && Arena->Contains(Address))
+        {
+            Arena->Free(Address);
+            return;
+        }
+    }
+
+    g_HeapLiveBlocks.fetch_sub(1, std::memory_order_relaxed);
+    g_MemoryOSCallCount.fetch_add(1, std::memory_order_relaxed);
+
+    PlatformFreeMemory(Address);
+}
+
+HeapStats GetHeapStats()
+{
+    HeapStats Stats;
+    Stats.AllocationCount = g_HeapAllocationCount.load(std::memory_order_relaxed);
+    Stats.LiveBlocks = g_HeapLiveBlocks.load(std::memory_order_relaxed);
+    Stats.OSCallCount = g_MemoryOSCallCount.load(std::memory_order_relaxed);
+
+    return Stats;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <atomic>
+
+enum MemoryArenaFlags
+{
+    //Pages are touched as soon as they are committed, so first use of a block never faults
+    ArenaPrefault = 1 << 0,
+    //Whole arena is committed on large pages when the OS grants them, regular pages are used otherwise
+    ArenaLargePages = 1 << 1,
+};
+
+struct MemoryArenaStats
+{
+    size_t ReservedBytes;
+    size_t CommittedBytes;
+    size_t UsedBytes;
+    //Most ever used since Initialize, resets don't lower it
+    size_t HighWaterBytes;
+    uint32_t LiveBlocks;
+    //Since the last reset
+    uint32_t AllocationCount;
+    uint32_t OSCallCount;
+    //Process wide faults counted while committing and prefaulting, other threads faulting at the same time are included
+    uint64_t PageFaultCount;
+    bool bLargePages;
+};
+
+//Allocations served by the OS because the calling thread had no arena or its arena was full, plus every OS call for memory arenas made
+struct HeapStats
+{
+    uint32_t AllocationCount;
+    uint32_t LiveBlocks;
+    uint32_t OSCallCount;
+};
+
+//Reserve once bump allocator, blocks are freed all at once by rewinding it
+//Address space is reserved up front and committed in CommitGranularity steps as it's used, resets keep what's committed
+//Has no constructor, a zeroed arena is valid and uninitialized, so it can live in global objects of the CRT free build
+class MemoryArena
+{
+public:
+    //Reserves Size bytes rounded up to CommitGranularity and registers the arena so FreeMemory recognizes its blocks
+    //Called by one thread at a time and before any other thread uses the arena, returns false if the address space or a registry entry isn't available
+    bool Initialize(size_t Size, uint32_t InFlags);
+    //Returns the address space to the OS, every block has to be freed by then
+    void Release();
+    //Rewinds to empty without calling the OS, every block has to be freed by then
+    void Reset();
+    //Commits and with ArenaPrefault touches the first Size bytes, so allocations up to it don't call the OS
+    bool Commit(size_t Size);
+
+    //Zeroed block aligned to AllocationAlignment, nullptr if it doesn't fit, only called by the thread using the arena
+    void* Allocate(size_t Size);
+    //Blocks are only reclaimed by Reset, freeing one just counts it, may be called from any thread
+    void Free(void* Address);
+    bool Contains(const void* Address) const { return (const uint8_t*)Address >= Base && (const uint8_t*)Address < Base + Capacity; }
+
+    bool IsInitialized() const { return Base != nullptr; }
+    size_t GetCapacity() const { return Capacity; }
+    uint32_t GetFlags() const { return Flags; }
+    MemoryArenaStats GetStats() const;
+
+    static const size_t AllocationAlignment = 64;
+    static const size_t CommitGranularity = 1024 * 1024;
+    static const uint32_t MaxArenas = 32;
+
+private:
+    uint8_t* Base;
+    size_t Capacity;
+    size_t Offset;
+    size_t CommittedSize;
+    //Memory below it was handed out before, so it's zeroed when handed out again after a reset
+    size_t HighWaterSize;
+    uint32_t Flags;
+    bool bLargePages;
+
+    std::atomic<uint32_t> LiveBlocks;
+    uint32_t AllocationCount;
+    uint32_t OSCallCount;
+    uint64_t PageFaultCount;
+};
+
+//Allocations of the calling thread go to Arena from now on, nullptr sends them to the OS again
+void SetThreadArena(MemoryArena* Arena);
+MemoryArena* GetThreadArena();
+
+//Backs operator new, tries the calling thread's arena and falls back to the OS when there is none or it's full
+void* AllocateMemory(size_t Size);
+//Backs operator delete, takes blocks from any arena or the OS
+void FreeMemory(void* Address);
+
+HeapStats GetHeapStats();
+
+//Switches the calling thread's arena for the enclosing block, e.g. to nullptr for memory which has to outlive the next reset
+class ThreadArenaScope
+{
+public:
+    ThreadArenaScope(MemoryArena* Arena)
+        : PreviousArena(GetThreadArena())
+    {
+        SetThreadArena(Arena);
+    }
+
+    ~ThreadArenaScope()
+    {
+        SetThreadArena(PreviousArena);
+    }
+
+private:
+    MemoryArena* PreviousArena;
+};
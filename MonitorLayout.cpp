@@ -0,0 +1,224 @@
+#include "MonitorLayout.h"
+
+void MonitorLayout::Add(int32_t Left, int32_t Top, int32_t Right, int32_t Bottom, uint32_t WindowWidth, uint32_t WindowHeight, uint32_t Dpi)
+{
+    if (Count >= MaxMonitors)
+    {
+        return;
+    }
+
+    Left = (Left > 0) ? Left : 0;
+    Top = (Top > 0) ? Top : 0;
+    Right = (Right < (int32_t)WindowWidth) ? Right : (int32_t)WindowWidth;
+    Bottom = (Bottom < (int32_t)WindowHeight) ? Bottom : (int32_t)WindowHeight;
+
+    if (Left >= Right || Top >= Bottom)
+    {
+        return;
+    }
+
+    Monitors[Count++] = { Left, Top, (uint32_t)(Right - Left), (uint32_t)(Bottom - Top), Dpi };
+}
+
+void MonitorLayout::GetBounds(uint32_t& OutWidth, uint32_t& OutHeight) const
+{
+    OutWidth = 0;
+    OutHeight = 0;
+
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        uint32_t Right = (uint32_t)Monitors[Index].Left + Monitors[Index].Width;
+        uint32_t Bottom = (uint32_t)Monitors[Index].Top + Monitors[Index].Height;
+
+        OutWidth = (Right > OutWidth) ? Right : OutWidth;
+        OutHeight = (Bottom > OutHeight) ? Bottom : OutHeight;
+    }
+}
+
+uint32_t MonitorLayout::GetStarBudget(uint32_t Index, uint32_t TotalStarCount) const
+{
+    //Areas of a few 4K monitors already overflow 32 bits once multiplied by the star count, floats are precise enough here
+    float TotalArea = 0.0f;
+    for (uint32_t MonitorIndex = 0; MonitorIndex < Count; MonitorIndex++)
+    {
+        TotalArea += (float)Monitors[MonitorIndex].Width * (float)Monitors[MonitorIndex].Height;
+    }
+
+    float Area = (float)Monitors[Index].Width * (float)Monitors[Index].Height;
+    uint32_t Result = (uint32_t)(TotalStarCount * Area / TotalArea);
+
+    return (Result > 0) ? Result : 1;
+}
+
+uint32_t GetRenderScale(const MonitorRect& Monitor, uint32_t RenderScaleSetting)
+{
+    uint32_t Scale = RenderScaleSetting;
+    if (Scale == AutomaticRenderScale)
+    {
+        Scale = ((Monitor.Dpi != 0) ? Monitor.Dpi : DefaultMonitorDpi) / DefaultMonitorDpi;
+    }
+
+    Scale = (Scale > 1) ? Scale : 1;
+    return (Scale < MaxRenderScale) ? Scale : MaxRenderScale;
+}
+
+void GetRenderSize(const MonitorRect& Monitor, uint32_t RenderScale, uint32_t& OutWidth, uint32_t& OutHeight)
+{
+    OutWidth = (Monitor.Width >= RenderScale) ? Monitor.Width / RenderScale : 1;
+    OutHeight = (Monitor.Height >= RenderScale) ? Monitor.Height / RenderScale : 1;
+}
+
+#ifdef _WIN32
+typedef HRESULT (WINAPI* GetDpiForMonitorFunction)(HMONITOR Monitor, int32_t DpiType, UINT* OutDpiX, UINT* OutDpiY);
+
+//Shcore.dll only exists since Windows 8.1, it's looked up at run time so older systems still start, with every monitor at DefaultMonitorDpi
+static GetDpiForMonitorFunction g_GetDpiForMonitor = nullptr;
+static bool g_bDpiFunctionLoaded = false;
+
+static uint32_t GetMonitorDpi(HMONITOR Monitor)
+{
+    if (!g_bDpiFunctionLoaded)
+    {
+        HMODULE Shcore = LoadLibraryA("shcore.dll");
+        g_GetDpiForMonitor = Shcore ? (GetDpiForMonitorFunction)GetProcAddress(Shcore, "GetDpiForMonitor") : nullptr;
+        g_bDpiFunctionLoaded = true;
+    }
+
+    //Effective DPI is the one the user's scaling setting asks for, 0 stands for it
+    UINT DpiX, DpiY;
+    if (!g_GetDpiForMonitor || g_GetDpiForMonitor(Monitor, 0, &DpiX, &DpiY) != S_OK)
+    {
+        return 0;
+    }
+
+    return DpiX;
+}
+
+struct MonitorEnumContext
+{
+    const RECT* WindowArea;
+    MonitorLayout* Layout;
+};
+
+static BOOL CALLBACK AddEnumeratedMonitor(HMONITOR Monitor, HDC DeviceContext, LPRECT MonitorArea, LPARAM Parameter)
+{
+    MonitorEnumContext* Context = (MonitorEnumContext*)Parameter;
+    const RECT& WindowArea = *Context->WindowArea;
+
+    Context->Layout->Add(
+        MonitorArea->left - WindowArea.left, MonitorArea->top - WindowArea.top,
+        MonitorArea->right - WindowArea.left, MonitorArea->bottom - WindowArea.top,
+        WindowArea.right - WindowArea.left, WindowArea.bottom - WindowArea.top,
+        GetMonitorDpi(Monitor));
+
+    return TRUE;
+}
+
+bool EnumerateMonitors(const RECT& WindowArea, MonitorLayout& OutLayout)
+{
+    OutLayout.Count = 0;
+
+    MonitorEnumContext Context = { &WindowArea, &OutLayout };
+    EnumDisplayMonitors(NULL, NULL, AddEnumeratedMonitor, (LPARAM)&Context);
+
+    return OutLayout.Count > 0;
+}
+#endif
+
+static bool ParseNumber(const char*& Cursor, int32_t& OutValue)
+{
+    bool bNegative = (*Cursor == '-');
+    if (bNegative)
+    {
+        Cursor++;
+    }
+
+    if (*Cursor < '0' || *Cursor > '9')
+    {
+        return false;
+    }
+
+    int32_t Value = 0;
+    while (*Cursor >= '0' && *Cursor <= '9')
+    {
+        Value = Value * 10 + (*Cursor - '0');
+        Cursor++;
+    }
+
+    OutValue = bNegative ? -Value : Value;
+    return true;
+}
+
+bool ParseMonitorLayout(const char* Description, MonitorLayout& OutLayout)
+{
+    OutLayout.Count = 0;
+
+    //Entries are collected in description coordinates first, window origin is only known once all of them are read
+    MonitorRect Entries[MonitorLayout::MaxMonitors];
+    uint32_t EntryCount = 0;
+    int32_t OriginX = 0;
+    int32_t OriginY = 0;
+
+    const char* Cursor = Description;
+    while (*Cursor)
+    {
+        //Offsets are written as "+X" or "-X" like X11 geometry strings, hence the sign is parsed as part of the number
+        int32_t MonitorWidth, MonitorHeight, Left, Top;
+        if (!ParseNumber(Cursor, MonitorWidth) || *Cursor++ != 'x' || !ParseNumber(Cursor, MonitorHeight))
+        {
+            return false;
+        }
+
+        if (*Cursor != '+' && *Cursor != '-')
+        {
+            return false;
+        }
+        Cursor += (*Cursor == '+');
+        if (!ParseNumber(Cursor, Left))
+        {
+            return false;
+        }
+
+        if (*Cursor != '+' && *Cursor != '-')
+        {
+            return false;
+        }
+        Cursor += (*Cursor == '+');
+        if (!ParseNumber(Cursor, Top))
+        {
+            return false;
+        }
+
+        int32_t Dpi = 0;
+        if (*Cursor == '@' && (!ParseNumber(++Cursor, Dpi) || Dpi <= 0))
+        {
+            return false;
+        }
+
+        if (MonitorWidth <= 0 || MonitorHeight <= 0 || EntryCount >= MonitorLayout::MaxMonitors)
+        {
+            return false;
+        }
+
+        OriginX = (EntryCount == 0 || Left < OriginX) ? Left : OriginX;
+        OriginY = (EntryCount == 0 || Top < OriginY) ? Top : OriginY;
+        Entries[EntryCount++] = { Left, Top, (uint32_t)MonitorWidth, (uint32_t)MonitorHeight, (uint32_t)Dpi };
+
+        if (*Cursor == ',')
+        {
+            Cursor++;
+        }
+        else if (*Cursor)
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t Index = 0; Index < EntryCount; Index++)
+    {
+        const MonitorRect& Entry = Entries[Index];
+        OutLayout.Monitors[OutLayout.Count++] = { Entry.Left - OriginX, Entry.Top - OriginY, Entry.Width, Entry.Height, Entry.Dpi };
+    }
+
+    return OutLayout.Count > 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Globals.h"
+
+//Part of the screen saver window shown by one display, relative to the top left corner of the window
+struct MonitorRect
+{
+    int32_t Left;
+    int32_t Top;
+    uint32_t Width;
+    uint32_t Height;
+    //Effective DPI, 0 if unknown which is taken as DefaultMonitorDpi
+    uint32_t Dpi;
+};
+
+//DPI of a monitor at 100% scaling
+static const uint32_t DefaultMonitorDpi = 96;
+//Render scale setting which picks the scale from each monitor's DPI
+static const uint32_t AutomaticRenderScale = 0;
+static const uint32_t MaxRenderScale = 4;
+
+struct MonitorLayout
+{
+    static const uint32_t MaxMonitors = 16;
+
+    MonitorRect Monitors[MaxMonitors];
+    uint32_t Count = 0;
+
+    //Adds a monitor clipped to the window area, dropped if nothing is left of it
+    void Add(int32_t Left, int32_t Top, int32_t Right, int32_t Bottom, uint32_t WindowWidth, uint32_t WindowHeight, uint32_t Dpi = 0);
+
+    //Size of the smallest window covering every monitor
+    void GetBounds(uint32_t& OutWidth, uint32_t& OutHeight) const;
+
+    //Share of TotalStarCount for the monitor at Index proportional to its area, so star density is the same on every monitor
+    uint32_t GetStarBudget(uint32_t Index, uint32_t TotalStarCount) const;
+};
+
+//Monitor pixels per rendered pixel along each axis, RenderScaleSetting is 1 to MaxRenderScale or AutomaticRenderScale
+//Automatic renders a pixel per 100% of the monitor's scaling, rounded down, so text sized content would look the same
+uint32_t GetRenderScale(const MonitorRect& Monitor, uint32_t RenderScaleSetting);
+//Size of the buffer rendered for Monitor at RenderScale, monitor pixels past the last whole rendered pixel stay uncovered
+void GetRenderSize(const MonitorRect& Monitor, uint32_t RenderScale, uint32_t& OutWidth, uint32_t& OutHeight);
+
+#ifdef _WIN32
+//Collects the monitors overlapping WindowArea, which is given in virtual screen coordinates
+bool EnumerateMonitors(const RECT& WindowArea, MonitorLayout& OutLayout);
+#endif
+
+//Parses comma separated "WIDTHxHEIGHT+LEFT+TOP" entries with an optional "@DPI" suffix, stands in for the monitor list where there are no displays to enumerate
+//Monitors are moved so the top left corner of their bounds is the window origin, returns false if the description is malformed
+bool ParseMonitorLayout(const char* Description, MonitorLayout& OutLayout);
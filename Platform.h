@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//Operating system services used by the simulation and rendering core, implemented once per platform
+//PlatformWin32.cpp goes with the screen saver, PlatformPosix.cpp with the headless benchmark build
+
+//Monotonic high resolution clock
+uint64_t PlatformGetTicks();
+uint64_t PlatformGetTickFrequency();
+double PlatformGetSeconds();
+//CPU time the calling thread has run for, in ticks of PlatformGetTickFrequency, time it slept or waited isn't counted
+//Advances in steps of the scheduler's clock interrupt on Windows, only sums over many frames are accurate there
+uint64_t PlatformGetThreadCPUTicks();
+
+uint32_t PlatformGetProcessorCount();
+
+typedef void* PlatformThread;
+typedef uint32_t (*PlatformThreadFunction)(void* Parameter);
+
+PlatformThread PlatformCreateThread(PlatformThreadFunction Function, void* Parameter);
+//Waits for the thread to exit and releases it
+void PlatformJoinThread(PlatformThread Thread);
+void PlatformYieldThread();
+
+//Sleeps until a tick of PlatformGetTicks, wakes up late by however much timer slack the OS has
+typedef void* PlatformWaitTimer;
+
+PlatformWaitTimer PlatformCreateWaitTimer();
+void PlatformDestroyWaitTimer(PlatformWaitTimer Timer);
+void PlatformWaitUntil(PlatformWaitTimer Timer, uint64_t Ticks);
+
+typedef void* PlatformSemaphore;
+
+PlatformSemaphore PlatformCreateSemaphore(uint32_t MaxCount);
+void PlatformDestroySemaphore(PlatformSemaphore Semaphore);
+void PlatformSignalSemaphore(PlatformSemaphore Semaphore, uint32_t Count);
+void PlatformWaitSemaphore(PlatformSemaphore Semaphore);
+
+//Pointer per thread, null until set, slots are allocated once and never freed
+typedef uint32_t PlatformThreadSlot;
+
+PlatformThreadSlot PlatformAllocateThreadSlot();
+void* PlatformGetThreadSlotValue(PlatformThreadSlot Slot);
+void PlatformSetThreadSlotValue(PlatformThreadSlot Slot, void* Value);
+
+//Zeroed memory straight from the OS, backs allocations made outside of arenas
+void* PlatformAllocateMemory(size_t Size);
+void PlatformFreeMemory(void* Address);
+
+//Address space for arenas, reserved once and committed in steps, Address and Size of commits are page aligned
+void* PlatformReserveMemory(size_t Size);
+bool PlatformCommitMemory(void* Address, size_t Size);
+//Committed memory on large pages, Size has to be a multiple of PlatformGetLargePageSize, nullptr if the OS doesn't grant them
+void* PlatformAllocateLargePages(size_t Size);
+//Releases both reserved and large page ranges
+void PlatformReleaseMemory(void* Address, size_t Size);
+uint32_t PlatformGetPageSize();
+//0 if large pages aren't supported
+size_t PlatformGetLargePageSize();
+//Soft and hard page faults of the whole process so far
+uint64_t PlatformGetPageFaultCount();
+
+//Creates or overwrites the file, returns false if not everything was written
+bool PlatformWriteFile(const char* Path, const void* Data, uint32_t Size);
@@ -0,0 +1,266 @@
+#include "Platform.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+//Transparent huge pages are 2 MB on x86-64, they're only a hint and the kernel may back the range with regular pages anyway
+static const size_t HugePageSize = 2 * 1024 * 1024;
+
+uint64_t PlatformGetTicks()
+{
+    timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+
+    return (uint64_t)Time.tv_sec * 1000000000ull + (uint64_t)Time.tv_nsec;
+}
+
+uint64_t PlatformGetTickFrequency()
+{
+    return 1000000000ull;
+}
+
+double PlatformGetSeconds()
+{
+    return (double)PlatformGetTicks() / (double)PlatformGetTickFrequency();
+}
+
+uint64_t PlatformGetThreadCPUTicks()
+{
+    timespec Time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Time);
+
+    return (uint64_t)Time.tv_sec * 1000000000ull + (uint64_t)Time.tv_nsec;
+}
+
+uint32_t PlatformGetProcessorCount()
+{
+    long Count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (Count > 0) ? (uint32_t)Count : 1;
+}
+
+struct PosixThread
+{
+    pthread_t Thread;
+    PlatformThreadFunction Function;
+    void* Parameter;
+};
+
+static void* ThreadStart(void* Parameter)
+{
+    PosixThread* Thread = (PosixThread*)Parameter;
+    Thread->Function(Thread->Parameter);
+
+    return nullptr;
+}
+
+PlatformThread PlatformCreateThread(PlatformThreadFunction Function, void* Parameter)
+{
+    PosixThread* Thread = new PosixThread;
+    Thread->Function = Function;
+    Thread->Parameter = Parameter;
+
+    if (pthread_create(&Thread->Thread, nullptr, &ThreadStart, Thread) != 0)
+    {
+        delete Thread;
+        return nullptr;
+    }
+
+    return Thread;
+}
+
+void PlatformJoinThread(PlatformThread Thread)
+{
+    PosixThread* PThread = (PosixThread*)Thread;
+    pthread_join(PThread->Thread, nullptr);
+    delete PThread;
+}
+
+void PlatformYieldThread()
+{
+    sched_yield();
+}
+
+PlatformWaitTimer PlatformCreateWaitTimer()
+{
+    //clock_nanosleep needs no timer object
+    return nullptr;
+}
+
+void PlatformDestroyWaitTimer(PlatformWaitTimer Timer)
+{
+}
+
+void PlatformWaitUntil(PlatformWaitTimer Timer, uint64_t Ticks)
+{
+    //Ticks are nanoseconds of CLOCK_MONOTONIC, so they can be used as absolute deadline directly
+    timespec Deadline;
+    Deadline.tv_sec = (time_t)(Ticks / 1000000000ull);
+    Deadline.tv_nsec = (long)(Ticks % 1000000000ull);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Deadline, nullptr) == EINTR)
+    {
+    }
+}
+
+PlatformSemaphore PlatformCreateSemaphore(uint32_t MaxCount)
+{
+    //POSIX semaphores have no maximum count, signals beyond it only cause wake ups which find nothing to do
+    sem_t* Semaphore = new sem_t;
+    sem_init(Semaphore, 0, 0);
+
+    return Semaphore;
+}
+
+void PlatformDestroySemaphore(PlatformSemaphore Semaphore)
+{
+    sem_destroy((sem_t*)Semaphore);
+    delete (sem_t*)Semaphore;
+}
+
+void PlatformSignalSemaphore(PlatformSemaphore Semaphore, uint32_t Count)
+{
+    for (uint32_t Index = 0; Index < Count; Index++)
+    {
+        sem_post((sem_t*)Semaphore);
+    }
+}
+
+void PlatformWaitSemaphore(PlatformSemaphore Semaphore)
+{
+    while (sem_wait((sem_t*)Semaphore) != 0 && errno == EINTR)
+    {
+    }
+}
+
+PlatformThreadSlot PlatformAllocateThreadSlot()
+{
+    pthread_key_t Key;
+    pthread_key_create(&Key, nullptr);
+
+    return (PlatformThreadSlot)Key;
+}
+
+void* PlatformGetThreadSlotValue(PlatformThreadSlot Slot)
+{
+    return pthread_getspecific((pthread_key_t)Slot);
+}
+
+void PlatformSetThreadSlotValue(PlatformThreadSlot Slot, void* Value)
+{
+    pthread_setspecific((pthread_key_t)Slot, Value);
+}
+
+void* PlatformAllocateMemory(size_t Size)
+{
+    return calloc(1, Size);
+}
+
+void PlatformFreeMemory(void* Address)
+{
+    free(Address);
+}
+
+void* PlatformReserveMemory(size_t Size)
+{
+    void* Address = mmap(nullptr, Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return (Address != MAP_FAILED) ? Address : nullptr;
+}
+
+bool PlatformCommitMemory(void* Address, size_t Size)
+{
+    return mprotect(Address, Size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void* PlatformAllocateLargePages(size_t Size)
+{
+    //Huge pages are only used for ranges aligned to their size, so map a page more and trim both ends
+    uint8_t* Mapping = (uint8_t*)mmap(nullptr, Size + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (Mapping == (uint8_t*)MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    uint8_t* Address = (uint8_t*)(((uintptr_t)Mapping + HugePageSize - 1) & ~(uintptr_t)(HugePageSize - 1));
+    if (Address > Mapping)
+    {
+        munmap(Mapping, Address - Mapping);
+    }
+    munmap(Address + Size, Mapping + HugePageSize - Address);
+
+    if (madvise(Address, Size, MADV_HUGEPAGE) != 0)
+    {
+        munmap(Address, Size);
+        return nullptr;
+    }
+
+    return Address;
+}
+
+void PlatformReleaseMemory(void* Address, size_t Size)
+{
+    munmap(Address, Size);
+}
+
+uint32_t PlatformGetPageSize()
+{
+    long Size = sysconf(_SC_PAGESIZE);
+
+    return (Size > 0) ? (uint32_t)Size : 4096;
+}
+
+size_t PlatformGetLargePageSize()
+{
+    return HugePageSize;
+}
+
+uint64_t PlatformGetPageFaultCount()
+{
+    rusage Usage;
+    if (getrusage(RUSAGE_SELF, &Usage) != 0)
+    {
+        return 0;
+    }
+
+    return (uint64_t)Usage.ru_minflt + (uint64_t)Usage.ru_majflt;
+}
+
+bool PlatformWriteFile(const char* Path, const void* Data, uint32_t Size)
+{
+    int File = open(Path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (File < 0)
+    {
+        return false;
+    }
+
+    const uint8_t* Remaining = (const uint8_t*)Data;
+    uint32_t RemainingSize = Size;
+    while (RemainingSize > 0)
+    {
+        ssize_t Written = write(File, Remaining, RemainingSize);
+        if (Written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (Written <= 0)
+        {
+            break;
+        }
+
+        Remaining += Written;
+        RemainingSize -= (uint32_t)Written;
+    }
+
+    close(File);
+
+    return RemainingSize == 0;
+}
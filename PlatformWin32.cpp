@@ -0,0 +1,280 @@
+#include "Platform.h"
+#include "Globals.h"
+
+#include <psapi.h>
+#include <timeapi.h>
+
+//Missing from older SDK headers, supported since Windows 10 1803
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+uint64_t PlatformGetTicks()
+{
+    LARGE_INTEGER Counter;
+    QueryPerformanceCounter(&Counter);
+
+    return (uint64_t)Counter.QuadPart;
+}
+
+uint64_t PlatformGetTickFrequency()
+{
+    LARGE_INTEGER Frequency;
+    QueryPerformanceFrequency(&Frequency);
+
+    return (uint64_t)Frequency.QuadPart;
+}
+
+double PlatformGetSeconds()
+{
+    //Through signed integers, the 32 bit build has no helpers for unsigned 64 bit conversions
+    return (double)(int64_t)PlatformGetTicks() / (double)(int64_t)PlatformGetTickFrequency();
+}
+
+//Kernel and user time from GetThreadTimes, converted from 100ns units
+//It only advances with the scheduler's clock interrupt, so a single frame reads as 0 or a whole interrupt period
+//Summed over the governor's two second windows the rounding evens out, cycle counts would need a cycle rate which varies with the clock
+uint64_t PlatformGetThreadCPUTicks()
+{
+    FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+    if (!GetThreadTimes(GetCurrentThread(), &CreationTime, &ExitTime, &KernelTime, &UserTime))
+    {
+        return 0;
+    }
+
+    uint64_t Time = ((uint64_t)KernelTime.dwHighDateTime << 32 | KernelTime.dwLowDateTime) + ((uint64_t)UserTime.dwHighDateTime << 32 | UserTime.dwLowDateTime);
+    //Through doubles, 64 bit division isn't available in the CRT free build
+    return (uint64_t)(int64_t)((double)(int64_t)Time * ((double)(int64_t)PlatformGetTickFrequency() / 10000000.0));
+}
+
+uint32_t PlatformGetProcessorCount()
+{
+    SYSTEM_INFO SystemInfo;
+    GetSystemInfo(&SystemInfo);
+
+    return SystemInfo.dwNumberOfProcessors;
+}
+
+struct ThreadStartData
+{
+    PlatformThreadFunction Function;
+    void* Parameter;
+};
+
+static DWORD WINAPI ThreadStart(LPVOID lpParameter)
+{
+    ThreadStartData StartData = *(ThreadStartData*)lpParameter;
+    delete (ThreadStartData*)lpParameter;
+
+    return StartData.Function(StartData.Parameter);
+}
+
+PlatformThread PlatformCreateThread(PlatformThreadFunction Function, void* Parameter)
+{
+    ThreadStartData* StartData = new ThreadStartData;
+    StartData->Function = Function;
+    StartData->Parameter = Parameter;
+
+    return CreateThread(NULL, 0, &ThreadStart, StartData, 0, NULL);
+}
+
+void PlatformJoinThread(PlatformThread Thread)
+{
+    WaitForSingleObject(Thread, INFINITE);
+    CloseHandle(Thread);
+}
+
+void PlatformYieldThread()
+{
+    SwitchToThread();
+}
+
+struct Win32WaitTimer
+{
+    HANDLE Timer;
+    //Raising the resolution makes the whole system tick faster for as long as we run, so it's only done without high resolution timers
+    bool bRaisedTimerResolution;
+};
+
+PlatformWaitTimer PlatformCreateWaitTimer()
+{
+    Win32WaitTimer* WaitTimer = new Win32WaitTimer;
+    WaitTimer->Timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    WaitTimer->bRaisedTimerResolution = false;
+
+    if (!WaitTimer->Timer)
+    {
+        //Regular waitable timers wake up on the system tick, ask for it to be 1 millisecond
+        WaitTimer->Timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+        WaitTimer->bRaisedTimerResolution = (timeBeginPeriod(1) == TIMERR_NOERROR);
+    }
+
+    return WaitTimer;
+}
+
+void PlatformDestroyWaitTimer(PlatformWaitTimer Timer)
+{
+    Win32WaitTimer* WaitTimer = (Win32WaitTimer*)Timer;
+    if (WaitTimer->bRaisedTimerResolution)
+    {
+        timeEndPeriod(1);
+    }
+
+    CloseHandle(WaitTimer->Timer);
+    delete WaitTimer;
+}
+
+void PlatformWaitUntil(PlatformWaitTimer Timer, uint64_t Ticks)
+{
+    uint64_t Now = PlatformGetTicks();
+    if (Ticks <= Now)
+    {
+        return;
+    }
+
+    //Due time is relative when negative, in 100 nanosecond units
+    double Seconds = (double)(int64_t)(Ticks - Now) / (double)(int64_t)PlatformGetTickFrequency();
+    LARGE_INTEGER DueTime;
+    DueTime.QuadPart = -(int64_t)(Seconds * 10000000.0);
+    if (DueTime.QuadPart == 0)
+    {
+        return;
+    }
+
+    HANDLE WaitableTimer = ((Win32WaitTimer*)Timer)->Timer;
+    if (SetWaitableTimer(WaitableTimer, &DueTime, 0, NULL, NULL, FALSE))
+    {
+        WaitForSingleObject(WaitableTimer, INFINITE);
+    }
+}
+
+PlatformSemaphore PlatformCreateSemaphore(uint32_t MaxCount)
+{
+    return CreateSemaphoreA(NULL, 0, MaxCount, NULL);
+}
+
+void PlatformDestroySemaphore(PlatformSemaphore Semaphore)
+{
+    CloseHandle(Semaphore);
+}
+
+void PlatformSignalSemaphore(PlatformSemaphore Semaphore, uint32_t Count)
+{
+    ReleaseSemaphore(Semaphore, Count, NULL);
+}
+
+void PlatformWaitSemaphore(PlatformSemaphore Semaphore)
+{
+    WaitForSingleObject(Semaphore, INFINITE);
+}
+
+PlatformThreadSlot PlatformAllocateThreadSlot()
+{
+    return (PlatformThreadSlot)TlsAlloc();
+}
+
+void* PlatformGetThreadSlotValue(PlatformThreadSlot Slot)
+{
+    return TlsGetValue(Slot);
+}
+
+void PlatformSetThreadSlotValue(PlatformThreadSlot Slot, void* Value)
+{
+    TlsSetValue(Slot, Value);
+}
+
+void* PlatformAllocateMemory(size_t Size)
+{
+    return VirtualAlloc(0, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void PlatformFreeMemory(void* Address)
+{
+    VirtualFree(Address, 0, MEM_RELEASE);
+}
+
+void* PlatformReserveMemory(size_t Size)
+{
+    return VirtualAlloc(0, Size, MEM_RESERVE, PAGE_READWRITE);
+}
+
+bool PlatformCommitMemory(void* Address, size_t Size)
+{
+    return VirtualAlloc(Address, Size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+//Large pages need SeLockMemoryPrivilege, which has to be granted to the user by policy and then enabled in the process token
+static bool EnableLockMemoryPrivilege()
+{
+    HANDLE Token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &Token))
+    {
+        return false;
+    }
+
+    TOKEN_PRIVILEGES Privileges;
+    Privileges.PrivilegeCount = 1;
+    Privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool bResult = LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &Privileges.Privileges[0].Luid)
+        && AdjustTokenPrivileges(Token, FALSE, &Privileges, 0, NULL, NULL)
+        //Succeeds without enabling anything if the user doesn't hold the privilege
+        && GetLastError() == ERROR_SUCCESS;
+    CloseHandle(Token);
+
+    return bResult;
+}
+
+void* PlatformAllocateLargePages(size_t Size)
+{
+    if (PlatformGetLargePageSize() == 0 || !EnableLockMemoryPrivilege())
+    {
+        return nullptr;
+    }
+
+    //Large pages can't be reserved and committed separately, nor paged out
+    return VirtualAlloc(0, Size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+}
+
+void PlatformReleaseMemory(void* Address, size_t Size)
+{
+    VirtualFree(Address, 0, MEM_RELEASE);
+}
+
+uint32_t PlatformGetPageSize()
+{
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+
+    return Info.dwPageSize;
+}
+
+size_t PlatformGetLargePageSize()
+{
+    return GetLargePageMinimum();
+}
+
+uint64_t PlatformGetPageFaultCount()
+{
+    PROCESS_MEMORY_COUNTERS Counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+    {
+        return 0;
+    }
+
+    return Counters.PageFaultCount;
+}
+
+bool PlatformWriteFile(const char* Path, const void* Data, uint32_t Size)
+{
+    HANDLE File = CreateFileA(Path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (File == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    DWORD Written = 0;
+    BOOL bResult = WriteFile(File, Data, Size, &Written, NULL);
+    CloseHandle(File);
+
+    return bResult && Written == Size;
+}
@@ -0,0 +1,119 @@
+#include "PresentThread.h"
+
+#ifdef _WIN32
+PresentThread::PresentThread(CPURenderer& InRenderer, HWND InWindowHandle)
+    : Renderer(InRenderer), WindowHandle(InWindowHandle)
+{
+    Start();
+}
+#endif
+
+PresentThread::PresentThread(CPURenderer& InRenderer, PresentSurface& InSurface)
+    : Renderer(InRenderer), Surface(&InSurface)
+{
+    Start();
+}
+
+void PresentThread::Start()
+{
+    bShuttingDown = false;
+    PublishedFrameCount = 0;
+    HandledFrameCount = 0;
+    PresentedFrameCount = 0;
+    PresentStartTicks = 0;
+    PresentEndTicks = 0;
+    TotalPresentCPUTicks = 0;
+
+    //Publishes beyond a few pending wake ups are covered by the ones already there, the thread always takes the latest frame
+    WakeSemaphore = PlatformCreateSemaphore(4);
+    Thread = PlatformCreateThread(&PresentThread::ThreadMain, this);
+}
+
+PresentThread::~PresentThread()
+{
+    bShuttingDown = true;
+    PlatformSignalSemaphore(WakeSemaphore, 1);
+    PlatformJoinThread(Thread);
+    PlatformDestroySemaphore(WakeSemaphore);
+}
+
+void PresentThread::Publish()
+{
+    Renderer.PublishFrame();
+    PublishedFrameCount.fetch_add(1);
+    PlatformSignalSemaphore(WakeSemaphore, 1);
+}
+
+void PresentThread::WaitUntilIdle()
+{
+    while (HandledFrameCount.load() != PublishedFrameCount.load())
+    {
+        PlatformYieldThread();
+    }
+}
+
+uint64_t PresentThread::GetPresentTicksWithin(uint64_t StartTicks, uint64_t EndTicks) const
+{
+    uint64_t Start = PresentStartTicks.load();
+    uint64_t End = PresentEndTicks.load();
+    if (End < Start)
+    {
+        End = PlatformGetTicks();
+    }
+
+    Start = (Start > StartTicks) ? Start : StartTicks;
+    End = (End < EndTicks) ? End : EndTicks;
+
+    return (End > Start) ? End - Start : 0;
+}
+
+uint32_t PresentThread::ThreadMain(void* Parameter)
+{
+    PresentThread* Presenter = (PresentThread*)Parameter;
+
+    while (true)
+    {
+        PlatformWaitSemaphore(Presenter->WakeSemaphore);
+        if (Presenter->bShuttingDown.load())
+        {
+            break;
+        }
+
+        uint32_t PublishedFrameCount = Presenter->PublishedFrameCount.load();
+
+        uint64_t StartTicks = PlatformGetTicks();
+        uint64_t StartCPUTicks = PlatformGetThreadCPUTicks();
+        Presenter->PresentStartTicks = StartTicks;
+        bool bPresented;
+        {
+            ProfileScope Scope = { &Presenter->Profiler, PhasePresent };
+#ifdef _WIN32
+            if (Presenter->WindowHandle)
+            {
+                bPresented = Presenter->Renderer.PresentLatest(Presenter->WindowHandle, &Presenter->Profiler);
+            }
+            else
+#endif
+            {
+                bPresented = Presenter->Renderer.PresentLatest(*Presenter->Surface, &Presenter->Profiler);
+            }
+        }
+        uint64_t EndTicks = PlatformGetTicks();
+        Presenter->PresentEndTicks = EndTicks;
+        Presenter->TotalPresentCPUTicks.fetch_add(PlatformGetThreadCPUTicks() - StartCPUTicks);
+
+        if (bPresented)
+        {
+            Presenter->PresentedFrameCount.fetch_add(1);
+            Presenter->Profiler.EndFrame();
+        }
+        else
+        {
+            Presenter->Profiler.DiscardFrame();
+        }
+
+        Presenter->HandledFrameCount.store(PublishedFrameCount);
+    }
+
+    return 0;
+}
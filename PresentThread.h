@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Globals.h"
+#include "Platform.h"
+#include "CPURenderer.h"
+#include "FrameProfiler.h"
+
+#include <atomic>
+
+//Presents frames a renderer publishes on a thread of its own, so the next frame is built while the previous one is blitted
+//A blit that stalls only delays or drops frames on screen, the thread publishing never waits for it
+class PresentThread
+{
+public:
+#ifdef _WIN32
+    PresentThread(CPURenderer& InRenderer, HWND InWindowHandle);
+#endif
+    PresentThread(CPURenderer& InRenderer, PresentSurface& InSurface);
+    ~PresentThread();
+
+    //Publishes the renderer's current frame and wakes the thread up, called from the thread drawing into the renderer
+    void Publish();
+    //Blocks until every published frame has been presented or replaced by a newer one
+    void WaitUntilIdle();
+
+    //Ticks between StartTicks and EndTicks during which the thread was presenting, only the most recent present is looked at
+    uint64_t GetPresentTicksWithin(uint64_t StartTicks, uint64_t EndTicks) const;
+    //CPU time in ticks spent presenting since the thread started, waits on the OS inside a present aren't counted
+    uint64_t GetTotalPresentCPUTicks() const { return TotalPresentCPUTicks.load(); }
+
+    uint32_t GetPublishedFrameCount() const { return PublishedFrameCount.load(); }
+    uint32_t GetPresentedFrameCount() const { return PresentedFrameCount.load(); }
+
+    //Records PhasePresent and PhasePresentBlit of every presented frame
+    FrameProfiler Profiler;
+
+private:
+    void Start();
+    static uint32_t ThreadMain(void* Parameter);
+
+    CPURenderer& Renderer;
+#ifdef _WIN32
+    HWND WindowHandle = NULL;
+#endif
+    PresentSurface* Surface = nullptr;
+
+    PlatformThread Thread;
+    PlatformSemaphore WakeSemaphore;
+    std::atomic<bool> bShuttingDown;
+
+    //Bumped only after the frame is exchanged, so a count read before presenting is covered by that present
+    std::atomic<uint32_t> PublishedFrameCount;
+    //Publishes handled so far, every frame up to this one was presented or dropped
+    std::atomic<uint32_t> HandledFrameCount;
+    std::atomic<uint32_t> PresentedFrameCount;
+    //End is before start while a present is running
+    std::atomic<uint64_t> PresentStartTicks;
+    std::atomic<uint64_t> PresentEndTicks;
+    std::atomic<uint64_t> TotalPresentCPUTicks;
+};
@@ -0,0 +1,172 @@
+#include "QualityGovernor.h"
+
+#include "MonitorLayout.h"
+
+//Cheapest losses first: fewer stars, slower refills, then frame rate and render scale, which make what's left coarser
+static const QualityLevel QualityLevels[QualityGovernor::LevelCount] =
+{
+    { 8, 1, 1, 1 },
+    { 6, 1, 1, 1 },
+    { 6, 2, 1, 1 },
+    { 6, 2, 1, 2 },
+    { 4, 2, 1, 2 },
+    { 4, 2, 2, 2 },
+    { 4, 4, 2, 4 },
+    { 2, 4, 2, 4 },
+    { 2, 4, 4, 8 },
+};
+
+//Budget is given in hundredths of a percent
+static const uint64_t BudgetOne = 10000;
+
+void QualityGovernor::SetBudget(uint32_t InBudget, uint64_t TickFrequency)
+{
+    if (InBudget == Budget && WindowTicks != 0)
+    {
+        return;
+    }
+
+    Budget = InBudget;
+    WindowTicks = TickFrequency * WindowSeconds;
+    WindowCostTicks = 0;
+    WindowCoveredTicks = 0;
+    CalmWindowCount = 0;
+    RequiredCalmWindows = MinCalmWindows;
+    bJustUpgraded = false;
+
+    if (Budget == 0)
+    {
+        Level = 0;
+    }
+}
+
+bool QualityGovernor::AddFrame(uint64_t CostTicks, uint64_t CoveredTicks)
+{
+    if (Budget == 0)
+    {
+        return false;
+    }
+
+    WindowCostTicks += CostTicks;
+    WindowCoveredTicks += CoveredTicks;
+    if (WindowCoveredTicks < WindowTicks)
+    {
+        return false;
+    }
+
+    LastCostTicks = WindowCostTicks;
+    LastCoveredTicks = WindowCoveredTicks;
+    WindowCostTicks = 0;
+    WindowCoveredTicks = 0;
+
+    //Cost over covered time compared to the budget without dividing, 64 bit division isn't available in the CRT free build
+    uint64_t ScaledCost = LastCostTicks * BudgetOne;
+    uint64_t AllowedCost = LastCoveredTicks * Budget;
+
+    if (ScaledCost > AllowedCost)
+    {
+        CalmWindowCount = 0;
+        if (bJustUpgraded)
+        {
+            RequiredCalmWindows = (RequiredCalmWindows * 2 < MaxCalmWindows) ? RequiredCalmWindows * 2 : MaxCalmWindows;
+        }
+        bJustUpgraded = false;
+
+        if (Level + 1 >= LevelCount)
+        {
+            return false;
+        }
+
+        uint32_t NewLevel = (ScaledCost > AllowedCost * FastDowngradeFactor && Level + 2 < LevelCount) ? Level + 2 : Level + 1;
+        ChangeLevel(NewLevel);
+        DowngradeCount++;
+        return true;
+    }
+
+    bJustUpgraded = false;
+    if (ScaledCost * 2 >= AllowedCost || Level == 0)
+    {
+        CalmWindowCount = 0;
+        return false;
+    }
+
+    if (++CalmWindowCount < RequiredCalmWindows)
+    {
+        return false;
+    }
+
+    CalmWindowCount = 0;
+    ChangeLevel(Level - 1);
+    UpgradeCount++;
+    bJustUpgraded = true;
+    return true;
+}
+
+void QualityGovernor::ChangeLevel(uint32_t NewLevel)
+{
+    Level = NewLevel;
+    //Frames of the old level don't say anything about the new one
+    WindowCostTicks = 0;
+    WindowCoveredTicks = 0;
+}
+
+const QualityLevel& QualityGovernor::GetQuality() const
+{
+    return QualityLevels[Level];
+}
+
+uint32_t QualityGovernor::GetStarBudget(uint32_t StarBudget) const
+{
+    uint32_t Result = StarBudget * QualityLevels[Level].StarEighths / 8;
+
+    return (Result > 0) ? Result : 1;
+}
+
+uint32_t QualityGovernor::GetFrameRate(uint32_t FrameRate) const
+{
+    uint32_t Result = FrameRate / QualityLevels[Level].FrameRateDivisor;
+
+    return (Result > 0) ? Result : 1;
+}
+
+uint32_t QualityGovernor::GetRenderScale(uint32_t RenderScale) const
+{
+    uint32_t Result = RenderScale * QualityLevels[Level].RenderScaleFactor;
+
+    return (Result < MaxRenderScale) ? Result : MaxRenderScale;
+}
+
+double QualityGovernor::GetLastLoad() const
+{
+    if (LastCoveredTicks == 0)
+    {
+        return 0.0;
+    }
+
+    return (double)(int64_t)LastCostTicks * (double)BudgetOne / (double)(int64_t)LastCoveredTicks;
+}
+
+void QualityGovernor::WriteReport(ReportWriter& Report) const
+{
+    const QualityLevel& Quality = QualityLevels[Level];
+
+    Report.Append("{ \"budget\": ");
+    Report.AppendUInt(Budget);
+    Report.Append(", \"last_load\": ");
+    Report.AppendFloat(GetLastLoad(), 1);
+    Report.Append(", \"level\": ");
+    Report.AppendUInt(Level);
+    Report.Append(", \"downgrades\": ");
+    Report.AppendUInt(DowngradeCount);
+    Report.Append(", \"upgrades\": ");
+    Report.AppendUInt(UpgradeCount);
+    Report.Append(", \"star_eighths\": ");
+    Report.AppendUInt(Quality.StarEighths);
+    Report.Append(", \"spawn_rate_divisor\": ");
+    Report.AppendUInt(Quality.SpawnRateDivisor);
+    Report.Append(", \"render_scale_factor\": ");
+    Report.AppendUInt(Quality.RenderScaleFactor);
+    Report.Append(", \"frame_rate_divisor\": ");
+    Report.AppendUInt(Quality.FrameRateDivisor);
+    Report.Append(" }");
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Globals.h"
+#include "Benchmark.h"
+
+//How much a governor level lowers quality, applied on top of what the settings ask for
+struct QualityLevel
+{
+    //Eighths of the star budget kept alive
+    uint32_t StarEighths;
+    //Stars spawned per update are divided by this, refills are spread over more frames
+    uint32_t SpawnRateDivisor;
+    //Render scale is multiplied by this, up to MaxRenderScale
+    uint32_t RenderScaleFactor;
+    //Frame rate is divided by this, down to one frame per second
+    uint32_t FrameRateDivisor;
+};
+
+//Trades quality for CPU time, so a thread stays within a share of one core on anything from thin clients to workstations
+//Frame costs are summed over windows of WindowSeconds of shown time, a window over the budget lowers quality a level
+//Quality is only raised again after several windows in a row used less than half the budget, and after every raise that had to be taken back it waits twice as long
+//Has no constructor so it can live in thread data of the CRT free build, a zeroed governor is off
+class QualityGovernor
+{
+public:
+    //Budget is in hundredths of a percent of one core, 0 turns the governor off and goes back to full quality
+    //Costs are measured in ticks of TickFrequency, an unchanged budget keeps level and measurements
+    void SetBudget(uint32_t InBudget, uint64_t TickFrequency);
+
+    //CostTicks is the CPU time a frame took and CoveredTicks the time it stood for, all its updates included
+    //Returns true if the level changed, the frame loop applies it before the next frame
+    bool AddFrame(uint64_t CostTicks, uint64_t CoveredTicks);
+
+    uint32_t GetBudget() const { return Budget; }
+    uint32_t GetLevel() const { return Level; }
+    const QualityLevel& GetQuality() const;
+
+    //Values of the settings lowered to the current level
+    uint32_t GetStarBudget(uint32_t StarBudget) const;
+    uint32_t GetFrameRate(uint32_t FrameRate) const;
+    uint32_t GetRenderScale(uint32_t RenderScale) const;
+
+    //Load of the last complete window in hundredths of a percent of one core, 0 before the first one
+    double GetLastLoad() const;
+    uint32_t GetDowngradeCount() const { return DowngradeCount; }
+    uint32_t GetUpgradeCount() const { return UpgradeCount; }
+
+    //Appends budget, level, last load, level changes and what the level lowers as a JSON object
+    void WriteReport(ReportWriter& Report) const;
+
+    static const uint32_t LevelCount = 9;
+    static const uint32_t WindowSeconds = 2;
+    //Windows in a row below half the budget before quality is raised, doubled up to the max whenever a raise is taken back
+    static const uint32_t MinCalmWindows = 3;
+    static const uint32_t MaxCalmWindows = 48;
+    //Windows this many times over the budget lower quality two levels at once
+    static const uint32_t FastDowngradeFactor = 4;
+
+private:
+    void ChangeLevel(uint32_t NewLevel);
+
+    uint32_t Budget;
+    uint32_t Level;
+    uint64_t WindowTicks;
+
+    uint64_t WindowCostTicks;
+    uint64_t WindowCoveredTicks;
+    uint64_t LastCostTicks;
+    uint64_t LastCoveredTicks;
+
+    uint32_t CalmWindowCount;
+    uint32_t RequiredCalmWindows;
+    //Set by a raise until the window after it is complete, a downgrade in it means the raise didn't hold
+    bool bJustUpgraded;
+
+    uint32_t DowngradeCount;
+    uint32_t UpgradeCount;
+};
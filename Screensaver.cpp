@@ -1,12 +1,22 @@
 #include "Globals.h"
 
 #include <atomic>
+#include <new>
 
 #include "resource.h"
 
 #include "CPURenderer.h"
+#include "PresentThread.h"
 #include "World.h"
 #include "FrameTimer.h"
+#include "StarAtlas.h"
+#include "Benchmark.h"
+#include "MonitorLayout.h"
+#include "MemoryArena.h"
+#include "CommandQueue.h"
+#include "Visibility.h"
+#include "Settings.h"
+#include "QualityGovernor.h"
 
 static POINT InitialMousePosition;
 static HINSTANCE hMainInstance;
@@ -14,47 +24,594 @@ static HWND hMainWindow;
 static bool bClosing = false;
 static bool bPreviewMode = false;
 
-static const CHAR MaxStarCountSettingLabel[] = "Max star count";
 static const CHAR SettingsRegistryPath[] = "SOFTWARE\\Starry night";
+static const CHAR BenchmarkReportPath[] = "StarryNightBenchmark.json";
+static const CHAR ProfileReportFileName[] = "StarryNightProfile";
+static const CHAR PresentProfileReportFileName[] = "StarryNightPresentProfile";
+static const CHAR MemoryReportFileName[] = "StarryNightMemory";
+//Broadcasting this registered message makes every update thread write its profile report
+static const CHAR ProfileReportMessageName[] = "StarryNightWriteProfile";
+//Broadcast by the configuration dialog after saving, running screen savers read the settings again and apply them without restarting
+static const CHAR SettingsChangedMessageName[] = "StarryNightSettingsChanged";
+
+//Win8 WinEvents for the compositor cloaking a window, e.g. while another virtual desktop is shown, defined here in case the SDK targets older versions
+#ifndef EVENT_OBJECT_CLOAKED
+#define EVENT_OBJECT_CLOAKED 0x8017
+#define EVENT_OBJECT_UNCLOAKED 0x8018
+#endif
+//GUID_CONSOLE_DISPLAY_STATE, defined here so no GUID library has to be linked
+static const GUID DisplayStateGuid = { 0x6FE69556, 0x704A, 0x47A0, { 0x8F, 0x24, 0xC2, 0x8D, 0x93, 0x6F, 0xDA, 0x47 } };
+
+static UINT ProfileReportMessage = 0;
+static UINT SettingsChangedMessage = 0;
+
+//Every monitor gets its own world, renderer and update thread, covering just the part of the window the monitor shows
+//Written by the window thread before the update thread is created, everything changing afterwards goes through its command queue
+struct ScreensaverThreadData
+{
+    //Size of the rendered buffer, the monitor's size divided by RenderScale
+    uint32_t Width;
+    uint32_t Height;
+    //Placement in the window, the governor resizes to it when it changes the render scale
+    MonitorRect Monitor;
+    //Monitor pixels per rendered pixel, the buffer is stretched to the monitor when presented
+    uint32_t RenderScale;
+    //Star arrays are sized for it and grow when the budget is raised later
+    uint32_t StarBudget;
+    uint32_t RasterWorkerCount;
+    uint64_t RandomSeed;
+    uint32_t MonitorIndex;
+    //Thread's own copy, replaced by CommandApplySettings, star size and drift speed are scaled to rendered pixels by the thread
+    SettingsSnapshot Settings;
+    //Committed up front by the thread, everything it allocates while running is expected to fit
+    size_t ArenaSize;
+};
 
-static std::atomic<bool> g_Running = false;
+//Changes the window thread asks an update thread for, applied by the update thread between two frames
+enum UpdateCommandType : uint32_t
+{
+    //Monitor is the new placement of the thread's monitor in the window and Value its render scale, the world and renderer are resized in place or rebuilt if they outgrow their buffers
+    CommandResize,
+    //Value is an UpdatePauseReason, the thread stops drawing and sleeps until the last reason is taken back, its world and renderer are kept
+    CommandPause,
+    //Value is the UpdatePauseReason taken back, leaving the last one catches the world up on the time spent paused
+    CommandResume,
+    //Value is the new star budget
+    CommandSetStarBudget,
+    //Settings replace the thread's copy, frame rate, star sizes, lifetimes and drift speed change from the next frame on
+    //Raster threads and large pages are only read when a thread starts
+    CommandApplySettings,
+    CommandWriteReports,
+    //Thread writes its reports and exits, nothing is posted after it
+    CommandShutdown,
+};
 
-struct ScreensaverThreadData
+//Why a thread is paused, a bit each
+enum UpdatePauseReason : uint32_t
+{
+    //Thread's monitor isn't part of the layout anymore
+    PauseMonitorGone = 1 << 0,
+    //Window can't be seen, see VisibilityTracker
+    PauseHidden = 1 << 1,
+};
+
+struct UpdateCommand
+{
+    UpdateCommandType Type;
+    uint32_t Value;
+    MonitorRect Monitor;
+    //When the window thread posted it, resize latency is measured from here
+    uint64_t PostTicks;
+    SettingsSnapshot Settings;
+};
+
+//A layout change posts a few commands per thread, the thread takes all of them before its next frame
+static const uint32_t UpdateCommandQueueCapacity = 64;
+
+//Resizes handled by the update thread, latency runs from the window thread's request to the first frame published at the new size
+struct ResizeStats
+{
+    uint32_t Count;
+    //Resizes and render scale changes which outgrew the buffers and built a new world and renderer
+    uint32_t RebuildCount;
+    //Stars dropped by the last resize which kept the world, a rebuilt one starts without stars
+    uint32_t LastDroppedStars;
+    double LastMilliseconds;
+    double LastLatencyMilliseconds;
+    double MaxLatencyMilliseconds;
+};
+
+//Time the update thread spent paused, without drawing or waking up for frames
+struct ParkStats
+{
+    uint32_t Count;
+    double Milliseconds;
+    double LastMilliseconds;
+};
+
+//Cost of getting from thread start to the first frame, measured by the update thread
+struct InitializationStats
 {
-    uint32_t WindowWidth;
-    uint32_t WindowHeight;
-    uint32_t MaxStarCount;
+    double Milliseconds;
+    uint64_t PageFaultCount;
+    uint32_t OSCallCount;
 };
 
+//Update threads are started once per monitor slot and live until the window is destroyed, display changes reach them as commands
 struct RunnableThread
 {
     static DWORD ThreadMain(LPVOID lpParameter);
 
+    //Called from the window thread only, never blocks on the update thread
+    void Post(UpdateCommand Command);
+
     ScreensaverThreadData Data;
+    //NULL until the thread is started
     HANDLE ThreadHandle;
+    //Signaled for commands posted while the thread is paused, it sleeps on it until one comes
+    PlatformSemaphore WakeSemaphore;
+    //Window thread's view of the UpdatePauseReasons, set when posting CommandPause and cleared when posting CommandResume
+    uint32_t PauseReasons;
+    //Reserved and committed once when the thread starts, everything it allocates while running comes from here
+    MemoryArena Arena;
+    CommandQueue<UpdateCommand, UpdateCommandQueueCapacity> Commands;
 private:
     uint32_t Run();
-} g_MainUpdateThread;
+    void WriteReports(const FrameProfiler& Profiler, const FrameProfiler& PresentProfiler, const InitializationStats& Initialization, const ResizeStats& Resizes, const ParkStats& Parks, const QualityGovernor& Governor) const;
+    void WriteMemoryReport(const InitializationStats& Stats, const ResizeStats& Resizes, const ParkStats& Parks, const QualityGovernor& Governor) const;
+};
+
+static RunnableThread g_UpdateThreads[MonitorLayout::MaxMonitors];
+//Threads started so far, the ones past the current monitor count are paused
+static uint32_t g_UpdateThreadCount = 0;
+//Fed by the window procedure, every thread is paused while it says the window can't be seen
+static VisibilityTracker g_Visibility;
+static HPOWERNOTIFY g_DisplayStateNotification = NULL;
+static HWINEVENTHOOK g_CloakHook = NULL;
+static HWND g_ScreensaverWindow = NULL;
+
+//Reports go to the temp directory as <FileName><monitor index>.json, screen savers usually run from System32 which isn't writable
+static void WriteReportFile(const ReportWriter& Report, const CHAR* FileName, uint32_t MonitorIndex)
+{
+    CHAR Path[MAX_PATH + 32];
+    DWORD Length = GetTempPathA(MAX_PATH, Path);
+    if (Length == 0 || Length > MAX_PATH)
+    {
+        return;
+    }
+
+    for (const CHAR* Name = FileName; *Name; Name++)
+    {
+        Path[Length++] = *Name;
+    }
+
+    if (MonitorIndex >= 10)
+    {
+        Path[Length++] = (CHAR)('0' + MonitorIndex / 10);
+    }
+    Path[Length++] = (CHAR)('0' + MonitorIndex % 10);
+
+    for (const CHAR* Extension = ".json"; *Extension; Extension++)
+    {
+        Path[Length++] = *Extension;
+    }
+    Path[Length] = 0;
+
+    Report.WriteToFile(Path);
+}
+
+static void WriteProfileReport(const FrameProfiler& Profiler, const CHAR* FileName, uint32_t MonitorIndex)
+{
+    ReportWriter Report;
+    Profiler.WriteReport(Report);
+    Report.Append("\n");
+    WriteReportFile(Report, FileName, MonitorIndex);
+}
+
+void RunnableThread::Post(UpdateCommand Command)
+{
+    Command.PostTicks = PlatformGetTicks();
+
+    //Thread empties its queue before every frame and whenever it's woken up, so a full queue only lasts until then
+    while (!Commands.Push(Command))
+    {
+        PlatformYieldThread();
+    }
+
+    //Running threads pick commands up without being woken, signaling them would only leave spurious wake ups for their next pause
+    if (PauseReasons != 0)
+    {
+        PlatformSignalSemaphore(WakeSemaphore, 1);
+    }
+}
+
+//Reports are freed right away, going to the OS keeps repeated requests from filling the arena
+void RunnableThread::WriteReports(const FrameProfiler& Profiler, const FrameProfiler& PresentProfiler, const InitializationStats& Initialization, const ResizeStats& Resizes, const ParkStats& Parks, const QualityGovernor& Governor) const
+{
+    ThreadArenaScope ReportScope = { nullptr };
+    WriteProfileReport(Profiler, ProfileReportFileName, Data.MonitorIndex);
+    WriteProfileReport(PresentProfiler, PresentProfileReportFileName, Data.MonitorIndex);
+    WriteMemoryReport(Initialization, Resizes, Parks, Governor);
+}
+
+void RunnableThread::WriteMemoryReport(const InitializationStats& Stats, const ResizeStats& Resizes, const ParkStats& Parks, const QualityGovernor& Governor) const
+{
+    MemoryArenaStats ArenaStats = Arena.GetStats();
+
+    ReportWriter Report;
+    Report.Append("{ \"initialization\": { \"ms\": ");
+    Report.AppendFloat(Stats.Milliseconds);
+    Report.Append(", \"page_faults\": ");
+    Report.AppendUInt((uint32_t)Stats.PageFaultCount);
+    Report.Append(", \"os_calls\": ");
+    Report.AppendUInt(Stats.OSCallCount);
+    Report.Append(" },\n  \"arena\": { \"reserved_bytes\": ");
+    Report.AppendUInt((uint32_t)ArenaStats.ReservedBytes);
+    Report.Append(", \"committed_bytes\": ");
+    Report.AppendUInt((uint32_t)ArenaStats.CommittedBytes);
+    Report.Append(", \"used_bytes\": ");
+    Report.AppendUInt((uint32_t)ArenaStats.UsedBytes);
+    Report.Append(", \"high_water_bytes\": ");
+    Report.AppendUInt((uint32_t)ArenaStats.HighWaterBytes);
+    Report.Append(", \"allocations\": ");
+    Report.AppendUInt(ArenaStats.AllocationCount);
+    Report.Append(", \"live_blocks\": ");
+    Report.AppendUInt(ArenaStats.LiveBlocks);
+    Report.Append(", \"os_calls\": ");
+    Report.AppendUInt(ArenaStats.OSCallCount);
+    Report.Append(", \"page_faults\": ");
+    Report.AppendUInt((uint32_t)ArenaStats.PageFaultCount);
+    Report.Append(", \"large_pages\": ");
+    Report.Append(ArenaStats.bLargePages ? "true" : "false");
+
+    HeapStats Heap = GetHeapStats();
+    Report.Append(" },\n  \"heap\": { \"allocations\": ");
+    Report.AppendUInt(Heap.AllocationCount);
+    Report.Append(", \"live_blocks\": ");
+    Report.AppendUInt(Heap.LiveBlocks);
+    Report.Append(", \"os_calls\": ");
+    Report.AppendUInt(Heap.OSCallCount);
+    Report.Append(" },\n  \"resize\": { \"count\": ");
+    Report.AppendUInt(Resizes.Count);
+    Report.Append(", \"rebuilds\": ");
+    Report.AppendUInt(Resizes.RebuildCount);
+    Report.Append(", \"last_ms\": ");
+    Report.AppendFloat(Resizes.LastMilliseconds);
+    Report.Append(", \"last_latency_ms\": ");
+    Report.AppendFloat(Resizes.LastLatencyMilliseconds);
+    Report.Append(", \"max_latency_ms\": ");
+    Report.AppendFloat(Resizes.MaxLatencyMilliseconds);
+    Report.Append(", \"last_dropped_stars\": ");
+    Report.AppendUInt(Resizes.LastDroppedStars);
+    Report.Append(" },\n  \"park\": { \"count\": ");
+    Report.AppendUInt(Parks.Count);
+    Report.Append(", \"ms\": ");
+    Report.AppendFloat(Parks.Milliseconds);
+    Report.Append(", \"last_ms\": ");
+    Report.AppendFloat(Parks.LastMilliseconds);
+    Report.Append(" },\n  \"quality\": ");
+    Governor.WriteReport(Report);
+    Report.Append(" }\n");
+
+    WriteReportFile(Report, MemoryReportFileName, Data.MonitorIndex);
+}
+
+//Sizes and speeds are set at full resolution, the world gets them scaled to its rendered buffer
+static void ApplyWorldSettings(World& WorldObject, const SettingsSnapshot& Settings, uint32_t RenderScale)
+{
+    WorldObject.SetStarSizeMax(World::GetScaledStarSizeMax(Settings.Get(SettingStarSizeMax), RenderScale));
+    WorldObject.SetLifetimeRange(Settings.Get(SettingMinLifetime), Settings.Get(SettingMaxLifetime));
+    WorldObject.SetDriftSpeed(World::GetScaledDriftSpeed((int32_t)Settings.Get(SettingDriftSpeed), RenderScale));
+}
 
 uint32_t RunnableThread::Run()
 {
-    //Initialize world
-    World WorldObject = { Data.WindowWidth, Data.WindowHeight, Data.MaxStarCount };
+#ifdef _DEBUG
+    //Atlas sprites have to match the per pixel rasterizer, stop in debugger if they don't
+    if (!ValidateStarAtlas())
+    {
+        DebugBreak();
+    }
+#endif
 
-    //Initialize renderer
-    CPURenderer Renderer = { Data.WindowWidth, Data.WindowHeight };
+    uint64_t InitializationStartTicks = PlatformGetTicks();
+    uint64_t StartPageFaultCount = PlatformGetPageFaultCount();
+    uint32_t StartOSCallCount = GetHeapStats().OSCallCount;
 
-    FrameTimer FrameTimerObject = { 1.0f / 15.0f };
+    //World and renderer are allocated from the arena, faulted in before they're built so the first frames don't stall on it
+    //What the thread keeps besides them outlives rebuilding them, which rewinds the arena, so it comes from the OS
+    MemoryArena* WorldArena = Arena.IsInitialized() ? &Arena : nullptr;
+    if (WorldArena)
+    {
+        Arena.Commit(Data.ArenaSize);
+    }
+    SetThreadArena(WorldArena);
+
+    //Initialize world, worlds built again later draw their seeds from the first one's
+    World WorldObject = { Data.Width, Data.Height, Data.StarBudget, Data.RandomSeed };
+    RandomStream RebuildSeeds;
+    RebuildSeeds.Seed(Data.RandomSeed);
+    SettingsSnapshot Settings = Data.Settings;
+    uint32_t RenderScale = Data.RenderScale;
+    ApplyWorldSettings(WorldObject, Settings, RenderScale);
+
+    //Starts at full quality, lowers it while frames take more than the CPU budget and raises it again when there's room
+    QualityGovernor Governor = {};
+    Governor.SetBudget(Settings.Get(SettingCPUBudget), PlatformGetTickFrequency());
+    bool bQualityChanged = false;
+    //What the window thread asked for, the governor's level is applied on top
+    uint32_t StarBudget = Data.StarBudget;
+    MonitorRect Monitor = Data.Monitor;
+    uint32_t BaseRenderScale = Data.RenderScale;
 
-    //Update and render as long as we are running
-    while (g_Running.load())
+    //Initialize renderer
+    CPURenderer Renderer = { Data.Width, Data.Height };
+    Renderer.SetPresentOffset(Data.Monitor.Left, Data.Monitor.Top);
+    Renderer.SetPresentScale(Data.RenderScale);
+
+    //Star rasterization is spread over this monitor's share of the cores once there are enough stars for it to pay off
+    //Workers are started only when the budget first gets there, most monitors' budgets never do
+    WorkerPool* RasterPool = nullptr;
+
+    //Profiler histories of this thread and the present thread are kept over rebuilds of the world and renderer
+    SetThreadArena(nullptr);
+
+    //World is stepped by a fixed time per frame, so frames which are skipped produce the same output as rendering all of them
+    float SecondsPerFrame = 1.0f / (float)Settings.Get(SettingFrameRate);
+    FrameTimer FrameTimerObject = { SecondsPerFrame };
+    FrameProfiler* Profiler = &FrameTimerObject.Profiler;
+    Renderer.SetProfiler(Profiler);
+
+    //Caps how long the thread sleeps through unchanged frames, so commands are picked up within a quarter of a second
+    uint32_t MaxSkippedFrames = Settings.Get(SettingFrameRate) / 4;
+    uint32_t FrameUpdateCount = 1;
+
+    //Frames are blitted on their own thread while the next one is built, so a slow blit doesn't delay updates
+    PresentThread Presenter = { Renderer, hMainWindow };
+    SetThreadArena(WorldArena);
+
+    InitializationStats Initialization;
+    Initialization.Milliseconds = (double)(int64_t)(PlatformGetTicks() - InitializationStartTicks) * 1000.0 / (double)(int64_t)PlatformGetTickFrequency();
+    Initialization.PageFaultCount = PlatformGetPageFaultCount() - StartPageFaultCount;
+    Initialization.OSCallCount = GetHeapStats().OSCallCount - StartOSCallCount;
+
+    ResizeStats Resizes = {};
+    //Request time of a resize whose first frame hasn't been published yet, 0 if there is none
+    uint64_t PendingResizeTicks = 0;
+    uint32_t PauseReasons = 0;
+    ParkStats Parks = {};
+    //When the current pause started, 0 while running
+    uint64_t ParkStartTicks = 0;
+
+    //Update and render until told to shut down
+    while (true)
     {
-        Renderer.Clear();
-        //Rendering is done as part of world update, ideally should split it, but seems a bit overkill for the context
-        WorldObject.Tick(FrameTimerObject.CurrentFrameTime, Renderer);
+        //Commands are applied between frames, of several resizes posted since the last frame only the latest is carried out
+        bool bShutdown = false;
+        bool bWriteReports = false;
+        bool bResize = false;
+        uint64_t RequestTicks = 0;
+
+        UpdateCommand Command;
+        while (Commands.Pop(Command))
+        {
+            switch (Command.Type)
+            {
+                case CommandResize:
+                {
+                    bResize = true;
+                    Monitor = Command.Monitor;
+                    BaseRenderScale = Command.Value;
+                    RequestTicks = Command.PostTicks;
+                } break;
+
+                case CommandPause:
+                {
+                    PauseReasons |= Command.Value;
+                } break;
+
+                case CommandResume:
+                {
+                    PauseReasons &= ~Command.Value;
+                } break;
+
+                case CommandSetStarBudget:
+                {
+                    //Stars spawn from the next update on if the budget went up
+                    StarBudget = Command.Value;
+                    WorldObject.SetStarBudget(Governor.GetStarBudget(StarBudget));
+                    FrameUpdateCount = 1;
+                } break;
+
+                case CommandApplySettings:
+                {
+                    Settings = Command.Settings;
+                    Governor.SetBudget(Settings.Get(SettingCPUBudget), PlatformGetTickFrequency());
+                    ApplyWorldSettings(WorldObject, Settings, RenderScale);
+                    //Frame rate is set along with the governor's level
+                    bQualityChanged = true;
+                } break;
+
+                case CommandWriteReports:
+                {
+                    bWriteReports = true;
+                } break;
+
+                case CommandShutdown:
+                {
+                    bShutdown = true;
+                } break;
+            }
+        }
+
+        if (bShutdown)
+        {
+            break;
+        }
+
+        //Written outside of the profiled phases, the time shows up as a longer next frame only
+        if (bWriteReports)
+        {
+            WriteReports(*Profiler, Presenter.Profiler, Initialization, Resizes, Parks, Governor);
+        }
+
+        //Level set by the governor after the last frame or kept over new settings, render scale goes through the resize below
+        if (bQualityChanged)
+        {
+            uint32_t FrameRate = Governor.GetFrameRate(Settings.Get(SettingFrameRate));
+            SecondsPerFrame = 1.0f / (float)FrameRate;
+            MaxSkippedFrames = FrameRate / 4;
+            FrameTimerObject.SetTargetSecondsPerFrame(SecondsPerFrame);
+            WorldObject.SetStarBudget(Governor.GetStarBudget(StarBudget));
+            WorldObject.SetSpawnRateDivisor(Governor.GetQuality().SpawnRateDivisor);
+            FrameUpdateCount = 1;
+            bQualityChanged = false;
+        }
+
+        if (!RasterPool && Data.RasterWorkerCount > 0 && WorldObject.GetStarBudget() >= CPURenderer::MinStarsForParallelRaster)
+        {
+            ThreadArenaScope PoolScope = { nullptr };
+            RasterPool = new WorkerPool(Data.RasterWorkerCount);
+            Renderer.SetRasterPool(RasterPool);
+        }
+
+        //Display changes keep the world and renderer while their buffers fit, stars still on the monitor stay and it's redrawn whole
+        //Render scales picked by the governor are applied the same way, only display changes count as resizes
+        uint32_t NewRenderScale = Governor.GetRenderScale(BaseRenderScale);
+        if (bResize || NewRenderScale != RenderScale)
+        {
+            uint64_t ResizeStartTicks = PlatformGetTicks();
+
+            //Present thread reads the buffers and their size
+            Presenter.WaitUntilIdle();
+            uint32_t RenderWidth, RenderHeight;
+            GetRenderSize(Monitor, NewRenderScale, RenderWidth, RenderHeight);
+            uint32_t DroppedStars = 0;
+            //Outgrown buffers would stay behind in the arena, so growing past them rewinds it and builds a new world and renderer at the new size
+            //The new world starts empty like the first one, its stars spawn over the next frames
+            if (WorldArena && !Renderer.FitsBuffers(RenderWidth, RenderHeight))
+            {
+                WorldObject.~World();
+                Renderer.~CPURenderer();
+                Arena.Reset();
+                new (&WorldObject) World(RenderWidth, RenderHeight, Governor.GetStarBudget(StarBudget), RebuildSeeds.Next());
+                new (&Renderer) CPURenderer(RenderWidth, RenderHeight);
+                WorldObject.SetSpawnRateDivisor(Governor.GetQuality().SpawnRateDivisor);
+                Renderer.SetProfiler(Profiler);
+                Renderer.SetRasterPool(RasterPool);
+                Resizes.RebuildCount++;
+            }
+            else
+            {
+                Renderer.Resize(RenderWidth, RenderHeight);
+                DroppedStars = WorldObject.Resize(RenderWidth, RenderHeight);
+            }
+            Renderer.SetPresentOffset(Monitor.Left, Monitor.Top);
+            Renderer.SetPresentScale(NewRenderScale);
+            RenderScale = NewRenderScale;
+            ApplyWorldSettings(WorldObject, Settings, RenderScale);
+
+            if (bResize)
+            {
+                Resizes.Count++;
+                Resizes.LastDroppedStars = DroppedStars;
+                Resizes.LastMilliseconds = (double)(int64_t)(PlatformGetTicks() - ResizeStartTicks) * 1000.0 / (double)(int64_t)PlatformGetTickFrequency();
+                PendingResizeTicks = RequestTicks;
+            }
+            //Frame at the new size goes out after one frame time instead of after the unchanged frames the world predicted
+            FrameUpdateCount = 1;
+        }
+
+        //Monitor is gone or the window can't be seen, the thread sleeps without waking up for frames until it's resumed or shut down
+        if (PauseReasons != 0)
+        {
+            if (ParkStartTicks == 0)
+            {
+                ParkStartTicks = PlatformGetTicks();
+                Parks.Count++;
+            }
+
+            PlatformWaitSemaphore(WakeSemaphore);
+            continue;
+        }
+
+        //Sky goes on as if it had been drawn all along, the whole monitor is presented again since whatever covered it left nothing of the last frame
+        if (ParkStartTicks != 0)
+        {
+            uint64_t ParkedTicks = PlatformGetTicks() - ParkStartTicks;
+            Parks.LastMilliseconds = (double)(int64_t)ParkedTicks * 1000.0 / (double)(int64_t)PlatformGetTickFrequency();
+            Parks.Milliseconds += Parks.LastMilliseconds;
+            ParkStartTicks = 0;
+
+            {
+                ProfileScope Scope = { Profiler, PhaseWorldTick };
+                WorldObject.CatchUp((float)(Parks.LastMilliseconds / 1000.0));
+            }
+            Presenter.WaitUntilIdle();
+            Renderer.InvalidateAll();
+            FrameUpdateCount = 1;
+        }
+
+        uint64_t BuildStartTicks = PlatformGetTicks();
+        uint64_t BuildStartCPUTicks = PlatformGetThreadCPUTicks();
+        uint64_t StartPresentCPUTicks = Presenter.GetTotalPresentCPUTicks();
+        uint32_t UpdateCount = FrameUpdateCount;
+        {
+            ProfileScope Scope = { Profiler, PhaseClear };
+            Renderer.Clear();
+        }
+
+        //Updates of skipped frames are run together with the update of the next frame that changes the image
+        {
+            ProfileScope Scope = { Profiler, PhaseWorldTick };
+            for (uint32_t Update = 0; Update < FrameUpdateCount; Update++)
+            {
+                WorldObject.Update(SecondsPerFrame);
+            }
+        }
+
+        {
+            ProfileScope Scope = { Profiler, PhaseStarRender };
+            WorldObject.Render(Renderer);
+            //Rasterized before waiting, so the frame is ready to go the moment it's due
+            Renderer.FlushStars();
+        }
+
+        Profiler->AddPhaseTicks(PhasePresentOverlap, Presenter.GetPresentTicksWithin(BuildStartTicks, PlatformGetTicks()));
+
+        FrameTimerObject.WaitUntilFrametime(FrameUpdateCount);
+
+        {
+            ProfileScope Scope = { Profiler, PhasePresent };
+            Presenter.Publish();
+        }
+
+        if (PendingResizeTicks != 0)
+        {
+            Resizes.LastLatencyMilliseconds = (double)(int64_t)(PlatformGetTicks() - PendingResizeTicks) * 1000.0 / (double)(int64_t)PlatformGetTickFrequency();
+            Resizes.MaxLatencyMilliseconds = (Resizes.LastLatencyMilliseconds > Resizes.MaxLatencyMilliseconds) ? Resizes.LastLatencyMilliseconds : Resizes.MaxLatencyMilliseconds;
+            PendingResizeTicks = 0;
+        }
 
-        FrameTimerObject.WaitUntilFrametime();
-        Renderer.Present(hMainWindow);
+        //Sleep until the next frame in which a star spawns, dies, brightens or expands instead of presenting the same image again
+        {
+            ProfileScope Scope = { Profiler, PhaseWorldTick };
+            FrameUpdateCount = WorldObject.GetUpdatesWithoutVisualChange(SecondsPerFrame, MaxSkippedFrames) + 1;
+        }
+
+        //CPU time of this thread, spinning for the deadline included, plus what its present thread spent meanwhile
+        //Time other processes or threads ran on this core in between isn't counted, neither is that of raster workers this thread waits for
+        uint64_t CostTicks = PlatformGetThreadCPUTicks() - BuildStartCPUTicks + (Presenter.GetTotalPresentCPUTicks() - StartPresentCPUTicks);
+        bQualityChanged = Governor.AddFrame(CostTicks, UpdateCount * FrameTimerObject.GetTargetTicksPerFrame());
+
+        Profiler->EndFrame();
+    }
+
+    WriteReports(*Profiler, Presenter.Profiler, Initialization, Resizes, Parks, Governor);
+
+    if (RasterPool)
+    {
+        delete RasterPool;
     }
 
     return 0;
@@ -66,9 +623,185 @@ DWORD RunnableThread::ThreadMain(LPVOID lpParameter)
     return Thread->Run();
 }
 
-static uint32_t ReadMaxStarCountFromRegistry()
+//Commands posted to every started thread, paused ones included
+static void PostToUpdateThreads(UpdateCommand Command)
+{
+    for (uint32_t Index = 0; Index < g_UpdateThreadCount; Index++)
+    {
+        g_UpdateThreads[Index].Post(Command);
+    }
+}
+
+//Tells every update thread to shut down and waits for them to finish and join, the only time the window thread waits on them
+static void StopUpdateThreads()
+{
+    PostToUpdateThreads({ CommandShutdown });
+
+    for (uint32_t Index = 0; Index < g_UpdateThreadCount; Index++)
+    {
+        RunnableThread& Thread = g_UpdateThreads[Index];
+        WaitForSingleObject(Thread.ThreadHandle, INFINITE);
+        CloseHandle(Thread.ThreadHandle);
+        PlatformDestroySemaphore(Thread.WakeSemaphore);
+        Thread.ThreadHandle = NULL;
+        Thread.PauseReasons = 0;
+    }
+
+    g_UpdateThreadCount = 0;
+}
+
+//Monitors covered by the window, the whole client area if there are none
+static void GetWindowMonitorLayout(HWND hWnd, MonitorLayout& OutLayout)
+{
+    //Preview window is a single small area inside the settings dialog, no point in looking at monitors
+    if (!bPreviewMode)
+    {
+        RECT WindowArea;
+        GetWindowRect(hWnd, &WindowArea);
+        EnumerateMonitors(WindowArea, OutLayout);
+    }
+
+    if (OutLayout.Count == 0)
+    {
+        RECT Rectangle;
+        GetClientRect(hWnd, &Rectangle);
+        OutLayout.Add(0, 0, Rectangle.right - Rectangle.left, Rectangle.bottom - Rectangle.top, Rectangle.right - Rectangle.left, Rectangle.bottom - Rectangle.top);
+    }
+}
+
+//Starts the update thread of the monitor at Index, cores are split evenly between the monitors there are at the time unless raster threads are set
+static void StartUpdateThread(const MonitorLayout& Layout, uint32_t Index, uint32_t StarBudget, uint32_t RenderScale, const SettingsSnapshot& Settings)
+{
+    const MonitorRect& Monitor = Layout.Monitors[Index];
+    RunnableThread& Thread = g_UpdateThreads[Index];
+
+    uint32_t RenderWidth, RenderHeight;
+    GetRenderSize(Monitor, RenderScale, RenderWidth, RenderHeight);
+
+    uint32_t ProcessorsPerMonitor = Settings.Get(SettingRasterThreads);
+    if (ProcessorsPerMonitor == 0)
+    {
+        ProcessorsPerMonitor = (WorkerPool::GetDefaultWorkerCount() + 1) / Layout.Count;
+    }
+    uint32_t RasterWorkerCount = (ProcessorsPerMonitor > 1) ? ProcessorsPerMonitor - 1 : 0;
+
+    //Star arrays start at the monitor's budget, the arena has room for them to grow to all stars of the settings, so budgets move between monitors without going to the OS
+    //Only the world and renderer are allocated from it, the thread's other memory doesn't depend on size and comes from the OS
+    uint32_t MaxStarCount = Settings.Get(SettingMaxStarCount);
+    size_t WorldSize = World::GetMemoryEstimate(StarBudget) + World::GetMemoryEstimate(MaxStarCount);
+    size_t ArenaSize = CPURenderer::GetMemoryEstimate(RenderWidth, RenderHeight, MaxStarCount) + WorldSize;
+    if (!Thread.Arena.IsInitialized())
+    {
+        //Resizes which outgrow the renderer's buffers rewind the arena and build the world and renderer again, so it only ever holds one size
+        //Reserved for the largest monitor at render scale 1, only ArenaSize is committed at start, the rest is address space until a resize needs it
+        uint32_t LargestWidth = 0;
+        uint32_t LargestHeight = 0;
+        for (uint32_t MonitorIndex = 0; MonitorIndex < Layout.Count; MonitorIndex++)
+        {
+            if ((uint64_t)Layout.Monitors[MonitorIndex].Width * Layout.Monitors[MonitorIndex].Height > (uint64_t)LargestWidth * LargestHeight)
+            {
+                LargestWidth = Layout.Monitors[MonitorIndex].Width;
+                LargestHeight = Layout.Monitors[MonitorIndex].Height;
+            }
+        }
+        size_t ReservedSize = CPURenderer::GetMemoryEstimate(LargestWidth, LargestHeight, MaxStarCount) + WorldSize;
+        ReservedSize = (ReservedSize > ArenaSize) ? ReservedSize : ArenaSize;
+
+        //Thread allocates from the OS if this fails
+        Thread.Arena.Initialize(ReservedSize, ArenaPrefault | (Settings.IsEnabled(SettingLargePages) ? ArenaLargePages : 0));
+    }
+
+    //Seeds come from the window thread's generator, update threads never touch it
+    Thread.Data = { RenderWidth, RenderHeight, Monitor, RenderScale, StarBudget, RasterWorkerCount, xoroshiro128plus(), Index, Settings, ArenaSize };
+    Thread.WakeSemaphore = PlatformCreateSemaphore(UpdateCommandQueueCapacity);
+    Thread.PauseReasons = 0;
+
+    //Run the logic on separate thread to avoid using window events for timing which may be inaccurate
+    Thread.ThreadHandle = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)(&RunnableThread::ThreadMain), &Thread, 0, NULL);
+
+    //Waiting in the queue for the thread's first frame
+    if (!g_Visibility.IsVisible())
+    {
+        Thread.Post({ CommandPause, PauseHidden });
+        Thread.PauseReasons = PauseHidden;
+    }
+}
+
+//Sets or clears Reason of the thread, posting a command only if that changes it
+static void SetUpdateThreadPaused(RunnableThread& Thread, UpdatePauseReason Reason, bool bPaused)
+{
+    if (bPaused == ((Thread.PauseReasons & Reason) != 0))
+    {
+        return;
+    }
+
+    //Posted while the reason is still set, so a paused thread is woken up for it
+    Thread.Post({ bPaused ? CommandPause : CommandResume, Reason });
+    Thread.PauseReasons = bPaused ? (Thread.PauseReasons | Reason) : (Thread.PauseReasons & ~Reason);
+}
+
+//Brings the update threads in line with the monitors the window covers now, star count is split between monitors by area
+//Monitors are matched to threads by enumeration order, threads are started for new monitors, the ones past the monitor count are paused and none is stopped
+//Render scale setting is resolved per monitor, see GetRenderScale
+static void UpdateThreadLayout(HWND hWnd, const SettingsSnapshot& Settings)
+{
+    MonitorLayout Layout;
+    GetWindowMonitorLayout(hWnd, Layout);
+
+    for (uint32_t Index = 0; Index < Layout.Count; Index++)
+    {
+        RunnableThread& Thread = g_UpdateThreads[Index];
+        uint32_t StarBudget = Layout.GetStarBudget(Index, Settings.Get(SettingMaxStarCount));
+        uint32_t RenderScale = GetRenderScale(Layout.Monitors[Index], Settings.Get(SettingRenderScale));
+
+        if (!Thread.ThreadHandle)
+        {
+            StartUpdateThread(Layout, Index, StarBudget, RenderScale, Settings);
+            continue;
+        }
+
+        //Posted even for an unchanged placement, the background was erased and has to be presented again
+        Thread.Post({ CommandResize, RenderScale, Layout.Monitors[Index] });
+        Thread.Post({ CommandSetStarBudget, StarBudget });
+        SetUpdateThreadPaused(Thread, PauseMonitorGone, false);
+    }
+
+    for (uint32_t Index = Layout.Count; Index < g_UpdateThreadCount; Index++)
+    {
+        SetUpdateThreadPaused(g_UpdateThreads[Index], PauseMonitorGone, true);
+    }
+
+    g_UpdateThreadCount = (Layout.Count > g_UpdateThreadCount) ? Layout.Count : g_UpdateThreadCount;
+}
+
+//Pauses or resumes every thread if the event changes whether the window can be seen
+static void HandleVisibilityEvent(VisibilityEvent Event)
+{
+    if (!g_Visibility.HandleEvent(Event))
+    {
+        return;
+    }
+
+    for (uint32_t Index = 0; Index < g_UpdateThreadCount; Index++)
+    {
+        SetUpdateThreadPaused(g_UpdateThreads[Index], PauseHidden, !g_Visibility.IsVisible());
+    }
+}
+
+//Windows covered by others still get drawn to with desktop composition, only a cloaked window is known to be unseen
+//Hiding, minimizing and display power come as window messages
+static void CALLBACK CloakEventProc(HWINEVENTHOOK Hook, DWORD Event, HWND hWnd, LONG ObjectId, LONG ChildId, DWORD EventThread, DWORD EventTime)
+{
+    if (hWnd == g_ScreensaverWindow && ObjectId == OBJID_WINDOW && ChildId == CHILDID_SELF)
+    {
+        HandleVisibilityEvent(Event == EVENT_OBJECT_CLOAKED ? VisibilityWindowOccluded : VisibilityWindowExposed);
+    }
+}
+
+//Every setting of the schema from one key, values which are missing, not DWORDs or out of range keep their default
+static SettingsSnapshot ReadSettingsFromRegistry()
 {
-    uint32_t Result = World::DefaultStarCount;
+    SettingsSnapshot Settings = GetDefaultSettings();
 
     HKEY Key;
     DWORD Disposition;
@@ -77,21 +810,28 @@ static uint32_t ReadMaxStarCountFromRegistry()
     LSTATUS RegistryResult = RegCreateKeyExA(HKEY_CURRENT_USER, SettingsRegistryPath, 0, NULL, REG_OPTION_NON_VOLATILE, KEY_ALL_ACCESS, NULL, &Key, &Disposition);
     if (RegistryResult == ERROR_SUCCESS)
     {
-        DWORD OutType;
-        DWORD SizeOfBuffer = sizeof(Result);
-        //Get the value MaxStarCountSettingLabel from key, filtered to DWORD type
-        RegGetValueA(Key, NULL, MaxStarCountSettingLabel, RRF_RT_REG_DWORD, &OutType, &Result, &SizeOfBuffer);
-    }
+        for (uint32_t Id = 0; Id < SettingCount; Id++)
+        {
+            DWORD Value;
+            DWORD OutType;
+            DWORD SizeOfBuffer = sizeof(Value);
+            //Get the value named after the setting from key, filtered to DWORD type
+            if (RegGetValueA(Key, NULL, GetSettingDefinition((SettingId)Id).Name, RRF_RT_REG_DWORD, &OutType, &Value, &SizeOfBuffer) == ERROR_SUCCESS)
+            {
+                //Value changed in registry by user or similar is ignored if it falls outside of the range
+                Settings.Set((SettingId)Id, Value);
+            }
+        }
 
-    //If we fall outside of range just use the default, value changed in registry by user or similar
-    if (Result > World::MaxStarCount || Result < World::MinStarCount)
-    {
-        Result = World::DefaultStarCount;
+        RegCloseKey(Key);
     }
 
-    return Result;
+    return Settings;
 }
 
+//Clicks beside the star count scroll bar's thumb move it by this many, its range is too wide to step through one by one
+static const uint32_t StarCountPageStep = 500;
+
 //Configuration dialog handling
 BOOL WINAPI ScreenSaverConfigureDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
 {
@@ -105,7 +845,7 @@ BOOL WINAPI ScreenSaverConfigureDialog(HWND hDlg, UINT message, WPARAM wParam, L
     {
         case WM_INITDIALOG:
         {
-            MaxStarCount = ReadMaxStarCountFromRegistry();
+            MaxStarCount = ReadSettingsFromRegistry().Get(SettingMaxStarCount);
 
             // Initialize the scroll bar control.
             hCount = GetDlgItem(hDlg, ID_COUNT);
@@ -123,18 +863,26 @@ BOOL WINAPI ScreenSaverConfigureDialog(HWND hDlg, UINT message, WPARAM wParam, L
             // Process scroll bar input
             switch (LOWORD(wParam))
             {
-                case SB_PAGEUP:
                 case SB_LINEUP:
                 {
                     --MaxStarCount;
                 } break;
 
-                case SB_PAGEDOWN:
                 case SB_LINEDOWN:
                 {
                     ++MaxStarCount;
                 } break;
 
+                case SB_PAGEUP:
+                {
+                    MaxStarCount = (MaxStarCount > StarCountPageStep) ? MaxStarCount - StarCountPageStep : 0;
+                } break;
+
+                case SB_PAGEDOWN:
+                {
+                    MaxStarCount += StarCountPageStep;
+                } break;
+
                 case SB_THUMBPOSITION: 
                 {
                     MaxStarCount = HIWORD(wParam);
@@ -183,8 +931,11 @@ BOOL WINAPI ScreenSaverConfigureDialog(HWND hDlg, UINT message, WPARAM wParam, L
                     LSTATUS Result = RegCreateKeyExA(HKEY_CURRENT_USER, SettingsRegistryPath, 0, NULL, REG_OPTION_NON_VOLATILE, KEY_ALL_ACCESS, NULL, &Key, &Disposition);
                     if (Result == ERROR_SUCCESS)
                     {
-                        //Save set value as DWORD in the registry key under MaxStarCountSettingLabel value
-                        RegSetKeyValueA(Key, NULL, MaxStarCountSettingLabel, REG_DWORD, &MaxStarCount, sizeof(MaxStarCount));
+                        //Save set value as DWORD in the registry key under the setting's name
+                        RegSetKeyValueA(Key, NULL, GetSettingDefinition(SettingMaxStarCount).Name, REG_DWORD, &MaxStarCount, sizeof(MaxStarCount));
+
+                        //Screen savers running already take the new star count over without restarting
+                        PostMessage(HWND_BROADCAST, RegisterWindowMessageA(SettingsChangedMessageName), 0, 0);
                     }
                 }
                 case ID_CANCEL:
@@ -266,7 +1017,26 @@ LRESULT WINAPI DefScreenSaverProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 LRESULT WINAPI ScreenSaverProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
     LRESULT Result = 0;
-    static uint32_t MaxCount = World::DefaultStarCount;
+    //Read on WM_CREATE, before any thread is started
+    static SettingsSnapshot Settings;
+
+    //Registered messages don't have a fixed value, so they can't be handled in the switch
+    if (ProfileReportMessage != 0 && message == ProfileReportMessage)
+    {
+        PostToUpdateThreads({ CommandWriteReports });
+        return 0;
+    }
+
+    //Budgets are split again for the new star count and render scales picked again, large pages stay as they were when the arenas were reserved
+    if (SettingsChangedMessage != 0 && message == SettingsChangedMessage)
+    {
+        Settings = ReadSettingsFromRegistry();
+        UpdateCommand Command = { CommandApplySettings };
+        Command.Settings = Settings;
+        PostToUpdateThreads(Command);
+        UpdateThreadLayout(hWnd, Settings);
+        return 0;
+    }
 
     switch (message)
     {
@@ -279,40 +1049,75 @@ LRESULT WINAPI ScreenSaverProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lP
             GetCursorPos(&InitialMousePosition);
 
             SeedRandom(GetTickCount());
-            MaxCount = ReadMaxStarCountFromRegistry();
+            Settings = ReadSettingsFromRegistry();
+
+            //Display power comes as WM_POWERBROADCAST, right away with the current state and then on every change
+            g_DisplayStateNotification = RegisterPowerSettingNotification(hWnd, &DisplayStateGuid, DEVICE_NOTIFY_WINDOW_HANDLE);
+            //Cloaking is reported to this thread's message loop as it happens, nothing has to be polled
+            g_ScreensaverWindow = hWnd;
+            g_CloakHook = SetWinEventHook(EVENT_OBJECT_CLOAKED, EVENT_OBJECT_UNCLOAKED, NULL, CloakEventProc, GetCurrentProcessId(), GetCurrentThreadId(), WINEVENT_OUTOFCONTEXT);
         } break;
 
-        //We can probably receive WM_ERASEBKGND if one of the monitors gets turned off, or window gets resized for whatever reason
-        //We treat it as a full reset, will result in world and renderer being reinitialized
-        case WM_ERASEBKGND:
+        //Visibility messages go on to DefWindowProc after updating visibility, it does its own work for them
+        case WM_SHOWWINDOW:
+        {
+            HandleVisibilityEvent(wParam ? VisibilityWindowShown : VisibilityWindowHidden);
+            Result = DefWindowProc(hWnd, message, wParam, lParam);
+        } break;
+
+        case WM_SIZE:
         {
-            //Get window size
-            RECT Rectangle;
-            GetClientRect(hWnd, &Rectangle);
-            uint32_t Width = Rectangle.right - Rectangle.left;
-            uint32_t Height = Rectangle.bottom - Rectangle.top;
+            if (wParam == SIZE_MINIMIZED)
+            {
+                HandleVisibilityEvent(VisibilityWindowHidden);
+            }
+            else if (wParam == SIZE_RESTORED || wParam == SIZE_MAXIMIZED)
+            {
+                HandleVisibilityEvent(VisibilityWindowShown);
+            }
+            Result = DefWindowProc(hWnd, message, wParam, lParam);
+        } break;
 
-            //If we were running stop running and wait for world/render thread to finish and join
-            if (g_Running)
+        //Only the console display state is registered for, dimmed displays still show the sky
+        case WM_POWERBROADCAST:
+        {
+            if (wParam == PBT_POWERSETTINGCHANGE)
             {
-                g_Running = false;
-                WaitForSingleObject(g_MainUpdateThread.ThreadHandle, INFINITE);
+                const POWERBROADCAST_SETTING* Setting = (const POWERBROADCAST_SETTING*)lParam;
+                if (Setting->DataLength >= sizeof(DWORD))
+                {
+                    HandleVisibilityEvent(*(const DWORD*)Setting->Data == 0 ? VisibilityDisplayOff : VisibilityDisplayOn);
+                }
             }
 
-            g_MainUpdateThread.Data = { Width, Height, MaxCount };
+            Result = DefWindowProc(hWnd, message, wParam, lParam);
+        } break;
 
-            g_Running = true;
-            //Run the logic on separate thread to avoid using window events for timing which may be inaccurate
-            g_MainUpdateThread.ThreadHandle = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)(&RunnableThread::ThreadMain), &g_MainUpdateThread, 0, NULL);
+        //We can probably receive WM_ERASEBKGND if one of the monitors gets turned off, or window gets resized for whatever reason
+        //Monitor layout is read again, so monitors being turned off or rearranged are picked up
+        case WM_ERASEBKGND:
+        {
+            //Threads keep running and resize in place, stars stay, monitors which went away pause their thread until they are back
+            UpdateThreadLayout(hWnd, Settings);
         } break;
 
         case WM_DESTROY:
         {
             PostQuitMessage(0);
 
-            //Stop running and wait for world/render thread to finish and join
-            g_Running = false;
-            WaitForSingleObject(g_MainUpdateThread.ThreadHandle, INFINITE);
+            if (g_CloakHook)
+            {
+                UnhookWinEvent(g_CloakHook);
+                g_CloakHook = NULL;
+            }
+            if (g_DisplayStateNotification)
+            {
+                UnregisterPowerSettingNotification(g_DisplayStateNotification);
+                g_DisplayStateNotification = NULL;
+            }
+
+            //Stop running and wait for world/render threads to finish and join
+            StopUpdateThreads();
         } break;
 
         case WM_SYSCOMMAND:
@@ -342,10 +1147,28 @@ LRESULT WINAPI ScreenSaverProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lP
     return Result;
 }
 
+typedef BOOL (WINAPI* SetProcessDpiAwarenessContextFunction)(HANDLE Context);
+
+//Without it Windows scales the window up from 96 DPI on its own and reports monitors at that size, the render scale does this instead
+//Looked up at run time, it exists since Windows 10 1703 and older systems keep the scaling done by Windows
+static void EnablePerMonitorDpiAwareness()
+{
+    HMODULE User32 = GetModuleHandleA("user32.dll");
+    SetProcessDpiAwarenessContextFunction SetProcessDpiAwarenessContext = User32 ? (SetProcessDpiAwarenessContextFunction)GetProcAddress(User32, "SetProcessDpiAwarenessContext") : nullptr;
+    if (SetProcessDpiAwarenessContext)
+    {
+        //DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2
+        SetProcessDpiAwarenessContext((HANDLE)-4);
+    }
+}
+
 static WPARAM LaunchScreenSaver(HWND hParent)
 {
     WPARAM Result = 0;
 
+    //Before any window is created, the monitor rectangles enumerated later are then in physical pixels
+    EnablePerMonitorDpiAwareness();
+
     char WindowClassName[] = "WindowsScreenSaverClass";
 
     WNDCLASS WindowClass;
@@ -360,6 +1183,9 @@ static WPARAM LaunchScreenSaver(HWND hParent)
     WindowClass.cbWndExtra = 0;
     WindowClass.cbClsExtra = 0;
 
+    ProfileReportMessage = RegisterWindowMessageA(ProfileReportMessageName);
+    SettingsChangedMessage = RegisterWindowMessageA(SettingsChangedMessageName);
+
     if (RegisterClass(&WindowClass))
     {
         UINT WindowStyle;
@@ -479,6 +1305,17 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR CmdLine, int nCmd
                 return 0;
             }
 
+            //Benchmark of memory kernels, written to the working directory as JSON
+            case 'B':
+            case 'b':
+            {
+                ReportWriter Report;
+                RunMemoryBenchmark(Report);
+                Report.WriteToFile(BenchmarkReportPath);
+
+                return 0;
+            }
+
             //Config
             case 'C':
             case 'c':
@@ -0,0 +1,165 @@
+#include "Settings.h"
+
+#include "World.h"
+#include "StarAtlas.h"
+#include "MonitorLayout.h"
+#include "WorkerPool.h"
+
+static const uint32_t DefaultFrameRate = 15;
+static const uint32_t MinFrameRate = 1;
+static const uint32_t MaxFrameRate = 240;
+//Lifetimes shorter than this would hardly be seen at the default frame rate
+static const uint32_t MinLifetimeMilliseconds = 100;
+//Whole core
+static const uint32_t MaxCPUBudget = 10000;
+
+//In SettingId order
+static const SettingDefinition SettingDefinitions[SettingCount] =
+{
+    { "Max star count", SettingTypeInteger, World::DefaultStarCount, World::MinStarCount, World::MaxStarCount },
+    { "Frame rate", SettingTypeInteger, DefaultFrameRate, MinFrameRate, MaxFrameRate },
+    { "Max star size", SettingTypeInteger, DefaultStarSizeMax, 1, MaxStarSizeMax },
+    { "Min star lifetime", SettingTypeInteger, World::DefaultMinLifetimeMilliseconds, MinLifetimeMilliseconds, World::MaxLifetimeSecondsLimit * 1000 },
+    { "Max star lifetime", SettingTypeInteger, World::DefaultMaxLifetimeSeconds, 1, World::MaxLifetimeSecondsLimit },
+    { "Render scale", SettingTypeInteger, AutomaticRenderScale, AutomaticRenderScale, MaxRenderScale },
+    { "Raster threads", SettingTypeInteger, 0, 0, WorkerPool::MaxWorkers + 1 },
+    { "Drift speed", SettingTypeInteger, 0, 0, (uint32_t)World::MaxDriftSpeed },
+    { "Large pages", SettingTypeBoolean, 0, 0, 1 },
+    { "CPU budget", SettingTypeInteger, 0, 0, MaxCPUBudget },
+};
+
+const SettingDefinition& GetSettingDefinition(SettingId Id)
+{
+    return SettingDefinitions[Id];
+}
+
+SettingId FindSetting(const char* Name, uint32_t NameLength)
+{
+    for (uint32_t Id = 0; Id < SettingCount; Id++)
+    {
+        const char* Candidate = SettingDefinitions[Id].Name;
+        uint32_t Length = 0;
+        while (Length < NameLength && Candidate[Length] == Name[Length])
+        {
+            Length++;
+        }
+
+        if (Length == NameLength && Candidate[Length] == 0)
+        {
+            return (SettingId)Id;
+        }
+    }
+
+    return SettingCount;
+}
+
+bool SettingsSnapshot::Set(SettingId Id, uint32_t Value)
+{
+    const SettingDefinition& Definition = SettingDefinitions[Id];
+    if (Value < Definition.MinValue || Value > Definition.MaxValue)
+    {
+        return false;
+    }
+
+    Values[Id] = Value;
+    return true;
+}
+
+SettingsSnapshot GetDefaultSettings()
+{
+    SettingsSnapshot Settings;
+    for (uint32_t Id = 0; Id < SettingCount; Id++)
+    {
+        Settings.Set((SettingId)Id, SettingDefinitions[Id].DefaultValue);
+    }
+
+    return Settings;
+}
+
+static bool IsSpace(char Character)
+{
+    return Character == ' ' || Character == '\t' || Character == '\r';
+}
+
+//Advances Cursor past Word if the text there starts with it
+static bool ParseWord(const char*& Cursor, const char* Word)
+{
+    const char* Text = Cursor;
+    while (*Word)
+    {
+        if (*Text++ != *Word++)
+        {
+            return false;
+        }
+    }
+
+    Cursor = Text;
+    return true;
+}
+
+bool ParseSettingLine(const char* Line, SettingsSnapshot& Settings)
+{
+    while (IsSpace(*Line))
+    {
+        Line++;
+    }
+
+    const char* Separator = Line;
+    while (*Separator && *Separator != '=')
+    {
+        Separator++;
+    }
+    if (*Separator != '=')
+    {
+        return false;
+    }
+
+    uint32_t NameLength = (uint32_t)(Separator - Line);
+    while (NameLength > 0 && IsSpace(Line[NameLength - 1]))
+    {
+        NameLength--;
+    }
+
+    SettingId Id = FindSetting(Line, NameLength);
+    if (Id == SettingCount)
+    {
+        return false;
+    }
+
+    const char* Cursor = Separator + 1;
+    while (IsSpace(*Cursor))
+    {
+        Cursor++;
+    }
+
+    //Values past any range saturate, they only have to fail the range check
+    uint32_t Value = 0;
+    if (SettingDefinitions[Id].Type == SettingTypeBoolean && ParseWord(Cursor, "false"))
+    {
+        Value = 0;
+    }
+    else if (SettingDefinitions[Id].Type == SettingTypeBoolean && ParseWord(Cursor, "true"))
+    {
+        Value = 1;
+    }
+    else
+    {
+        if (*Cursor < '0' || *Cursor > '9')
+        {
+            return false;
+        }
+
+        while (*Cursor >= '0' && *Cursor <= '9')
+        {
+            Value = (Value < 0x10000000) ? Value * 10 + (uint32_t)(*Cursor - '0') : 0xFFFFFFFF;
+            Cursor++;
+        }
+    }
+
+    while (IsSpace(*Cursor))
+    {
+        Cursor++;
+    }
+
+    return *Cursor == 0 && Settings.Set(Id, Value);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Globals.h"
+
+//Everything the user can set, stored in the registry by the screen saver and in a NAME = VALUE text file by the headless benchmark
+//Names are the registry values and file keys, existing registry values keep their meaning
+enum SettingId : uint32_t
+{
+    //Total star count, split between monitors by area
+    SettingMaxStarCount,
+    SettingFrameRate,
+    //Largest initial star size at full resolution, scaled down with the render scale
+    SettingStarSizeMax,
+    //Shortest star lifetime in milliseconds, capped at the longest
+    SettingMinLifetime,
+    //Lifetimes are drawn up to this many seconds
+    SettingMaxLifetime,
+    //1 to MaxRenderScale render at that fraction of the monitor's resolution along each axis, 0 picks it from the monitor's DPI
+    SettingRenderScale,
+    //Threads rasterizing a monitor's stars, its update thread included, 0 splits the processors evenly between monitors
+    SettingRasterThreads,
+    //Monitor pixels per second the sky pans left by, 0 keeps it still
+    SettingDriftSpeed,
+    //Large pages need the "Lock pages in memory" user right and stay resident while running
+    SettingLargePages,
+    //Hundredths of a percent of one core each update thread may use, quality is lowered to stay within it, 0 never lowers it
+    SettingCPUBudget,
+    SettingCount,
+};
+
+enum SettingType : uint32_t
+{
+    SettingTypeInteger,
+    //Stored as 0 or 1, files also take false and true
+    SettingTypeBoolean,
+};
+
+struct SettingDefinition
+{
+    const char* Name;
+    SettingType Type;
+    uint32_t DefaultValue;
+    uint32_t MinValue;
+    uint32_t MaxValue;
+};
+
+const SettingDefinition& GetSettingDefinition(SettingId Id);
+//SettingCount if no setting has this name, names are compared exactly
+SettingId FindSetting(const char* Name, uint32_t NameLength);
+
+//Value of every setting, always within its definition's range
+//Read once from where settings are stored and handed out by copy, so threads keep reading theirs without locks while a newer one is loaded
+//Has no constructor so it can live in globals of the CRT free build, start from GetDefaultSettings
+class SettingsSnapshot
+{
+public:
+    uint32_t Get(SettingId Id) const { return Values[Id]; }
+    bool IsEnabled(SettingId Id) const { return Values[Id] != 0; }
+
+    //Returns false and keeps the current value if Value is outside of the setting's range
+    bool Set(SettingId Id, uint32_t Value);
+
+private:
+    uint32_t Values[SettingCount];
+};
+
+SettingsSnapshot GetDefaultSettings();
+
+//Applies a NAME = VALUE line, spaces around both are ignored
+//Returns false for unknown names and values which aren't numbers in range, or booleans spelled as numbers, false or true
+bool ParseSettingLine(const char* Line, SettingsSnapshot& Settings);
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "CPURenderer.h"
+
+//SizeMax the star atlas is generated for, stars grown from bigger sizes are drawn by the reference rasterizer
+static const uint32_t DefaultStarSizeMax = 5;
+//Largest SizeMax a setting can ask for, stars that big are all drawn per pixel
+static const uint32_t MaxStarSizeMax = 16;
+static const uint8_t StarExpandStageCount = 5;
+static const uint32_t StarShapeCount = 4;
+
+//Size of a star after advancing to ExpandStage, shared by World and the atlas generator
+//Growth factors of 1.5, 2 and 1.2 as integer fractions, rounded down like truncating the float product
+constexpr uint32_t GetExpandedStarSize(uint32_t Size, uint8_t ExpandStage)
+{
+    switch (ExpandStage)
+    {
+        case 1:
+        case 2:
+        {
+            //In case Size was 1 we need to increment the size instead of multiplying
+            return (Size == 1) ? 2 : Size * 3 / 2;
+        }
+
+        case 3:
+        {
+            return Size * 2;
+        }
+
+        case 5:
+        {
+            return Size * 6 / 5;
+        }
+    }
+
+    return Size;
+}
+
+constexpr StarShape GetExpandedStarShape(StarShape Shape, uint8_t ExpandStage)
+{
+    switch (ExpandStage)
+    {
+        case 1:
+        case 2:
+        {
+            return StarShape::Circle;
+        }
+
+        case 3:
+        {
+            return StarShape::Diamond;
+        }
+
+        case 4:
+        {
+            return StarShape::Square;
+        }
+
+        case 5:
+        {
+            return StarShape::Twinkle;
+        }
+    }
+
+    return Shape;
+}
+
+//Per pixel test of the reference rasterizer and the atlas generator, offsets are relative to star center
+//Half, quarter and eighth of Size are compared in eighths of a pixel, so every test is exact in integers
+constexpr bool IsStarPixelSet(StarShape Shape, uint32_t Size, int32_t XIndex, int32_t YIndex)
+{
+    int32_t HalfSize8 = (int32_t)Size * 4;
+    int32_t QuaterSize8 = (int32_t)Size * 2;
+    int32_t EigthSize8 = (int32_t)Size;
+
+    int32_t YIndexAbs8 = ((YIndex > 0) ? YIndex : -1 * YIndex) * 8;
+    int32_t XIndexAbs8 = ((XIndex > 0) ? XIndex : -1 * XIndex) * 8;
+
+    switch (Shape)
+    {
+        case StarShape::Circle:
+        {
+            //Squared distance against squared half size, both times 4
+            return (YIndex * YIndex + XIndex * XIndex) * 4 <= (int32_t)(Size * Size);
+        }
+
+        case StarShape::Diamond:
+        {
+            return XIndexAbs8 + YIndexAbs8 < HalfSize8;
+        }
+
+        //Diamond - center + diagonals
+        case StarShape::Twinkle:
+        {
+            int32_t DiagonalDistance8 = (XIndexAbs8 > YIndexAbs8) ? XIndexAbs8 - YIndexAbs8 : YIndexAbs8 - XIndexAbs8;
+            bool bIsDiagonal = (EigthSize8 >= 2 * 8) ? (DiagonalDistance8 < EigthSize8) : (DiagonalDistance8 == 0);
+
+            bool bIsOutsideOfCenter = XIndexAbs8 + YIndexAbs8 > QuaterSize8;
+
+            return bIsOutsideOfCenter && ((XIndexAbs8 + YIndexAbs8 < HalfSize8) || bIsDiagonal);
+        }
+
+        default:
+        {
+            return true;
+        }
+    }
+}
+
+//Star covers offsets [GetStarMinOffset, GetStarMaxOffset) around its center on both axes
+constexpr int32_t GetStarMinOffset(uint32_t Size)
+{
+    return -(int32_t)(Size / 2);
+}
+
+constexpr int32_t GetStarMaxOffset(uint32_t Size)
+{
+    return (int32_t)((Size + 1) / 2);
+}
+
+//Can a star reach given shape and size when spawned with a size below DefaultStarSizeMax
+//Slots keep ExpandStage between stars, so growth can start from any stage
+constexpr bool IsStarSpriteReachable(StarShape Shape, uint32_t Size)
+{
+    for (uint32_t InitialSize = 1; InitialSize < DefaultStarSizeMax; InitialSize++)
+    {
+        for (uint8_t FirstStage = 0; FirstStage <= StarExpandStageCount; FirstStage++)
+        {
+            uint32_t CurrentSize = InitialSize;
+            StarShape CurrentShape = StarShape::Square;
+
+            if (CurrentShape == Shape && CurrentSize == Size)
+            {
+                return true;
+            }
+
+            for (uint8_t ExpandStage = FirstStage + 1; ExpandStage <= StarExpandStageCount; ExpandStage++)
+            {
+                CurrentSize = GetExpandedStarSize(CurrentSize, ExpandStage);
+                CurrentShape = GetExpandedStarShape(CurrentShape, ExpandStage);
+
+                if (CurrentShape == Shape && CurrentSize == Size)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+constexpr uint32_t GetAtlasMaxStarSize()
+{
+    uint32_t Result = 0;
+
+    for (uint32_t InitialSize = 1; InitialSize < DefaultStarSizeMax; InitialSize++)
+    {
+        uint32_t CurrentSize = InitialSize;
+        for (uint8_t ExpandStage = 1; ExpandStage <= StarExpandStageCount; ExpandStage++)
+        {
+            CurrentSize = GetExpandedStarSize(CurrentSize, ExpandStage);
+        }
+
+        Result = (CurrentSize > Result) ? CurrentSize : Result;
+    }
+
+    return Result;
+}
+
+static constexpr uint32_t AtlasMaxStarSize = GetAtlasMaxStarSize();
+
+//Horizontal run of set pixels, offsets are relative to star center
+struct StarSpan
+{
+    int8_t YOffset;
+    int8_t XOffset;
+    uint8_t Length;
+};
+
+struct StarSprite
+{
+    uint16_t FirstSpan;
+    uint16_t SpanCount;
+    bool bIsValid;
+};
+
+//Calls SpanCallback for every run of set pixels of a star in row order
+template<typename CallbackType>
+constexpr void ForEachStarSpan(StarShape Shape, uint32_t Size, CallbackType& SpanCallback)
+{
+    int32_t MinOffset = GetStarMinOffset(Size);
+    int32_t MaxOffset = GetStarMaxOffset(Size);
+
+    for (int32_t YIndex = MinOffset; YIndex < MaxOffset; YIndex++)
+    {
+        int32_t SpanStart = MinOffset;
+        bool bInSpan = false;
+
+        for (int32_t XIndex = MinOffset; XIndex <= MaxOffset; XIndex++)
+        {
+            bool bIsSet = XIndex < MaxOffset && IsStarPixelSet(Shape, Size, XIndex, YIndex);
+            if (bIsSet && !bInSpan)
+            {
+                SpanStart = XIndex;
+            }
+            else if (!bIsSet && bInSpan)
+            {
+                SpanCallback(YIndex, SpanStart, XIndex - SpanStart);
+            }
+
+            bInSpan = bIsSet;
+        }
+    }
+}
+
+struct StarSpanCounter
+{
+    uint32_t Count = 0;
+
+    constexpr void operator()(int32_t, int32_t, int32_t)
+    {
+        Count++;
+    }
+};
+
+constexpr uint32_t CountAtlasSpans()
+{
+    uint32_t Result = 0;
+
+    for (uint32_t Shape = 0; Shape < StarShapeCount; Shape++)
+    {
+        for (uint32_t Size = 1; Size <= AtlasMaxStarSize; Size++)
+        {
+            if (IsStarSpriteReachable((StarShape)Shape, Size))
+            {
+                StarSpanCounter Counter;
+                ForEachStarSpan((StarShape)Shape, Size, Counter);
+                Result += Counter.Count;
+            }
+        }
+    }
+
+    return Result;
+}
+
+static constexpr uint32_t AtlasSpanCount = CountAtlasSpans();
+
+//Precomputed spans of every star shape and size World can produce, indexed by [Shape][Size]
+struct StarAtlas
+{
+    StarSprite Sprites[StarShapeCount][AtlasMaxStarSize + 1];
+    StarSpan Spans[AtlasSpanCount];
+};
+
+struct StarSpanWriter
+{
+    StarAtlas& Atlas;
+    uint32_t Count;
+
+    constexpr void operator()(int32_t YOffset, int32_t XOffset, int32_t Length)
+    {
+        Atlas.Spans[Count].YOffset = (int8_t)YOffset;
+        Atlas.Spans[Count].XOffset = (int8_t)XOffset;
+        Atlas.Spans[Count].Length = (uint8_t)Length;
+        Count++;
+    }
+};
+
+constexpr StarAtlas BuildStarAtlas()
+{
+    StarAtlas Atlas = {};
+    StarSpanWriter Writer = { Atlas, 0 };
+
+    for (uint32_t Shape = 0; Shape < StarShapeCount; Shape++)
+    {
+        for (uint32_t Size = 1; Size <= AtlasMaxStarSize; Size++)
+        {
+            if (IsStarSpriteReachable((StarShape)Shape, Size))
+            {
+                StarSprite& Sprite = Atlas.Sprites[Shape][Size];
+                Sprite.FirstSpan = (uint16_t)Writer.Count;
+                ForEachStarSpan((StarShape)Shape, Size, Writer);
+                Sprite.SpanCount = (uint16_t)(Writer.Count - Sprite.FirstSpan);
+                Sprite.bIsValid = true;
+            }
+        }
+    }
+
+    return Atlas;
+}
+
+//Renders every atlas sprite next to the reference rasterizer, including positions clipped by the buffer edges
+//Returns false on first pixel mismatch
+bool ValidateStarAtlas();
\ No newline at end of file
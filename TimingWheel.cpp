@@ -0,0 +1,150 @@
+#include "TimingWheel.h"
+
+TimingWheel::TimingWheel(uint32_t InCapacity, uint32_t StartTick)
+{
+    Capacity = InCapacity;
+    CurrentTick = StartTick;
+
+    Links = new uint32_t[Capacity];
+    DueTicks = new uint32_t[Capacity];
+
+    uint32_t SlotCount = Level0SlotCount + Level1SlotCount + Level2SlotCount;
+    Level0 = new uint32_t[SlotCount];
+    Level1 = Level0 + Level0SlotCount;
+    Level2 = Level1 + Level1SlotCount;
+    for (uint32_t Slot = 0; Slot < SlotCount; Slot++)
+    {
+        Level0[Slot] = InvalidItem;
+    }
+}
+
+TimingWheel::~TimingWheel()
+{
+    delete[] Links;
+    delete[] DueTicks;
+    delete[] Level0;
+}
+
+void TimingWheel::Grow(uint32_t NewCapacity)
+{
+    uint32_t* NewLinks = new uint32_t[NewCapacity];
+    uint32_t* NewDueTicks = new uint32_t[NewCapacity];
+    memcpy(NewLinks, Links, Capacity * sizeof(uint32_t));
+    memcpy(NewDueTicks, DueTicks, Capacity * sizeof(uint32_t));
+
+    delete[] Links;
+    delete[] DueTicks;
+    Links = NewLinks;
+    DueTicks = NewDueTicks;
+    Capacity = NewCapacity;
+}
+
+void TimingWheel::Schedule(uint32_t Item, uint32_t DueTick)
+{
+    DueTicks[Item] = DueTick;
+    Insert(Item, DueTick);
+}
+
+void TimingWheel::Insert(uint32_t Item, uint32_t DueTick)
+{
+    uint32_t Distance = DueTick - CurrentTick;
+    if (Distance > MaxDistance)
+    {
+        DueTick = CurrentTick + MaxDistance;
+        Distance = MaxDistance;
+    }
+
+    uint32_t* SlotHead;
+    if (Distance < Level0SlotCount)
+    {
+        SlotHead = &Level0[DueTick & (Level0SlotCount - 1)];
+    }
+    else if (Distance < (1u << Level2Shift))
+    {
+        SlotHead = &Level1[(DueTick >> Level1Shift) & (Level1SlotCount - 1)];
+    }
+    else
+    {
+        SlotHead = &Level2[(DueTick >> Level2Shift) & (Level2SlotCount - 1)];
+    }
+
+    Links[Item] = *SlotHead;
+    *SlotHead = Item;
+}
+
+void TimingWheel::Cascade(uint32_t& SlotHead)
+{
+    uint32_t Item = SlotHead;
+    SlotHead = InvalidItem;
+
+    while (Item != InvalidItem)
+    {
+        uint32_t Next = Links[Item];
+        Insert(Item, DueTicks[Item]);
+        Item = Next;
+    }
+}
+
+uint32_t TimingWheel::Step()
+{
+    CurrentTick++;
+
+    //Coarser slots starting at this tick are spread to finer ones before the finest slot is taken
+    if ((CurrentTick & (Level0SlotCount - 1)) == 0)
+    {
+        if ((CurrentTick & ((1u << Level2Shift) - 1)) == 0)
+        {
+            Cascade(Level2[(CurrentTick >> Level2Shift) & (Level2SlotCount - 1)]);
+        }
+        Cascade(Level1[(CurrentTick >> Level1Shift) & (Level1SlotCount - 1)]);
+    }
+
+    uint32_t& SlotHead = Level0[CurrentTick & (Level0SlotCount - 1)];
+    uint32_t Result = SlotHead;
+    SlotHead = InvalidItem;
+
+    return Result;
+}
+
+uint32_t TimingWheel::GetEarliestDueTick(uint32_t SlotHead) const
+{
+    uint32_t Earliest = CurrentTick + MaxDistance;
+    for (uint32_t Item = SlotHead; Item != InvalidItem; Item = Links[Item])
+    {
+        if ((int32_t)(DueTicks[Item] - Earliest) < 0)
+        {
+            Earliest = DueTicks[Item];
+        }
+    }
+
+    return Earliest;
+}
+
+uint32_t TimingWheel::GetTicksUntilNextDue(uint32_t Limit) const
+{
+    //Walks ticks the way Step would, a coarse slot holds items due anywhere within its range so its earliest one only bounds the search
+    uint32_t Result = Limit + 1;
+    for (uint32_t Distance = 1; Distance < Result; Distance++)
+    {
+        uint32_t Tick = CurrentTick + Distance;
+
+        if ((Tick & (Level0SlotCount - 1)) == 0)
+        {
+            if ((Tick & ((1u << Level2Shift) - 1)) == 0)
+            {
+                uint32_t Level2Distance = GetEarliestDueTick(Level2[(Tick >> Level2Shift) & (Level2SlotCount - 1)]) - CurrentTick;
+                Result = (Level2Distance < Result) ? Level2Distance : Result;
+            }
+
+            uint32_t Level1Distance = GetEarliestDueTick(Level1[(Tick >> Level1Shift) & (Level1SlotCount - 1)]) - CurrentTick;
+            Result = (Level1Distance < Result) ? Level1Distance : Result;
+        }
+
+        if (Level0[Tick & (Level0SlotCount - 1)] != InvalidItem)
+        {
+            Result = Distance;
+        }
+    }
+
+    return Result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Globals.h"
+
+//Hierarchical timing wheel of item indices, every item is scheduled at most once at a time
+//Scheduling is O(1) and stepping costs one slot per tick plus the items due, items further away are moved to finer slots every 256 and 16384 ticks
+//Ticks wrap around, only differences between them are compared
+class TimingWheel
+{
+public:
+    TimingWheel(uint32_t InCapacity, uint32_t StartTick);
+    ~TimingWheel();
+
+    //Makes room for items up to NewCapacity - 1, scheduled items stay where they are
+    void Grow(uint32_t NewCapacity);
+
+    //DueTick has to be after the current tick
+    void Schedule(uint32_t Item, uint32_t DueTick);
+
+    //Advances the current tick by one, returns the first item due at it or InvalidItem, GetNext gives the following ones
+    //Items can be scheduled again while the list is walked, as long as the next item is read first
+    uint32_t Step();
+    uint32_t GetNext(uint32_t Item) const { return Links[Item]; }
+
+    uint32_t GetCurrentTick() const { return CurrentTick; }
+
+    //Ticks from the current tick to the earliest scheduled item, Limit + 1 if there is none within Limit ticks
+    uint32_t GetTicksUntilNextDue(uint32_t Limit) const;
+
+    static const uint32_t InvalidItem = 0xFFFFFFFF;
+
+private:
+    static const uint32_t Level0Bits = 8;
+    static const uint32_t Level1Bits = 6;
+    static const uint32_t Level2Bits = 6;
+    static const uint32_t Level0SlotCount = 1 << Level0Bits;
+    static const uint32_t Level1SlotCount = 1 << Level1Bits;
+    static const uint32_t Level2SlotCount = 1 << Level2Bits;
+    static const uint32_t Level1Shift = Level0Bits;
+    static const uint32_t Level2Shift = Level0Bits + Level1Bits;
+    //Items further away than this go to the farthest slot and are placed again when it's cascaded
+    static const uint32_t MaxDistance = (1 << (Level0Bits + Level1Bits + Level2Bits)) - 1;
+
+    void Insert(uint32_t Item, uint32_t DueTick);
+    void Cascade(uint32_t& SlotHead);
+    uint32_t GetEarliestDueTick(uint32_t SlotHead) const;
+
+    uint32_t Capacity;
+    uint32_t CurrentTick;
+
+    uint32_t* Links;
+    uint32_t* DueTicks;
+
+    //List heads of all levels in one allocation
+    uint32_t* Level0;
+    uint32_t* Level1;
+    uint32_t* Level2;
+};
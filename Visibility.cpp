@@ -0,0 +1,96 @@
+#include "Visibility.h"
+
+//Reason each event sets or clears, and whether it sets it
+static const uint32_t EventReasons[VisibilityEventCount] = { HiddenWindow, HiddenWindow, HiddenOccluded, HiddenOccluded, HiddenDisplayOff, HiddenDisplayOff };
+static const bool EventHides[VisibilityEventCount] = { false, true, false, true, false, true };
+
+//Names used in scripts, in event order
+static const char* const EventNames[VisibilityEventCount] = { "show", "hide", "expose", "occlude", "on", "off" };
+
+bool VisibilityTracker::HandleEvent(VisibilityEvent Event)
+{
+    if (Event >= VisibilityEventCount)
+    {
+        return false;
+    }
+
+    bool bWasVisible = IsVisible();
+    if (EventHides[Event])
+    {
+        HiddenReasons |= EventReasons[Event];
+    }
+    else
+    {
+        HiddenReasons &= ~EventReasons[Event];
+    }
+
+    return IsVisible() != bWasVisible;
+}
+
+//Advances Cursor past Name if the text there starts with it and the name isn't just the start of a longer word
+static bool ParseName(const char*& Cursor, const char* Name)
+{
+    const char* Text = Cursor;
+    while (*Name)
+    {
+        if (*Text++ != *Name++)
+        {
+            return false;
+        }
+    }
+
+    if (*Text != ',' && *Text != 0)
+    {
+        return false;
+    }
+
+    Cursor = Text;
+    return true;
+}
+
+bool ParseVisibilityScript(const char* Description, VisibilityScript& OutScript)
+{
+    OutScript.Count = 0;
+
+    const char* Cursor = Description;
+    while (*Cursor)
+    {
+        if (*Cursor < '0' || *Cursor > '9' || OutScript.Count >= VisibilityScript::MaxEvents)
+        {
+            return false;
+        }
+
+        uint32_t Frame = 0;
+        while (*Cursor >= '0' && *Cursor <= '9')
+        {
+            Frame = Frame * 10 + (uint32_t)(*Cursor - '0');
+            Cursor++;
+        }
+
+        if (*Cursor++ != ':' || (OutScript.Count > 0 && Frame < OutScript.Frames[OutScript.Count - 1]))
+        {
+            return false;
+        }
+
+        uint32_t Event = 0;
+        while (Event < VisibilityEventCount && !ParseName(Cursor, EventNames[Event]))
+        {
+            Event++;
+        }
+        if (Event == VisibilityEventCount)
+        {
+            return false;
+        }
+
+        OutScript.Frames[OutScript.Count] = Frame;
+        OutScript.Events[OutScript.Count] = (VisibilityEvent)Event;
+        OutScript.Count++;
+
+        if (*Cursor == ',')
+        {
+            Cursor++;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Globals.h"
+
+//Notifications about whether the screen saver's output can be seen, from window and power messages or from a script in the headless benchmark
+enum VisibilityEvent : uint32_t
+{
+    //Window shown, restored, or hidden or minimized, e.g. the preview pane of the settings dialog going away
+    VisibilityWindowShown,
+    VisibilityWindowHidden,
+    //Window uncloaked, or cloaked by the compositor, e.g. while another virtual desktop is shown
+    VisibilityWindowExposed,
+    VisibilityWindowOccluded,
+    //Displays powered on or dimmed, or powered off
+    VisibilityDisplayOn,
+    VisibilityDisplayOff,
+    VisibilityEventCount,
+};
+
+//Reasons for the output not being seen, a bit each, output is visible while none is set
+enum VisibilityHiddenReason : uint32_t
+{
+    HiddenWindow = 1 << 0,
+    HiddenOccluded = 1 << 1,
+    HiddenDisplayOff = 1 << 2,
+};
+
+//Folds the notifications into a visible or hidden state, every reason is tracked on its own so overlapping ones don't cancel each other out
+//Starts visible, has no constructor so it can live in globals of the CRT free build
+class VisibilityTracker
+{
+public:
+    //Returns true if the output turned visible or hidden with this event
+    bool HandleEvent(VisibilityEvent Event);
+
+    bool IsVisible() const { return HiddenReasons == 0; }
+    uint32_t GetHiddenReasons() const { return HiddenReasons; }
+
+private:
+    uint32_t HiddenReasons;
+};
+
+//Frames at which the headless benchmark feeds events to its tracker, standing in for the messages a window gets
+struct VisibilityScript
+{
+    static const uint32_t MaxEvents = 64;
+
+    uint32_t Frames[MaxEvents];
+    VisibilityEvent Events[MaxEvents];
+    uint32_t Count = 0;
+};
+
+//Parses comma separated "FRAME:EVENT" entries with frames in ascending order, events are show, hide, expose, occlude, on and off
+//Returns false if the description is malformed
+bool ParseVisibilityScript(const char* Description, VisibilityScript& OutScript);
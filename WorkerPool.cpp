@@ -0,0 +1,163 @@
+#include "WorkerPool.h"
+
+static uint64_t PackJobRange(uint32_t Begin, uint32_t End)
+{
+    return (uint64_t)Begin | ((uint64_t)End << 32);
+}
+
+WorkerPool::WorkerPool(uint32_t InWorkerCount)
+{
+    WorkerCount = (InWorkerCount < MaxWorkers) ? InWorkerCount : MaxWorkers;
+    NextWorkerIndex = 1;
+    ActiveWorkers = 0;
+    bShuttingDown = false;
+
+    //Participant 0 is the thread calling Run
+    Ranges = new JobRange[WorkerCount + 1];
+    for (uint32_t Index = 0; Index <= WorkerCount; Index++)
+    {
+        Ranges[Index].Range = 0;
+    }
+
+    WakeSemaphore = PlatformCreateSemaphore(MaxWorkers);
+    for (uint32_t Index = 0; Index < WorkerCount; Index++)
+    {
+        Threads[Index] = PlatformCreateThread(&WorkerPool::WorkerMain, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    bShuttingDown = true;
+    PlatformSignalSemaphore(WakeSemaphore, WorkerCount);
+
+    for (uint32_t Index = 0; Index < WorkerCount; Index++)
+    {
+        PlatformJoinThread(Threads[Index]);
+    }
+
+    PlatformDestroySemaphore(WakeSemaphore);
+    delete[] Ranges;
+}
+
+uint32_t WorkerPool::GetDefaultWorkerCount()
+{
+    uint32_t ProcessorCount = PlatformGetProcessorCount();
+    uint32_t Result = (ProcessorCount > 1) ? ProcessorCount - 1 : 0;
+
+    return (Result < MaxWorkers) ? Result : MaxWorkers;
+}
+
+uint32_t WorkerPool::WorkerMain(void* Parameter)
+{
+    WorkerPool* Pool = (WorkerPool*)Parameter;
+    uint32_t ParticipantIndex = Pool->NextWorkerIndex.fetch_add(1);
+
+    while (true)
+    {
+        PlatformWaitSemaphore(Pool->WakeSemaphore);
+        if (Pool->bShuttingDown.load())
+        {
+            break;
+        }
+
+        Pool->WorkOnBatch(ParticipantIndex);
+        Pool->ActiveWorkers.fetch_sub(1);
+    }
+
+    return 0;
+}
+
+bool WorkerPool::PopOwnJob(uint32_t ParticipantIndex, uint32_t& OutJobIndex)
+{
+    std::atomic<uint64_t>& Range = Ranges[ParticipantIndex].Range;
+    uint64_t Current = Range.load();
+
+    while (true)
+    {
+        uint32_t Begin = (uint32_t)Current;
+        uint32_t End = (uint32_t)(Current >> 32);
+        if (Begin >= End)
+        {
+            return false;
+        }
+
+        if (Range.compare_exchange_weak(Current, PackJobRange(Begin + 1, End)))
+        {
+            OutJobIndex = Begin;
+            return true;
+        }
+    }
+}
+
+bool WorkerPool::StealJob(uint32_t ThiefIndex, uint32_t& OutJobIndex)
+{
+    for (uint32_t Offset = 1; Offset <= WorkerCount; Offset++)
+    {
+        std::atomic<uint64_t>& Range = Ranges[(ThiefIndex + Offset) % (WorkerCount + 1)].Range;
+        uint64_t Current = Range.load();
+
+        while (true)
+        {
+            uint32_t Begin = (uint32_t)Current;
+            uint32_t End = (uint32_t)(Current >> 32);
+            if (Begin >= End)
+            {
+                break;
+            }
+
+            //Thieves take from the end, so owner keeps walking its range in order
+            if (Range.compare_exchange_weak(Current, PackJobRange(Begin, End - 1)))
+            {
+                OutJobIndex = End - 1;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void WorkerPool::WorkOnBatch(uint32_t ParticipantIndex)
+{
+    uint32_t JobIndex;
+    while (PopOwnJob(ParticipantIndex, JobIndex) || StealJob(ParticipantIndex, JobIndex))
+    {
+        CurrentFunction(CurrentContext, JobIndex);
+    }
+}
+
+void WorkerPool::Run(JobFunction Function, void* Context, uint32_t JobCount)
+{
+    if (WorkerCount == 0 || JobCount <= 1)
+    {
+        for (uint32_t JobIndex = 0; JobIndex < JobCount; JobIndex++)
+        {
+            Function(Context, JobIndex);
+        }
+
+        return;
+    }
+
+    CurrentFunction = Function;
+    CurrentContext = Context;
+
+    uint32_t ParticipantCount = WorkerCount + 1;
+    for (uint32_t Index = 0; Index < ParticipantCount; Index++)
+    {
+        uint32_t Begin = JobCount * Index / ParticipantCount;
+        uint32_t End = JobCount * (Index + 1) / ParticipantCount;
+        Ranges[Index].Range = PackJobRange(Begin, End);
+    }
+
+    //Every worker wakes for every batch and reports back, so none of them can still be inside this batch when the next one starts
+    ActiveWorkers = WorkerCount;
+    PlatformSignalSemaphore(WakeSemaphore, WorkerCount);
+
+    WorkOnBatch(0);
+
+    while (ActiveWorkers.load() != 0)
+    {
+        PlatformYieldThread();
+    }
+}
\ No newline at end of file
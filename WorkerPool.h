@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Globals.h"
+#include "Platform.h"
+
+#include <atomic>
+
+//Fixed set of threads running batches of independent jobs, the calling thread works on the batch as well
+//Every participant starts with a contiguous range of jobs and steals from the end of other ranges when its own runs out
+class WorkerPool
+{
+public:
+    typedef void (*JobFunction)(void* Context, uint32_t JobIndex);
+
+    WorkerPool(uint32_t InWorkerCount);
+    ~WorkerPool();
+
+    //Blocks until all jobs are done
+    void Run(JobFunction Function, void* Context, uint32_t JobCount);
+
+    uint32_t GetWorkerCount() const { return WorkerCount; }
+
+    //One worker per logical processor beside the calling thread
+    static uint32_t GetDefaultWorkerCount();
+
+    static const uint32_t MaxWorkers = 31;
+
+private:
+    //Begin in the low and End in the high 32 bits, so owner and thieves agree through a single compare exchange
+    struct JobRange
+    {
+        std::atomic<uint64_t> Range;
+        uint8_t Padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    static uint32_t WorkerMain(void* Parameter);
+    void WorkOnBatch(uint32_t ParticipantIndex);
+    bool PopOwnJob(uint32_t ParticipantIndex, uint32_t& OutJobIndex);
+    bool StealJob(uint32_t ThiefIndex, uint32_t& OutJobIndex);
+
+    uint32_t WorkerCount;
+    PlatformThread Threads[MaxWorkers];
+    PlatformSemaphore WakeSemaphore;
+
+    JobRange* Ranges;
+    JobFunction CurrentFunction = nullptr;
+    void* CurrentContext = nullptr;
+
+    std::atomic<uint32_t> NextWorkerIndex;
+    std::atomic<uint32_t> ActiveWorkers;
+    std::atomic<bool> bShuttingDown;
+};
\ No newline at end of file
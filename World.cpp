@@ -1,41 +1,459 @@
 #include "World.h"
 
-World::World(uint32_t InWorldWidth, uint32_t InWorldHeight, uint32_t MaxStarCount)
+//Lifetime shares are integer fractions of this, every threshold below is a whole number of twentieths
+static const uint32_t LifetimeShareOne = 20;
+
+//Share of the lifetime after which a star advances from given ExpandStage to the next one, 0.6 to 0.95
+static const uint32_t ExpandStageLifetimeShares[StarExpandStageCount] = { 12, 14, 16, 18, 19 };
+static const uint8_t LastExpandStage = StarExpandStageCount;
+
+//Share of the lifetime after which a dimmed star turns bright, 0.1
+static const uint32_t BrightLifetimeShare = 2;
+
+//Random fractions are drawn as integers in [0, RandomFractionOne), the same 23 bits FillFloats makes a float in [0, 1) of
+static const uint32_t RandomFractionBits = 23;
+static const uint32_t RandomFractionOne = 1u << RandomFractionBits;
+
+//One in this many stars expands and twinkles
+static const uint32_t StarExpansionDivisor = 10;
+//Most stars spawned per update is a tenth of the budget, if none are rolled half of that spawn
+static const uint32_t MaxSpawnDivisor = 10;
+
+static uint8_t* CarveArray(uint8_t*& Memory, uint32_t Size)
+{
+    uint8_t* Result = Memory;
+    //Keep every array on its own cache line
+    Memory += (Size + 63) & ~63u;
+
+    return Result;
+}
+
+//Stars are spawned in chunks of this many, every random field of a chunk is drawn with a single call
+static const uint32_t SpawnChunkSize = 64;
+
+//Random values for one chunk of spawned stars, a field per array in the order they are drawn
+struct World::SpawnRolls
+{
+    uint32_t XPos[SpawnChunkSize];
+    uint32_t YPos[SpawnChunkSize];
+    uint32_t Size[SpawnChunkSize];
+    uint32_t Progress[SpawnChunkSize];
+    uint32_t Lifetime[SpawnChunkSize];
+};
+
+static uint32_t GetLifetimeShareTicks(uint32_t LifetimeTicks, uint32_t Share)
+{
+    return LifetimeTicks * Share / LifetimeShareOne;
+}
+
+//Rounds to the 24 significant bits of a float, to nearest with ties to even
+//Lifetimes used to be float products rounded this way, matching them keeps every star's timing and recorded hash files as they were
+static uint32_t RoundToFloatPrecision(uint32_t Value)
+{
+    uint32_t Shift = 0;
+    while ((Value >> Shift) >= (1u << 24))
+    {
+        Shift++;
+    }
+    if (Shift == 0)
+    {
+        return Value;
+    }
+
+    uint32_t RoundUp = (1u << (Shift - 1)) - 1 + ((Value >> Shift) & 1);
+    return ((Value + RoundUp) >> Shift) << Shift;
+}
+
+World::World(uint32_t InWorldWidth, uint32_t InWorldHeight, uint32_t MaxStarCount, uint64_t RandomSeed)
+    : Events(MaxStarCount, 0)
 {
     WorldWidth = InWorldWidth;
     WorldHeight = InWorldHeight;
     StarsMax = MaxStarCount;
+    Random.Seed(RandomSeed);
 
-    ActiveStarsArray = new Star[StarsMax];
+    GrowStarCapacity(MaxStarCount);
+}
+
+void World::GrowStarCapacity(uint32_t NewCapacity)
+{
+    uint32_t UIntArraySize = (NewCapacity * sizeof(uint32_t) + 63) & ~63u;
+    uint32_t ByteArraySize = (NewCapacity + 63) & ~63u;
+    uint32_t TotalSize = UIntArraySize * 5 + ByteArraySize * 4 + 63;
+
+    uint8_t* NewStarMemory = new uint8_t[TotalSize];
+    memset(NewStarMemory, 0, TotalSize);
+
+    StarArrays NewStars;
+    uint8_t* Memory = (uint8_t*)(((uintptr_t)NewStarMemory + 63) & ~(uintptr_t)63);
+    NewStars.SpawnTick = (uint32_t*)CarveArray(Memory, UIntArraySize);
+    NewStars.LifetimeTicks = (uint32_t*)CarveArray(Memory, UIntArraySize);
+    NewStars.XPos = (uint32_t*)CarveArray(Memory, UIntArraySize);
+    NewStars.YPos = (uint32_t*)CarveArray(Memory, UIntArraySize);
+    NewStars.Size = (uint32_t*)CarveArray(Memory, UIntArraySize);
+    NewStars.Shape = CarveArray(Memory, ByteArraySize);
+    NewStars.ExpandStage = CarveArray(Memory, ByteArraySize);
+    NewStars.bShouldProgress = CarveArray(Memory, ByteArraySize);
+    NewStars.Phase = CarveArray(Memory, ByteArraySize);
+
+    //New slots go below the free ones there are, so those are spawned into first, and the first stars of a new world spawn into the lowest slots
+    uint32_t* NewFreeSlots = new uint32_t[NewCapacity];
+    uint32_t NewFreeSlotCount = 0;
+    for (uint32_t Index = NewCapacity; Index > StarCapacity; Index--)
+    {
+        NewFreeSlots[NewFreeSlotCount++] = Index - 1;
+    }
+
+    if (StarMemory)
+    {
+        memcpy(NewStars.SpawnTick, Stars.SpawnTick, StarCapacity * sizeof(uint32_t));
+        memcpy(NewStars.LifetimeTicks, Stars.LifetimeTicks, StarCapacity * sizeof(uint32_t));
+        memcpy(NewStars.XPos, Stars.XPos, StarCapacity * sizeof(uint32_t));
+        memcpy(NewStars.YPos, Stars.YPos, StarCapacity * sizeof(uint32_t));
+        memcpy(NewStars.Size, Stars.Size, StarCapacity * sizeof(uint32_t));
+        memcpy(NewStars.Shape, Stars.Shape, StarCapacity);
+        memcpy(NewStars.ExpandStage, Stars.ExpandStage, StarCapacity);
+        memcpy(NewStars.bShouldProgress, Stars.bShouldProgress, StarCapacity);
+        memcpy(NewStars.Phase, Stars.Phase, StarCapacity);
+        memcpy(NewFreeSlots + NewFreeSlotCount, FreeSlots, FreeSlotCount * sizeof(uint32_t));
+        NewFreeSlotCount += FreeSlotCount;
+
+        delete[] StarMemory;
+        delete[] FreeSlots;
+        Events.Grow(NewCapacity);
+    }
+
+    StarMemory = NewStarMemory;
+    Stars = NewStars;
+    FreeSlots = NewFreeSlots;
+    FreeSlotCount = NewFreeSlotCount;
+    StarCapacity = NewCapacity;
 }
 
 World::~World()
 {
-    if (ActiveStarsArray)
+    if (StarMemory)
+    {
+        delete[] StarMemory;
+    }
+
+    delete[] FreeSlots;
+}
+
+void World::SetStarSizeMax(uint32_t InSizeMax)
+{
+    SizeMax = InSizeMax;
+}
+
+void World::SetLifetimeRange(uint32_t MinMilliseconds, uint32_t MaxSeconds)
+{
+    MaxLifetimeSeconds = (MaxSeconds < 1) ? 1 : (MaxSeconds > MaxLifetimeSecondsLimit) ? MaxLifetimeSecondsLimit : MaxSeconds;
+    MinLifetimeTicks = ((MinMilliseconds < MaxLifetimeSeconds * 1000) ? MinMilliseconds : MaxLifetimeSeconds * 1000) * TicksPerSecond / 1000;
+}
+
+uint32_t World::Resize(uint32_t NewWorldWidth, uint32_t NewWorldHeight)
+{
+    WorldWidth = NewWorldWidth;
+    WorldHeight = NewWorldHeight;
+    DriftPosition %= WorldWidth * TicksPerSecond;
+
+    //Dropped stars aren't drawn anymore but keep their slot until their scheduled event comes up, the timing wheel can't unschedule
+    uint32_t DroppedCount = 0;
+    for (uint32_t Index = 0; Index < StarCapacity; Index++)
+    {
+        //Same range spawning draws positions from
+        if (Stars.Phase[Index] != StarDead && (Stars.XPos[Index] >= WorldWidth - 1 || Stars.YPos[Index] >= WorldHeight - 1))
+        {
+            Stars.Phase[Index] = StarDead;
+            DroppedCount++;
+        }
+    }
+
+    return DroppedCount;
+}
+
+void World::SetStarBudget(uint32_t InStarBudget)
+{
+    StarsMax = (InStarBudget < MaxStarCount) ? InStarBudget : MaxStarCount;
+    if (StarsMax > StarCapacity)
     {
-        delete[] ActiveStarsArray;
+        GrowStarCapacity(StarsMax);
     }
 }
 
+void World::SetSpawnRateDivisor(uint32_t InSpawnRateDivisor)
+{
+    SpawnRateDivisor = (InSpawnRateDivisor > 0) ? InSpawnRateDivisor : 1;
+}
+
+uint32_t World::GetScaledStarSizeMax(uint32_t SizeMax, uint32_t RenderScale)
+{
+    uint32_t Result = (SizeMax + RenderScale / 2) / RenderScale;
+
+    return (Result > 0) ? Result : 1;
+}
+
+void World::SetDriftSpeed(int32_t PixelsPerSecond)
+{
+    DriftSpeed = (PixelsPerSecond < -MaxDriftSpeed) ? -MaxDriftSpeed : (PixelsPerSecond > MaxDriftSpeed) ? MaxDriftSpeed : PixelsPerSecond;
+}
+
+int32_t World::GetScaledDriftSpeed(int32_t Speed, uint32_t RenderScale)
+{
+    int32_t Magnitude = (Speed < 0) ? -Speed : Speed;
+    int32_t Result = (Magnitude + (int32_t)RenderScale / 2) / (int32_t)RenderScale;
+    Result = (Result > 0 || Magnitude == 0) ? Result : 1;
+
+    return (Speed < 0) ? -Result : Result;
+}
+
+void World::AdvanceDrift(uint32_t ElapsedTicks)
+{
+    if (DriftSpeed == 0)
+    {
+        return;
+    }
+
+    //Whole turns of the sky are dropped first, the step is then below MaxDriftSpeed turns and fits 32 bits
+    uint32_t Period = WorldWidth * TicksPerSecond;
+    uint32_t Step = (ElapsedTicks % Period) * (uint32_t)((DriftSpeed < 0) ? -DriftSpeed : DriftSpeed) % Period;
+    DriftPosition = (DriftSpeed > 0) ? (DriftPosition + Step) % Period : (DriftPosition + Period - Step) % Period;
+}
+
+size_t World::GetMemoryEstimate(uint32_t MaxStarCount)
+{
+    //Star arrays and free slots, plus links, due ticks and slots of the timing wheel
+    size_t StarBytes = (size_t)MaxStarCount * (sizeof(uint32_t) * 6 + 4) + 64 * 10;
+    size_t EventBytes = (size_t)MaxStarCount * sizeof(uint32_t) * 2 + 1024 * sizeof(uint32_t);
+
+    return StarBytes + EventBytes;
+}
+
+void World::InitializeStar(uint32_t Index, uint32_t SpawnTick, const SpawnRolls& Rolls, uint32_t RollIndex)
+{
+    Stars.XPos[Index] = Rolls.XPos[RollIndex];
+    Stars.YPos[Index] = Rolls.YPos[RollIndex];
+
+    uint32_t Size = Rolls.Size[RollIndex];
+    if (Size == 0)
+    {
+        Size = 1;
+    }
+    Stars.Size[Index] = Size;
+
+    bool bShouldProgress = Rolls.Progress[RollIndex] * StarExpansionDivisor < RandomFractionOne;
+    Stars.bShouldProgress[Index] = bShouldProgress;
+    Stars.Shape[Index] = StarShape::Square;
+
+    //Ticks per second is a power of two, so only the product with the lifetime in seconds is rounded
+    uint32_t LifetimeTicks = (uint32_t)(((uint64_t)RoundToFloatPrecision(Rolls.Lifetime[RollIndex] * MaxLifetimeSeconds) * TicksPerSecond) >> RandomFractionBits);
+    if (LifetimeTicks < MinLifetimeTicks)
+    {
+        LifetimeTicks = MinLifetimeTicks;
+    }
+
+    //ExpandStage is intentionally kept from the previous star in this slot
+    Stars.LifetimeTicks[Index] = LifetimeTicks;
+    Stars.SpawnTick[Index] = SpawnTick;
+    Stars.Phase[Index] = StarDim;
+
+    uint32_t EventTick = GetNextEventTick(Index);
+    Events.Schedule(Index, ((int32_t)(EventTick - SpawnTick) > 0) ? EventTick : SpawnTick + 1);
+}
+
+void World::AdvanceExpandStage(uint32_t Index)
+{
+    uint8_t ExpandStage = ++Stars.ExpandStage[Index];
+    Stars.Size[Index] = GetExpandedStarSize(Stars.Size[Index], ExpandStage);
+    Stars.Shape[Index] = GetExpandedStarShape((StarShape)Stars.Shape[Index], ExpandStage);
+}
+
+Color World::GetStarColor(uint32_t Index) const
+{
+    switch (Stars.Phase[Index])
+    {
+        case StarDim:
+        {
+            return { 155, 155, 155 };
+        }
+
+        case StarBright:
+        {
+            return { 255,255,255 };
+        }
+    }
+
+    return { 0,0,0 };
+}
+
+uint32_t World::GetNextEventTick(uint32_t Index) const
+{
+    uint32_t LifetimeTicks = Stars.LifetimeTicks[Index];
+    uint32_t EventTicks = LifetimeTicks;
+
+    if (Stars.Phase[Index] == StarDim)
+    {
+        uint32_t BrightTicks = GetLifetimeShareTicks(LifetimeTicks, BrightLifetimeShare);
+        EventTicks = (BrightTicks < EventTicks) ? BrightTicks : EventTicks;
+    }
+
+    uint8_t ExpandStage = Stars.ExpandStage[Index];
+    if (Stars.bShouldProgress[Index] && ExpandStage < LastExpandStage)
+    {
+        uint32_t ExpandTicks = GetLifetimeShareTicks(LifetimeTicks, ExpandStageLifetimeShares[ExpandStage]);
+        EventTicks = (ExpandTicks < EventTicks) ? ExpandTicks : EventTicks;
+    }
+
+    return Stars.SpawnTick[Index] + EventTicks;
+}
+
+void World::HandleStarEvent(uint32_t Index)
+{
+    uint32_t CurrentTick = Events.GetCurrentTick();
+    uint32_t ElapsedTicks = CurrentTick - Stars.SpawnTick[Index];
+    uint32_t LifetimeTicks = Stars.LifetimeTicks[Index];
+
+    //Slot can be spawned into from the next update on, stars dropped by Resize are already dead and only give their slot back
+    if (ElapsedTicks >= LifetimeTicks || Stars.Phase[Index] == StarDead)
+    {
+        Stars.Phase[Index] = StarDead;
+        FreeSlots[FreeSlotCount++] = Index;
+        ActiveStarsCount--;
+        return;
+    }
+
+    if (Stars.Phase[Index] == StarDim && ElapsedTicks >= GetLifetimeShareTicks(LifetimeTicks, BrightLifetimeShare))
+    {
+        Stars.Phase[Index] = StarBright;
+    }
+
+    uint8_t ExpandStage = Stars.ExpandStage[Index];
+    if (Stars.bShouldProgress[Index] && ExpandStage < LastExpandStage && ElapsedTicks >= GetLifetimeShareTicks(LifetimeTicks, ExpandStageLifetimeShares[ExpandStage]))
+    {
+        AdvanceExpandStage(Index);
+    }
+
+    //Stages advance one per event, a stage carried over from the previous star in this slot may already be due again
+    uint32_t EventTick = GetNextEventTick(Index);
+    Events.Schedule(Index, ((int32_t)(EventTick - CurrentTick) > 0) ? EventTick : CurrentTick + 1);
+}
+
+void World::SpawnStars(uint32_t StarsToAdd, uint32_t SpawnTick)
+{
+    StarsToAdd = (StarsToAdd < FreeSlotCount) ? StarsToAdd : FreeSlotCount;
+
+    SpawnRolls Rolls;
+    while (StarsToAdd > 0)
+    {
+        uint32_t ChunkSize = (StarsToAdd < SpawnChunkSize) ? StarsToAdd : SpawnChunkSize;
+
+        //Positions and sizes as bounded integers, same ranges as scaling a float in [0, 1) and truncating
+        Random.FillBounded(Rolls.XPos, ChunkSize, WorldWidth - 1);
+        Random.FillBounded(Rolls.YPos, ChunkSize, WorldHeight - 1);
+        Random.FillBounded(Rolls.Size, ChunkSize, SizeMax);
+        Random.FillBounded(Rolls.Progress, ChunkSize, RandomFractionOne);
+        Random.FillBounded(Rolls.Lifetime, ChunkSize, RandomFractionOne);
+
+        for (uint32_t RollIndex = 0; RollIndex < ChunkSize; RollIndex++)
+        {
+            InitializeStar(FreeSlots[--FreeSlotCount], SpawnTick, Rolls, RollIndex);
+        }
+
+        ActiveStarsCount += ChunkSize;
+        StarsToAdd -= ChunkSize;
+    }
+}
+
+void World::Render(CPURenderer& Renderer) const
+{
+    //Sky stays wrapped once it has moved, stopping the drift leaves the seam somewhere on screen
+    Renderer.SetColumnWrap(DriftSpeed != 0 || DriftPosition != 0);
+    Renderer.SetScrollOrigin(DriftPosition / TicksPerSecond);
+
+    for (uint32_t Index = 0; Index < StarCapacity; Index++)
+    {
+        if (Stars.Phase[Index] != StarDead)
+        {
+            Renderer.DrawStar(Stars.XPos[Index], Stars.YPos[Index], Stars.Size[Index], (StarShape)Stars.Shape[Index], GetStarColor(Index));
+        }
+    }
+
+    Renderer.FlushStars();
+}
+
+uint32_t World::GetUpdatesWithoutVisualChange(float DeltaTime, uint32_t MaxUpdates) const
+{
+    //Free slots get a star spawned into them by the next update
+    if (ActiveStarsCount < StarsMax || DeltaTime <= 0.0f)
+    {
+        return 0;
+    }
+
+    //Events past the last update that could be skipped don't matter
+    float TicksPerUpdate = DeltaTime * (float)TicksPerSecond;
+    float SearchTicks = TicksPerUpdate * (float)(MaxUpdates + 2);
+    uint32_t TicksToEvent = Events.GetTicksUntilNextDue((SearchTicks < 1048576.0f) ? (uint32_t)SearchTicks : 1048576);
+
+    //Scrolling by a whole pixel changes the image as well
+    if (DriftSpeed != 0)
+    {
+        uint32_t PixelFraction = DriftPosition % TicksPerSecond;
+        uint32_t DistanceToNextPixel = (DriftSpeed > 0) ? TicksPerSecond - PixelFraction : PixelFraction + 1;
+        uint32_t Speed = (uint32_t)((DriftSpeed < 0) ? -DriftSpeed : DriftSpeed);
+        uint32_t TicksToScroll = (DistanceToNextPixel + Speed - 1) / Speed;
+        TicksToEvent = (TicksToScroll < TicksToEvent) ? TicksToScroll : TicksToEvent;
+    }
+
+    //The clock reaches the event in update ceil(Updates) when computed exactly, half an update is kept as margin for rounding in the tick fraction
+    //Being early only costs rendering an unchanged frame, being late would drop a change
+    float Updates = ((float)TicksToEvent - TickFraction) / TicksPerUpdate - 0.5f;
+    if (Updates < 2.0f)
+    {
+        return 0;
+    }
+
+    uint32_t UnchangedUpdates = (Updates < (float)MaxUpdates + 1.0f) ? (uint32_t)Updates - 1 : MaxUpdates;
+    return UnchangedUpdates;
+}
+
 void World::Tick(float DeltaTime, CPURenderer& RenderBuffer)
+{
+    Update(DeltaTime);
+    Render(RenderBuffer);
+}
+
+void World::CatchUp(float Seconds)
+{
+    Update((Seconds < (float)MaxLifetimeSeconds) ? Seconds : (float)MaxLifetimeSeconds);
+}
+
+void World::Update(float DeltaTime)
 {
     //Determine how many star we want to add this frame
     uint32_t StarsToAdd = 0;
-    uint32_t StarCountBelowMax = StarsMax - ActiveStarsCount;
+    //Budget may have been lowered below the stars still alive
+    uint32_t StarCountBelowMax = (ActiveStarsCount < StarsMax) ? StarsMax - ActiveStarsCount : 0;
     if (StarCountBelowMax > 0)
     {
-        StarsToAdd = (uint32_t)(RandomFloat() * StarsMax * MaxPercentSpawnRate);
+        uint32_t SpawnRoll;
+        Random.FillBounded(&SpawnRoll, 1, RandomFractionOne);
+        StarsToAdd = (uint32_t)(((uint64_t)SpawnRoll * StarsMax) >> RandomFractionBits) / MaxSpawnDivisor;
         if (StarsToAdd == 0)
         {
-            StarsToAdd = (uint32_t)((float)StarsMax * (MaxPercentSpawnRate * 0.5f));
+            StarsToAdd = StarsMax / (MaxSpawnDivisor * 2);
 
-            //Ensure we add something even if StarsMax * MaxPercentSpawnRate * 0.5 would result in 0
+            //Ensure we add something even if a twentieth of StarsMax would result in 0
             if (StarsToAdd == 0)
             {
                 StarsToAdd = 1;
             }
         }
 
+        if (SpawnRateDivisor > 1)
+        {
+            StarsToAdd = (StarsToAdd >= SpawnRateDivisor) ? StarsToAdd / SpawnRateDivisor : 1;
+        }
+
         //Clamp
         if (StarsToAdd > StarCountBelowMax)
         {
@@ -43,32 +461,24 @@ void World::Tick(float DeltaTime, CPURenderer& RenderBuffer)
         }
     }
 
-    //Splitting tick and render could potentially result in faster execution and allow for much easier vectorization, but that seems a bit overkill for the context
-    //Same for adding of new stars it may be faster to handle it as a separate loop to avoid branching
-    //In any case it would require profiling to see at what point it would be faster
-    for (uint32_t Index = 0; Index < StarsMax; Index++)
-    {
-        Star& ActiveStar = ActiveStarsArray[Index];
+    TickFraction += DeltaTime * (float)TicksPerSecond;
+    uint32_t ElapsedTicks = (uint32_t)TickFraction;
+    TickFraction -= (float)ElapsedTicks;
+    uint32_t UpdateTick = Events.GetCurrentTick() + ElapsedTicks;
+    AdvanceDrift(ElapsedTicks);
 
-        //If star is "alive" tick and render
-        if (ActiveStar.RemainingLifetime > 0.0f)
-        {
-            ActiveStar.Tick(DeltaTime);
-            ActiveStar.Render(RenderBuffer);
+    //Stars spawned by this update start aging at its end, so only slots which were dead before it are reused and all their events come after UpdateTick
+    SpawnStars(StarsToAdd, UpdateTick);
 
-            if (ActiveStar.RemainingLifetime <= 0.0f)
-            {
-                ActiveStarsCount--;
-            }
-        }
-        //If star is not "alive" and we have more stars we need to add this frame do it here, just reinitialize the star which result in randomizing it's values
-        else if (StarsToAdd > 0)
+    //Only ticks and stars with events due are visited, the cost doesn't depend on the number of stars
+    while (Events.GetCurrentTick() != UpdateTick)
+    {
+        uint32_t Index = Events.Step();
+        while (Index != TimingWheel::InvalidItem)
         {
-            ActiveStar.Initialize(WorldWidth, WorldHeight, SizeMax, MaxLifetime);
-            ActiveStar.Render(RenderBuffer);
-
-            ActiveStarsCount++;
-            StarsToAdd--;
+            uint32_t Next = Events.GetNext(Index);
+            HandleStarEvent(Index);
+            Index = Next;
         }
     }
 }
\ No newline at end of file
@@ -1,30 +1,138 @@
 #pragma once
 
 #include "CPURenderer.h"
+#include "StarAtlas.h"
+#include "TimingWheel.h"
+#include "BatchRandomStream.h"
 
 #include <stdint.h>
 
+enum StarPhase : uint8_t
+{
+	StarDead,
+	//Drawn dimmed for the first tenth of its lifetime
+	StarDim,
+	StarBright,
+};
+
+//Star state kept as one array per field, a star is only touched when it spawns, when one of its scheduled events is due and when rendered
+struct StarArrays
+{
+	uint32_t* SpawnTick; //World tick the star spawned at
+	uint32_t* LifetimeTicks;
+	uint32_t* XPos;
+	uint32_t* YPos;
+	uint32_t* Size;
+	uint8_t* Shape;
+	uint8_t* ExpandStage;
+	uint8_t* bShouldProgress; //Should star expand and twinkle
+	uint8_t* Phase; //StarPhase, dead slots are kept on the free slot stack
+};
+
 class World
 {
 public:
-	World(uint32_t InWorldWidth, uint32_t InWorldHeight, uint32_t MaxStarCount);
+	//Each world draws from its own random stream, so worlds can tick on separate threads
+	//Star budget starts at MaxStarCount, the star arrays are sized for it and grow if it's raised later
+	World(uint32_t InWorldWidth, uint32_t InWorldHeight, uint32_t MaxStarCount, uint64_t RandomSeed);
 	~World();
 
+	//Update followed by Render
 	void Tick(float DeltaTime, CPURenderer& RenderBuffer);
+	void Update(float DeltaTime);
+	//Single update covering Seconds in which nothing was shown, capped at the longest star lifetime since every star is replaced after that anyway
+	void CatchUp(float Seconds);
+	void Render(CPURenderer& Renderer) const;
+	//Number of following Update calls with DeltaTime which leave the rendered image unchanged, at most MaxUpdates
+	//Never overestimates, so rendering can be skipped for that many updates without output differing from rendering every one
+	uint32_t GetUpdatesWithoutVisualChange(float DeltaTime, uint32_t MaxUpdates) const;
+	//Upper bound for initial star size, only affects stars spawned afterwards
+	void SetStarSizeMax(uint32_t InSizeMax);
+	//Lifetimes are drawn up to MaxSeconds and raised to at least MinMilliseconds, capped at MaxSeconds, only affects stars spawned afterwards
+	void SetLifetimeRange(uint32_t MinMilliseconds, uint32_t MaxSeconds);
+	//Stars inside the new size stay where they are and the rest are dropped, stars spawned afterwards use the new size
+	//Star count is kept, returns the number of stars dropped
+	uint32_t Resize(uint32_t NewWorldWidth, uint32_t NewWorldHeight);
+	//Number of stars kept alive from now on, clamped to MaxStarCount, the star arrays grow when it's above what they hold
+	//Lowering it only stops spawning until enough stars died of old age, so nothing disappears at once
+	void SetStarBudget(uint32_t InStarBudget);
+	uint32_t GetStarBudget() const { return StarsMax; }
+	//Stars spawned per update are divided by this, at least one still spawns while below the budget
+	void SetSpawnRateDivisor(uint32_t InSpawnRateDivisor);
+	//Pans the sky left by PixelsPerSecond, right if negative, clamped to MaxDriftSpeed either way
+	//Stars keep their place in the sky, which wraps around horizontally, Render scrolls the renderer instead of moving them
+	void SetDriftSpeed(int32_t PixelsPerSecond);
+
+	//Initial size bound for a world rendered at RenderScale which keeps stars about as big on screen as SizeMax at full resolution, at least 1
+	static uint32_t GetScaledStarSizeMax(uint32_t SizeMax, uint32_t RenderScale);
+	//Drift speed in pixels of a world rendered at RenderScale which moves the sky as fast on screen as Speed at full resolution, never rounded to 0
+	static int32_t GetScaledDriftSpeed(int32_t Speed, uint32_t RenderScale);
+
+	//Upper bound of what a world allocates over its lifetime, for sizing arenas
+	static size_t GetMemoryEstimate(uint32_t MaxStarCount);
 
 	static const uint32_t MinStarCount = 100;
 	static const uint32_t DefaultStarCount = 300;
-	static const uint32_t MaxStarCount = 500;
+	//Timing wheel and star arrays take any count, this keeps the settings dialog's scroll bar within its 16 bit thumb positions
+	static const uint32_t MaxStarCount = 50000;
+
+	static const uint32_t DefaultMinLifetimeMilliseconds = 1250;
+	static const uint32_t DefaultMaxLifetimeSeconds = 5;
+	//Keeps lifetimes in ticks and their scheduled events far within 32 bits
+	static const uint32_t MaxLifetimeSecondsLimit = 60;
+
+	//World time is counted in ticks, a power of two so scaling DeltaTime to ticks is exact
+	static const uint32_t TicksPerSecond = 1024;
+	//Fastest drift in pixels per second, keeps drift steps within 32 bits
+	static const int32_t MaxDriftSpeed = 256;
 
 private:
+	struct SpawnRolls;
+
+	void InitializeStar(uint32_t Index, uint32_t SpawnTick, const SpawnRolls& Rolls, uint32_t RollIndex);
+	void AdvanceExpandStage(uint32_t Index);
+	Color GetStarColor(uint32_t Index) const;
+
+	//Tick at which the star's next color change, expand stage or death is due
+	uint32_t GetNextEventTick(uint32_t Index) const;
+	//Applies the star's events due at the current tick and schedules the next one
+	void HandleStarEvent(uint32_t Index);
+	void SpawnStars(uint32_t StarsToAdd, uint32_t SpawnTick);
+	//Moves every star to arrays of NewCapacity slots, which has to be more than there are
+	void GrowStarCapacity(uint32_t NewCapacity);
+	//Moves the sky by the drift of ElapsedTicks
+	void AdvanceDrift(uint32_t ElapsedTicks);
+
 	uint32_t WorldWidth;
 	uint32_t WorldHeight;
 
+	//Slots in the star arrays, StarsMax is the budget of live stars within them
+	uint32_t StarCapacity = 0;
 	uint32_t StarsMax = DefaultStarCount;
-	float MaxPercentSpawnRate = 0.1f;
-	float MaxLifetime = 5.0f;
-	uint32_t SizeMax = 5;
+	//Lifetimes are drawn up to this, star times are kept in integer ticks
+	uint32_t MaxLifetimeSeconds = DefaultMaxLifetimeSeconds;
+	//Shorter lifetimes rolled are raised to this
+	uint32_t MinLifetimeTicks = DefaultMinLifetimeMilliseconds * TicksPerSecond / 1000;
+	uint32_t SizeMax = DefaultStarSizeMax;
+	uint32_t SpawnRateDivisor = 1;
+
+	BatchRandomStream Random;
 
 	uint32_t ActiveStarsCount = 0;
-	Star* ActiveStarsArray = nullptr;
+	uint8_t* StarMemory = nullptr;
+	StarArrays Stars = {};
+
+	//Dead slots, the top one is spawned into first
+	uint32_t* FreeSlots = nullptr;
+	uint32_t FreeSlotCount = 0;
+
+	//Every live star has exactly one event scheduled, its current tick is the world clock
+	TimingWheel Events;
+	//Part of a tick left over from previous updates
+	float TickFraction = 0.0f;
+
+	//Sky column at the left edge of the screen in 1/TicksPerSecond pixels, a tick of drift moves it by DriftSpeed exactly
+	//Kept below WorldWidth * TicksPerSecond, the sky wraps around there
+	int32_t DriftSpeed = 0;
+	uint32_t DriftPosition = 0;
 };
\ No newline at end of file